@@ -0,0 +1,50 @@
+#ifndef SPL_ARENA_H
+#define SPL_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for objects that all die together. Memory is handed out
+// from 64 KiB blocks and only returned when the arena itself is destroyed,
+// so objects placed in it must be trivially destructible.
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&) = default;
+  Arena &operator=(Arena &&) = default;
+
+  void *allocate(std::size_t size, std::size_t alignment);
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena objects are never destroyed");
+    return new (this->allocate(sizeof(T), alignof(T)))
+        T{std::forward<Args>(args)...};
+  }
+
+  template <typename T> T *allocate_array(std::size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena objects are never destroyed");
+    if (count == 0) {
+      return nullptr;
+    }
+    return static_cast<T *>(this->allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  std::size_t block_count() const { return this->m_Blocks.size(); }
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> m_Blocks;
+  char *m_Cursor = nullptr;
+  char *m_End = nullptr;
+};
+
+#endif
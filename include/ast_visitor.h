@@ -0,0 +1,119 @@
+#ifndef SPL_AST_VISITOR_H
+#define SPL_AST_VISITOR_H
+
+#include <syntax_tree.h>
+
+// Typed dispatch over syntax tree nodes. A pass derives from
+// AstVisitor<Pass, Result> and defines the visitX members for the node
+// kinds it cares about; visit() switches on the node's grammar symbol and
+// calls the derived member directly, without virtual calls or string
+// compares. Any kind the pass leaves out falls back to visitChildren(),
+// which visits every child in order and returns a default Result; list
+// kinds fall back to visitList(), which walks the list without recursing
+// into its tail.
+template <typename Derived, typename Result = void>
+class AstVisitor
+{
+public:
+  Result visit(SyntaxTreeNode *node)
+  {
+    Derived &self = static_cast<Derived &>(*this);
+    switch (node->getSymbolId())
+    {
+    case GrammarSymbol::PROG:
+      return self.visitProg(node);
+    case GrammarSymbol::GLOBVARS:
+      return self.visitGlobVars(node);
+    case GrammarSymbol::ALGO:
+      return self.visitAlgo(node);
+    case GrammarSymbol::INSTRUC:
+      return self.visitInstruc(node);
+    case GrammarSymbol::COMMAND:
+      return self.visitCommand(node);
+    case GrammarSymbol::ATOMIC:
+      return self.visitAtomic(node);
+    case GrammarSymbol::ASSIGN:
+      return self.visitAssign(node);
+    case GrammarSymbol::CALL:
+      return self.visitCall(node);
+    case GrammarSymbol::BRANCH:
+      return self.visitBranch(node);
+    case GrammarSymbol::TERM:
+      return self.visitTerm(node);
+    case GrammarSymbol::OP:
+      return self.visitOp(node);
+    case GrammarSymbol::ARG:
+      return self.visitArg(node);
+    case GrammarSymbol::COND:
+      return self.visitCond(node);
+    case GrammarSymbol::SIMPLE:
+      return self.visitSimple(node);
+    case GrammarSymbol::COMPOSIT:
+      return self.visitComposit(node);
+    case GrammarSymbol::FUNCTIONS:
+      return self.visitFunctions(node);
+    case GrammarSymbol::DECL:
+      return self.visitDecl(node);
+    case GrammarSymbol::HEADER:
+      return self.visitHeader(node);
+    case GrammarSymbol::BODY:
+      return self.visitBody(node);
+    case GrammarSymbol::LOCVARS:
+      return self.visitLocVars(node);
+    default:
+      return self.visitChildren(node);
+    }
+  }
+
+protected:
+  Result visitChildren(SyntaxTreeNode *node)
+  {
+    for (SyntaxTreeNode *child : node->getChildren())
+    {
+      this->visit(child);
+    }
+    return Result();
+  }
+
+  Result visitList(SyntaxTreeNode *node)
+  {
+    for (SyntaxTreeNode *link : SyntaxTreeList(node))
+    {
+      SyntaxTreeChildren children = link->getChildren();
+      for (std::size_t i = 0; i + 1 < children.size(); i++)
+      {
+        this->visit(children[i]);
+      }
+    }
+    return Result();
+  }
+
+  Result visitProg(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitGlobVars(SyntaxTreeNode *node) { return this->visitList(node); }
+  Result visitAlgo(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitInstruc(SyntaxTreeNode *node) { return this->visitList(node); }
+  Result visitCommand(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitAtomic(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitAssign(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitCall(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitBranch(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitTerm(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitOp(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitArg(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitCond(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitSimple(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitComposit(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitFunctions(SyntaxTreeNode *node) { return this->visitList(node); }
+  Result visitDecl(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitHeader(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitBody(SyntaxTreeNode *node) { return this->fallback(node); }
+  Result visitLocVars(SyntaxTreeNode *node) { return this->fallback(node); }
+
+private:
+  Result fallback(SyntaxTreeNode *node)
+  {
+    return static_cast<Derived &>(*this).visitChildren(node);
+  }
+};
+
+#endif // SPL_AST_VISITOR_H
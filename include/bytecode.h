@@ -0,0 +1,106 @@
+#ifndef SPL_BYTECODE_H
+#define SPL_BYTECODE_H
+
+#include <cstdint>
+#include <imc.h>
+#include <interner.h>
+#include <string>
+#include <vector>
+
+// A register of the VM. The type checker already knows which registers
+// hold numbers and which hold text, so values carry no tag and the
+// instructions reading them come in a version per type.
+union BytecodeValue {
+  double number;
+  Interner::Id text;
+};
+
+// Register operands index the current call frame, or the program's static
+// registers if the STATIC bit is set. Statics hold the variables more than
+// one function mentions, followed by the constants.
+//
+//   Move                 a := b
+//   Add ... Or           a := b op c, on numbers
+//   Not, Sqrt            a := op b
+//   Eq, Grt              a := b op c, giving 1 or 0
+//   EqText, GrtText      the same for text; text compares by its characters
+//   Input                a := a number read from the input
+//   Jump                 pc := a
+//   JumpIf*              pc := a if b op c
+//   Call                 calls functions[b] with its frame starting c
+//                        registers up, and stores its result in a unless a
+//                        is NONE; the arguments have already been moved to
+//                        the callee's first registers
+//   TailCall             the same, but in place of the current call: the
+//                        arguments move down to the start of the frame,
+//                        and the callee returns to where the current call
+//                        would have
+//   Return               returns a, or nothing if a is NONE
+//   Print, PrintText     prints b and a newline
+//   Halt                 stops the program
+enum class BytecodeOpcode : uint8_t {
+  Move,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  And,
+  Or,
+  Not,
+  Sqrt,
+  Eq,
+  EqText,
+  Grt,
+  GrtText,
+  Input,
+  Jump,
+  JumpIfEq,
+  JumpIfEqText,
+  JumpIfGrt,
+  JumpIfGrtText,
+  Call,
+  TailCall,
+  Return,
+  Print,
+  PrintText,
+  Halt
+};
+
+struct BytecodeInstruction {
+  BytecodeOpcode opcode;
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t c = 0;
+};
+
+struct BytecodeFunction {
+  std::string name;
+  uint32_t entry;       // index of its first instruction
+  uint32_t params;      // registers the caller fills with arguments
+  uint32_t frame_size;  // registers of its own, the parameters included
+  // what a call sets the registers after the parameters to: zero for
+  // numbers and "" for text
+  std::vector<BytecodeValue> initial;
+};
+
+struct Bytecode {
+  static constexpr uint32_t STATIC = 1u << 31;
+  static constexpr uint32_t NONE = UINT32_MAX;
+  // every call passes exactly this many arguments
+  static constexpr uint32_t ARGUMENTS = 3;
+
+  std::vector<BytecodeInstruction> code;
+  std::vector<BytecodeFunction> functions; // functions[0] is main
+  std::vector<BytecodeValue> statics;      // their values on start-up
+};
+
+// Lowers the intermediate code of a whole program to bytecode. The
+// variables only one function mentions, its temporaries and the
+// arguments it passes get registers in that function's frame; everything
+// else is static. Throws std::logic_error on `and`, `or` or `not` of text,
+// which the type checker rejects, like the native backends do. A call in
+// tail position becomes a TailCall, so iterating through mutual recursion
+// runs in constant space.
+Bytecode compile_bytecode(const IMCProgram &program);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SPL_CFG_H
+#define SPL_CFG_H
+
+#include <cstdint>
+#include <imc.h>
+#include <string>
+#include <vector>
+
+// dst := phi(args), one argument per predecessor of the block, in the
+// order of BasicBlock::predecessors. `variable` is the operand the phi
+// merges, before renaming.
+struct Phi {
+  OperandId dst;
+  OperandId variable;
+  std::vector<OperandId> args;
+};
+
+// A maximal run of straight-line code. The label the block starts with is
+// kept apart from its code; the code ends in the block's jump, if any.
+// After a conditional jump, successors[0] is the jump's target and
+// successors[1] the block control falls through to.
+struct BasicBlock {
+  uint32_t label;
+  std::vector<Phi> phis;
+  std::vector<IMCInstruction> code;
+  std::vector<uint32_t> successors;
+  std::vector<uint32_t> predecessors;
+};
+
+// Control-flow graph of one function, with block 0 as its entry, which no
+// jump leads to. Blocks are numbered in code order; flatten() writes them
+// back as linear code.
+class CFG {
+public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  explicit CFG(const IMCFunction &function);
+
+  std::vector<BasicBlock> &blocks() { return this->m_Blocks; }
+  const std::vector<BasicBlock> &blocks() const { return this->m_Blocks; }
+
+  // immediate dominators by the iterative algorithm of Cooper, Harvey and
+  // Kennedy; must be recomputed after the graph changes
+  void compute_dominators();
+  bool reachable(uint32_t block) const { return this->m_Idom[block] != NONE; }
+  // the entry is its own immediate dominator
+  uint32_t idom(uint32_t block) const { return this->m_Idom[block]; }
+  bool dominates(uint32_t dominator, uint32_t block) const;
+  // reachable blocks, each before the blocks it dominates
+  const std::vector<uint32_t> &reverse_postorder() const {
+    return this->m_Order;
+  }
+  std::vector<std::vector<uint32_t>> dominator_tree() const;
+  std::vector<std::vector<uint32_t>> dominance_frontiers() const;
+
+  // puts a new block on the edge from -> to, retargeting from's jump, and
+  // returns it
+  uint32_t split_edge(IMCFunction &function, uint32_t from, uint32_t to);
+
+  // drops the edge to from's successors[slot] along with its phi arguments;
+  // the jump that took it is the caller's to rewrite
+  void remove_edge(uint32_t from, std::size_t slot);
+
+  // deletes the blocks the entry cannot reach and renumbers the rest,
+  // returning how many instructions went with them; dominators must be
+  // recomputed afterwards
+  std::size_t remove_unreachable();
+
+  // writes the blocks back as the function's code, adding the labels and
+  // jumps that blocks out of their fall-through order need
+  void flatten(IMCFunction &function);
+
+  std::string to_string(const IMCProgram &program) const;
+
+private:
+  void link(uint32_t from, uint32_t to);
+  void remove_predecessor(uint32_t block, std::size_t index);
+
+  std::vector<BasicBlock> m_Blocks;
+  std::vector<uint32_t> m_Idom;
+  std::vector<uint32_t> m_Order;
+  std::vector<uint32_t> m_OrderIndex; // position in m_Order, or NONE
+};
+
+#endif
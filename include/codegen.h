@@ -0,0 +1,22 @@
+#ifndef SPL_CODEGEN_H
+#define SPL_CODEGEN_H
+
+#include <imc.h>
+#include <string>
+
+// Native backends. Both lower a whole program to source for the system
+// toolchain and behave like the VM: variables only one function mentions
+// live in its frame, shared ones in static storage, and temporaries go
+// through linear-scan register allocation. Both throw std::logic_error on
+// `and`, `or` or `not` of text, as compile_bytecode() does.
+//
+// emit_c() gives one self-contained C file, runtime included:
+//   cc -O2 program.c -lm
+// emit_asm() gives x86-64 GAS assembly for the System V ABI, which links
+// against the runtime emit_runtime() gives:
+//   cc program.s runtime.c -lm
+std::string emit_c(const IMCProgram &program);
+std::string emit_asm(const IMCProgram &program);
+std::string emit_runtime();
+
+#endif
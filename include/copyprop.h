@@ -0,0 +1,18 @@
+#ifndef SPL_COPYPROP_H
+#define SPL_COPYPROP_H
+
+#include <cfg.h>
+#include <imc.h>
+#include <ssa.h>
+
+// Copy propagation over one function in SSA form. A copy into a renamed
+// operand whose source cannot change while it lives (a constant, a
+// temporary, or the entry value of a renamed variable) is removed, and its
+// uses read the source instead; so is a phi whose arguments all come to
+// the same value, and one nothing reads. Copies from variables in memory
+// are left alone, since a call may write them. Returns how many copies and
+// phis were removed.
+std::size_t propagate_copies(IMCProgram &program, const SSABuilder &ssa,
+                             CFG &cfg, std::size_t function);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef SPL_DCE_H
+#define SPL_DCE_H
+
+#include <cfg.h>
+#include <imc.h>
+#include <ostream>
+
+// What dead code elimination took out of the program.
+struct DeadCodeReport {
+  std::size_t stores = 0;    // assignments whose value is never read
+  std::size_t functions = 0; // functions main can never reach
+  std::size_t variables = 0; // declared variables no code mentions
+  std::size_t temps = 0;     // temporaries no code mentions
+
+  DeadCodeReport &operator+=(const DeadCodeReport &other);
+  void print(std::ostream &out) const;
+};
+
+// Removes assignments to operands private to one function, its
+// temporaries and the variables only it mentions, that no path reads
+// before they are written again or the function returns, by backward
+// liveness over the graph. Input and calls stay, since they do something
+// besides assigning; so do stores into variables other functions share,
+// which a call may read. Repeats until no more assignments die. `owners`
+// is what IMCProgram::owners() gives. Returns how many were removed.
+std::size_t remove_dead_stores(IMCProgram &program,
+                               const std::vector<uint32_t> &owners, CFG &cfg,
+                               std::size_t function);
+
+// Drops the functions no chain of calls from main reaches, renumbering
+// the calls to the rest; then the locals and globals no code mentions any
+// more, which takes them out of the frames; and renumbers each function's
+// temporaries to those its code still uses. Variables keep their ids.
+DeadCodeReport remove_unused(IMCProgram &program);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef SPL_DIAGNOSTICS_H
+#define SPL_DIAGNOSTICS_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <token.h>
+#include <vector>
+
+enum class Severity { Error, Warning };
+
+struct Diagnostic {
+  Severity severity;
+  SourceSpan span;
+  std::string message;
+};
+
+// Everything a pass reported, in the order it was reported. At most the
+// engine's limit of diagnostics is kept; the counts include the ones that
+// were dropped.
+struct DiagnosticReport {
+  std::vector<Diagnostic> diagnostics;
+  std::size_t errors = 0;
+  std::size_t warnings = 0;
+
+  bool ok() const { return this->errors == 0; }
+  std::size_t suppressed() const {
+    return this->errors + this->warnings - this->diagnostics.size();
+  }
+
+  // one "file:line:column: error: message" line per diagnostic; colour
+  // is for terminals only
+  void print(std::ostream &out, std::string_view filename,
+             bool color = false) const;
+};
+
+// Collects the diagnostics of a pass so that it can keep going after an
+// error instead of stopping at the first one.
+class DiagnosticEngine {
+public:
+  static constexpr std::size_t DEFAULT_LIMIT = 100;
+
+  explicit DiagnosticEngine(std::size_t limit = DEFAULT_LIMIT);
+
+  void error(const SourceSpan &span, std::string message);
+  void warning(const SourceSpan &span, std::string message);
+
+  bool has_errors() const;
+  std::size_t error_count() const;
+  const DiagnosticReport &report() const;
+
+  // hands the collected diagnostics over and starts afresh
+  DiagnosticReport take();
+
+private:
+  void add(Severity severity, const SourceSpan &span, std::string message);
+
+  std::size_t m_Limit;
+  DiagnosticReport m_Report;
+};
+
+#endif
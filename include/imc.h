@@ -1,90 +1,247 @@
 #ifndef SPL_IMC_H
 #define SPL_IMC_H
 
+#include <cstdint>
+#include <map>
 #include <parser.h>
+#include <string>
 #include <symbol.h>
+#include <unordered_map>
+#include <vector>
 
-class IMCStatement {
-public:
-  enum class StatementType { Assignment, NumberValue, TextValue };
-
-  IMCStatement(const IMCStatement &);
-  IMCStatement &operator=(const IMCStatement &);
-  bool operator==(const IMCStatement &) const;
-  bool operator!=(const IMCStatement &) const;
+// Operands of the intermediate code are 32-bit ids: the top two bits say
+// which table the rest indexes. Variables index IMCProgram::variables,
+// temporaries the temps of their function and constants the program's
+// constant pool.
+using OperandId = uint32_t;
 
-  static IMCStatement create_assignment(const std::string &place,
-                                        const IMCStatement &rhs);
-  static IMCStatement create_value(int64_t number);
-  static IMCStatement create_value(const std::string &text);
+struct IMCOperand {
+  enum class Kind : uint8_t { Variable, Temp, Constant, None };
 
-  StatementType get_type() const;
-  const std::string &get_text() const;
-  int64_t get_number() const;
-  const std::string &get_lhs_id() const;
-  const IMCStatement &get_rhs() const;
+  static constexpr OperandId NONE = UINT32_MAX;
 
-private:
-  IMCStatement();
+  static constexpr OperandId variable(uint32_t index) { return index; }
+  static constexpr OperandId temp(uint32_t index) {
+    return (1u << 30) | index;
+  }
+  static constexpr OperandId constant(uint32_t index) {
+    return (2u << 30) | index;
+  }
 
-  StatementType m_Type;
-  std::optional<std::string> m_Text;
+  static constexpr Kind kind(OperandId id) { return Kind(id >> 30); }
+  static constexpr uint32_t index(OperandId id) { return id & 0x3FFFFFFFu; }
+};
 
-  std::optional<int64_t> m_Number;
-  std::optional<std::string> m_LHS;
-  std::unique_ptr<IMCStatement> m_RHS;
+// shortest decimal form that reads back as the same double, which is how
+// numbers are written in dumps and printed by running programs
+std::string format_number(double number);
+
+// The opcodes of the three-address code. The fields of an instruction mean
+//
+//   Copy                  dst := src1
+//   Add ... Grt           dst := src1 op src2
+//   Sqrt, Not             dst := op src1
+//   Input                 dst := INPUT
+//   Arg                   ARG src1, one per argument, just before the call
+//   Call                  dst := CALL functions[src1]; dst may be NONE
+//   Label                 LABEL dst
+//   Jump                  GOTO dst
+//   JumpIfEq, JumpIfGrt   IF src1 op src2 GOTO dst
+//   Print                 PRINT src1
+//   Return                RETURN src1; src1 may be NONE
+//   Halt                  STOP
+//
+// where labels are numbered per function.
+enum class IMCOpcode : uint8_t {
+  Copy,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  And,
+  Or,
+  Eq,
+  Grt,
+  Sqrt,
+  Not,
+  Input,
+  Arg,
+  Call,
+  Label,
+  Jump,
+  JumpIfEq,
+  JumpIfGrt,
+  Print,
+  Return,
+  Halt
 };
 
-class IMCGenerator {
-public:
-  IMCGenerator(SyntaxTreeNode *root);
-  ~IMCGenerator();
+std::string_view opcode_name(IMCOpcode opcode);
 
-private:
-  std::vector<IMCStatement> translate_expression(SyntaxTreeNode *expr,
-                                                 const std::string &place);
+// true if control never falls through to the next instruction
+bool is_terminator(IMCOpcode opcode);
 
-  SyntaxTreeNode *m_SyntaxTree;
-  std::shared_ptr<SymbolTable> m_Functions;
-  std::shared_ptr<SymbolTable> m_Variables;
+// true if dst is an operand the instruction writes, rather than a label or
+// nothing
+bool writes_dst(IMCOpcode opcode);
+
+// how many of src1 and src2 are operands the instruction reads; a Return
+// without a value still counts its src1, which is NONE
+int source_count(IMCOpcode opcode);
+
+// true for the jumps, whose dst is a label
+bool is_jump(IMCOpcode opcode);
+
+// One flat three-address instruction; a function's code is a contiguous
+// vector of these
+struct IMCInstruction {
+  IMCOpcode opcode;
+  OperandId dst = IMCOperand::NONE;
+  OperandId src1 = IMCOperand::NONE;
+  OperandId src2 = IMCOperand::NONE;
+
+  bool operator==(const IMCInstruction &other) const {
+    return opcode == other.opcode && dst == other.dst && src1 == other.src1 &&
+           src2 == other.src2;
+  }
+  bool operator!=(const IMCInstruction &other) const {
+    return !(*this == other);
+  }
 };
 
-class IMCVariable {
+// Deduplicated pool of the program's constants. Text constants are kept
+// as ids in the global interner, like the names in the syntax tree.
+class IMCConstantPool {
 public:
-  enum class VariableType { Number, Text };
+  struct Constant {
+    TypeId type; // Num or Text
+    double number;
+    Interner::Id text;
+  };
 
-  VariableType get_type() const;
-  const char *get_text() const;
-  int64_t get_number() const;
+  uint32_t intern_number(double value);
+  uint32_t intern_text(std::string_view value);
 
-  static IMCVariable make_variable(const std::string &id, int64_t data) {
-    IMCVariable result{};
-    result.m_ID = id;
-    result.m_Type = IMCVariable::VariableType::Number;
-    result.m_Data.m_Number = data;
+  const Constant &get(uint32_t index) const { return this->m_Constants[index]; }
+  std::size_t size() const { return this->m_Constants.size(); }
 
-    return result;
-  }
+private:
+  std::vector<Constant> m_Constants;
+  std::unordered_map<uint64_t, uint32_t> m_Numbers; // by bit pattern
+  std::unordered_map<Interner::Id, uint32_t> m_Texts;
+};
 
-  static IMCVariable make_variable(const std::string &id, const char *data) {
-    IMCVariable result{};
-    result.m_ID = id;
-    result.m_Type = IMCVariable::VariableType::Text;
-    result.m_Data.m_Text = data;
+// A variable of the source program, after renaming to a unique place
+struct IMCVariable {
+  SymbolId name; // the source name, for messages and dumps
+  TypeId type;
+};
 
-    return result;
-  }
+// A translated function. The main program is the function "main", which
+// has no parameters and ends in STOP.
+struct IMCFunction {
+  IMCFunction() = default;
+  IMCFunction(const IMCFunction &) = delete;
+  IMCFunction &operator=(const IMCFunction &) = delete;
+  IMCFunction(IMCFunction &&) = default;
+  IMCFunction &operator=(IMCFunction &&) = default;
+
+  std::string name;
+  TypeId return_type = TypeId::Void;
+  std::vector<OperandId> params;
+  std::vector<OperandId> locals;
+  std::vector<TypeId> temps; // type of each temporary
+  uint32_t label_count = 0;
+  std::vector<IMCInstruction> code;
+
+  OperandId new_temp(TypeId type);
+  uint32_t new_label() { return this->label_count++; }
+};
+
+struct IMCProgram {
+  IMCProgram() = default;
+  IMCProgram(const IMCProgram &) = delete;
+  IMCProgram &operator=(const IMCProgram &) = delete;
+  IMCProgram(IMCProgram &&) = default;
+  IMCProgram &operator=(IMCProgram &&) = default;
+
+  std::vector<IMCVariable> variables;
+  std::vector<OperandId> globals;
+  IMCConstantPool constants;
+  std::vector<IMCFunction> functions;
+
+  static constexpr uint32_t UNUSED = UINT32_MAX;
+  static constexpr uint32_t SHARED = UINT32_MAX - 1;
+
+  TypeId type_of(const IMCFunction &function, OperandId operand) const;
+
+  // for each variable, the index of the one function that declares or
+  // mentions it, SHARED if several do and UNUSED if none does; globals
+  // count as declared by main. Only a variable with an owner can live in
+  // that function's frame
+  std::vector<uint32_t> owners() const;
+
+  // whether the call at code[at] of a function is in tail position: from
+  // it, control passes through nothing but labels and jumps to a return of
+  // its result. A result stored in a variable other functions see does not
+  // count, since they could read it after the return, and neither does a
+  // call in main. `owners` is what owners() gives.
+  bool tail_call(const std::vector<uint32_t> &owners, std::size_t function,
+                 std::size_t at) const;
+
+  // textual forms used by --emit=imc: variables are v<n>, temporaries
+  // t<n> and labels L<n>, all counted from one
+  std::string operand_string(OperandId operand) const;
+  std::string instruction_string(const IMCInstruction &instruction) const;
+  std::string to_string() const;
+};
+
+// Translates a type-checked syntax tree to three-address code; generate()
+// is called once per generator. Every variable gets a fresh place, so the
+// scoping rules of the source no longer matter afterwards; functions keep
+// their names unless a nested function reuses one, which then gets a
+// numbered suffix. A function calling itself in tail position jumps back
+// to its start instead, with the parameters rebound in place.
+class IMCGenerator {
+public:
+  IMCGenerator(SyntaxTreeNode *root);
+
+  IMCProgram generate();
 
 private:
-  IMCVariable() = default;
+  void translate_globals(SyntaxTreeNode *globvars);
+  void translate_functions(SyntaxTreeNode *functions);
+  void translate_decl(SyntaxTreeNode *decl);
+
+  void translate_algo(SyntaxTreeNode *algo);
+  void translate_command(SyntaxTreeNode *command);
+  void translate_branch(SyntaxTreeNode *branch);
+  void translate_expression(SyntaxTreeNode *expr, OperandId place);
+  void translate_condition(SyntaxTreeNode *cond, uint32_t if_true,
+                           uint32_t if_false);
+  void translate_simple(SyntaxTreeNode *simple, uint32_t if_true,
+                        uint32_t if_false);
+  OperandId translate_atomic(SyntaxTreeNode *atomic);
+  void translate_call(SyntaxTreeNode *call, OperandId place);
+  void eliminate_tail_recursion();
+
+  OperandId declare_variable(SyntaxTreeNode *vname, TypeId type);
+  OperandId lookup_variable(SyntaxTreeNode *vname) const;
+
+  IMCFunction &current() { return this->m_Program.functions[this->m_Current]; }
+  void emit(IMCOpcode opcode, OperandId dst = IMCOperand::NONE,
+            OperandId src1 = IMCOperand::NONE,
+            OperandId src2 = IMCOperand::NONE) {
+    this->current().code.push_back(IMCInstruction{opcode, dst, src1, src2});
+  }
 
-  std::string m_ID;
-  VariableType m_Type;
+  SyntaxTreeNode *m_SyntaxTree;
+  std::shared_ptr<SymbolTable> m_Functions;
+  std::shared_ptr<SymbolTable> m_Variables;
 
-  union {
-    const char *m_Text;
-    int64_t m_Number;
-  } m_Data;
+  IMCProgram m_Program;
+  std::size_t m_Current = 0;
+  std::map<std::string, std::size_t> m_FunctionNames;
 };
 
 #endif
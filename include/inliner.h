@@ -0,0 +1,50 @@
+#ifndef SPL_INLINER_H
+#define SPL_INLINER_H
+
+#include <imc.h>
+#include <ostream>
+
+// What inlining substituted.
+struct InlineReport {
+  std::size_t calls = 0;     // call sites replaced by the callee's body
+  std::size_t functions = 0; // distinct functions inlined somewhere
+
+  void print(std::ostream &out) const;
+};
+
+// Replaces calls to small functions that are not recursive, directly or
+// through other functions, with a copy of the callee's body. Functions are
+// visited callees first, so a body is copied with its own calls already
+// inlined. A callee qualifies if its code is at most INLINE_LIMIT
+// instructions longer than the calling sequence it replaces, and as long
+// as the caller stays within GROWTH_LIMIT instructions.
+//
+// Each copy gets fresh temporaries, labels, and fresh caller-owned copies
+// of the variables only the callee mentions; the arguments are bound to
+// those with copies and the other variables reset as a call would. Shared
+// variables, such as those of an enclosing function, stay themselves.
+// The callee itself is left in place.
+class Inliner {
+public:
+  static constexpr std::size_t INLINE_LIMIT = 24;
+  static constexpr std::size_t GROWTH_LIMIT = 4096;
+
+  explicit Inliner(IMCProgram &program);
+
+  InlineReport run();
+
+private:
+  bool recursive(uint32_t function) const;
+  bool inlinable(uint32_t callee, std::size_t caller_size) const;
+  void inline_calls(uint32_t caller, InlineReport &report);
+  void expand(uint32_t caller, const IMCInstruction &call,
+              const std::vector<OperandId> &arguments,
+              std::vector<IMCInstruction> &code);
+
+  IMCProgram &m_Program;
+  std::vector<uint32_t> m_Owners;
+  std::vector<std::vector<uint32_t>> m_Callees; // per function, distinct
+  std::vector<bool> m_Inlined;                  // per function
+};
+
+#endif
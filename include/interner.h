@@ -0,0 +1,44 @@
+#ifndef SPL_INTERNER_H
+#define SPL_INTERNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Deduplicating string pool. Every distinct string is stored once in
+// chunked, never-moving storage and identified by a dense 32-bit id, so
+// views handed out by the pool stay valid for the lifetime of the pool.
+//
+// The pool is not thread-safe; the compiler front end is single-threaded.
+class Interner {
+public:
+  using Id = uint32_t;
+  static constexpr Id INVALID = UINT32_MAX;
+
+  Interner();
+  Interner(const Interner &) = delete;
+  Interner &operator=(const Interner &) = delete;
+
+  // process-wide pool shared by the lexer, parser and later passes
+  static Interner &global();
+
+  Id intern(std::string_view text);
+  Id find(std::string_view text) const;
+  std::string_view view(Id id) const;
+  std::size_t size() const;
+
+private:
+  std::string_view store(std::string_view text);
+
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> m_Blocks;
+  std::vector<std::unique_ptr<char[]>> m_LargeBlocks;
+  std::size_t m_BlockUsed;
+  std::vector<std::string_view> m_Strings;
+  std::unordered_map<std::string_view, Id> m_Index;
+};
+
+#endif
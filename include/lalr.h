@@ -0,0 +1,114 @@
+#ifndef SPL_LALR_H
+#define SPL_LALR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Context-free grammar in the format of grammar.txt: one "LHS -> a b c" rule
+// per line, with '' standing for an empty right-hand side.
+//
+// The first rule is the augmented start rule; the input is accepted when it
+// is reduced with end of input as lookahead. Symbols are numbered terminals
+// first, in order of first appearance, with the end marker "$" as the last
+// terminal, followed by the nonterminals in order of their first rule.
+class Grammar {
+public:
+  struct Rule {
+    int lhs;
+    std::vector<int> rhs;
+  };
+
+  static constexpr std::string_view END_MARKER = "$";
+
+  // throws std::runtime_error for malformed rules
+  static Grammar parse(std::string_view source);
+
+  int terminal_count() const { return this->m_TerminalCount; }
+  int nonterminal_count() const {
+    return static_cast<int>(this->m_Symbols.size()) - this->m_TerminalCount;
+  }
+  int symbol_count() const { return static_cast<int>(this->m_Symbols.size()); }
+  int end_marker() const { return this->m_TerminalCount - 1; }
+  bool is_terminal(int id) const { return id < this->m_TerminalCount; }
+
+  // returns -1 for names that are not symbols of the grammar
+  int symbol_id(std::string_view name) const;
+  const std::string &symbol_name(int id) const { return this->m_Symbols[id]; }
+  const std::vector<Rule> &rules() const { return this->m_Rules; }
+
+private:
+  Grammar() = default;
+
+  int m_TerminalCount = 0;
+  std::vector<std::string> m_Symbols;
+  std::vector<Rule> m_Rules;
+};
+
+// Dense LALR(1) ACTION and GOTO tables for a grammar, using the action
+// encoding of ParseTable. States are numbered breadth-first from the start
+// state, following transitions in symbol order, so the same grammar always
+// produces the same table.
+class LalrTable {
+public:
+  // a cell that more than one action wants; the first action is kept
+  struct Conflict {
+    int state;
+    int terminal;
+    int16_t kept;
+    int16_t rejected;
+  };
+
+  static LalrTable build(const Grammar &grammar);
+
+  int state_count() const { return this->m_StateCount; }
+  const std::vector<int16_t> &actions() const { return this->m_Action; }
+  const std::vector<int16_t> &gotos() const { return this->m_Goto; }
+  const std::vector<Conflict> &conflicts() const { return this->m_Conflicts; }
+
+  std::string describe(const Grammar &grammar, const Conflict &conflict) const;
+
+  // the table in the CSV layout of parse_table.csv
+  std::string to_csv(const Grammar &grammar) const;
+
+private:
+  LalrTable() = default;
+
+  int m_StateCount = 0;
+  std::vector<int16_t> m_Action;
+  std::vector<int16_t> m_Goto;
+  std::vector<Conflict> m_Conflicts;
+};
+
+// Row-displacement ("comb") compression of ACTION and GOTO tables.
+//
+// Each state gets a default action - its most frequent reduction - and only
+// the cells that differ from it are stored. The remaining cells of all rows
+// are overlaid into one pair of next/check arrays: the cell for (state, x)
+// lives at base[state] + x if check there equals state, and is the default
+// otherwise. Replacing error cells with a reduction only delays error
+// detection until before the next shift, so the parser still rejects exactly
+// the same inputs.
+struct CompressedTable {
+  int terminal_count = 0;
+  int nonterminal_count = 0;
+  int state_count = 0;
+
+  std::vector<int16_t> action_default;
+  std::vector<uint16_t> action_base;
+  std::vector<int16_t> action_next;
+  std::vector<int16_t> action_check;
+
+  // GOTO cells default to -1 (no transition)
+  std::vector<uint16_t> goto_base;
+  std::vector<int16_t> goto_next;
+  std::vector<int16_t> goto_check;
+
+  static CompressedTable compress(const std::vector<int16_t> &action,
+                                  const std::vector<int16_t> &go_to,
+                                  int terminal_count, int nonterminal_count,
+                                  int state_count);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <exception>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <token.h>
 #include <vector>
 
@@ -16,27 +17,70 @@ public:
   const char *what() const noexcept override;
 };
 
-class TokenStream {
+// Pull interface the parser reads tokens through. peek() returns the next
+// token without consuming it; both return an empty optional at end of input.
+class TokenSource {
+public:
+  virtual ~TokenSource() = default;
+  virtual std::optional<Token> peek() = 0;
+  virtual std::optional<Token> next() = 0;
+};
+
+// Materialised token list, used for the XML dump and in tests
+class TokenStream : public TokenSource {
 private:
   std::vector<Token> m_Tokens;
+  std::size_t m_Cursor = 0;
 
 public:
   explicit TokenStream(const std::vector<Token> &tokens);
-  std::vector<Token> getTokens();
+  explicit TokenStream(std::vector<Token> &&tokens);
+  const std::vector<Token> &getTokens() const &;
+  // hands the tokens over without copying, leaving the stream empty
+  std::vector<Token> getTokens() &&;
   auto begin() const;
   auto end() const;
-  std::optional<Token> next();
+  std::optional<Token> peek() override;
+  std::optional<Token> next() override;
   std::string to_xml() const;
 };
 
-class Lexer {
+// Selects the scanning engine used by a Lexer. `Table` walks the input once
+// with a hand-written DFA over character classes; `Regex` is the original
+// regex/substr pipeline, kept as a reference for differential testing.
+enum class LexerEngine { Regex, Table };
+
+// Scans tokens on demand; as a TokenSource it lets the parser pull tokens
+// while lexing, without materialising the whole stream.
+class Lexer : public TokenSource {
 private:
+  LexerEngine m_Engine;
+  // the table engine scans the caller's buffer in place; the regex engine
+  // consumes a private copy in m_Source
+  std::string_view m_Input;
   std::string m_Source;
+  std::size_t m_Position = 0;
+  std::size_t m_TokenStart = 0;
+  std::size_t m_TokenEnd = 0;
+  std::size_t m_Line = 0;
+  std::vector<std::size_t> m_LineStarts;
   std::vector<std::string> unprocessed_input;
+  std::optional<Token> m_Lookahead;
+  bool m_HasLookahead = false;
+
+  std::optional<Token> read_token();
+  std::optional<Token> next_token_regex();
+  std::optional<Token> next_token_table();
 
 public:
-  Lexer(const std::string &input);
+  // the input buffer must outlive the lexer
+  Lexer(std::string_view input, LexerEngine engine = LexerEngine::Table);
   std::optional<Token> next_token();
+  std::optional<Token> peek() override;
+  std::optional<Token> next() override;
+  std::pair<std::size_t, std::size_t> token_offsets() const;
+  SourceSpan locate(std::size_t offset, std::size_t length = 0) const;
+  const std::vector<std::size_t> &line_starts() const;
   TokenStream lex_all();
   int getTokenLineNumber(std::string tokenValue);
 };
@@ -0,0 +1,28 @@
+#ifndef SPL_OPTIMIZER_H
+#define SPL_OPTIMIZER_H
+
+#include <dce.h>
+#include <imc.h>
+#include <inliner.h>
+#include <ostream>
+#include <sccp.h>
+
+// What each pass of optimize() changed, summed over all functions.
+struct OptimizationReport {
+  InlineReport inlined;
+  SCCPReport constants;
+  std::size_t copies = 0; // copies and phis removed by copy propagation
+  DeadCodeReport dead;
+
+  void print(std::ostream &out) const;
+};
+
+// Runs the optimization passes over every function of the program. Small
+// functions are inlined into their callers first; then each function is
+// taken into SSA form for the passes that need it and written back as
+// linear code afterwards, without the stores nothing reads. Last go the
+// functions main no longer reaches and the variables and temporaries no
+// code mentions any more.
+OptimizationReport optimize(IMCProgram &program);
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef SPL_PARSE_TABLE_H
+#define SPL_PARSE_TABLE_H
+
+#include <cstdint>
+#include <lalr.h>
+#include <parser_file_handler.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Dense, integer-encoded LR(1) parse table.
+//
+// Symbols are numbered with all terminals first (0 .. terminal_count() - 1)
+// followed by all nonterminals. ACTION cells are indexed by state and
+// terminal id and encode the action in a single int16_t:
+//
+//   0          error
+//   s > 0      shift, next state is s - 1
+//   r < 0      reduce by rule -r - 1
+//   ACCEPT     accept
+//
+// GOTO cells are indexed by state and nonterminal index (symbol id minus
+// terminal_count()) and hold the target state, or -1 if there is none.
+//
+// Both are stored row-compressed with default reductions (see
+// CompressedTable), so an error cell may read as the state's default
+// reduction. The standard table points straight at the constexpr arrays that
+// splc_tablegen builds from grammar.txt; tables built from a
+// ParserFileHandler own their storage.
+class ParseTable {
+public:
+  using Action = int16_t;
+
+  static constexpr Action ERROR = 0;
+  static constexpr Action ACCEPT = INT16_MIN;
+
+  struct Rule {
+    uint16_t lhs;
+    uint16_t length;
+  };
+
+  ParseTable(const ParseTable &) = delete;
+  ParseTable &operator=(const ParseTable &) = delete;
+  ParseTable(ParseTable &&) = default;
+  ParseTable &operator=(ParseTable &&) = default;
+
+  // build the dense table from the string-keyed reference table
+  static ParseTable from_file_handler(const ParserFileHandler &fileHandler);
+
+  // the table splc_tablegen generates from grammar.txt at build time
+  static const ParseTable &standard();
+
+  static bool is_shift(Action action) { return action > 0; }
+  static bool is_reduce(Action action) {
+    return action < 0 && action != ACCEPT;
+  }
+  static int shift_state(Action action) { return action - 1; }
+  static int reduce_rule(Action action) { return -action - 1; }
+  static Action encode_shift(int state) { return static_cast<Action>(state + 1); }
+  static Action encode_reduce(int rule) { return static_cast<Action>(-rule - 1); }
+
+  Action action(int state, int terminal) const {
+    int index = this->m_ActionBase[state] + terminal;
+    return this->m_ActionCheck[index] == state ? this->m_ActionNext[index]
+                                               : this->m_ActionDefault[state];
+  }
+
+  // action taken on every terminal without an explicit entry
+  Action default_action(int state) const {
+    return this->m_ActionDefault[state];
+  }
+
+  int go_to(int state, int nonterminal) const {
+    int index = this->m_GotoBase[state] + (nonterminal - this->m_TerminalCount);
+    return this->m_GotoCheck[index] == state ? this->m_GotoNext[index] : -1;
+  }
+
+  Rule rule(int index) const {
+    return {this->m_RuleLhs[index], this->m_RuleLength[index]};
+  }
+
+  // returns -1 for names that are not symbols of the grammar
+  int symbol_id(std::string_view name) const;
+  std::string_view symbol_name(int id) const;
+  bool is_terminal(int id) const { return id < this->m_TerminalCount; }
+
+  int terminal_count() const { return this->m_TerminalCount; }
+  int nonterminal_count() const { return this->m_NonterminalCount; }
+  int state_count() const { return this->m_StateCount; }
+  int rule_count() const { return this->m_RuleCount; }
+
+private:
+  ParseTable() = default;
+
+  int m_TerminalCount = 0;
+  int m_NonterminalCount = 0;
+  int m_StateCount = 0;
+  int m_RuleCount = 0;
+  const std::string_view *m_Symbols = nullptr;
+  const Action *m_ActionDefault = nullptr;
+  const uint16_t *m_ActionBase = nullptr;
+  const Action *m_ActionNext = nullptr;
+  const int16_t *m_ActionCheck = nullptr;
+  const uint16_t *m_GotoBase = nullptr;
+  const int16_t *m_GotoNext = nullptr;
+  const int16_t *m_GotoCheck = nullptr;
+  const uint16_t *m_RuleLhs = nullptr;
+  const uint16_t *m_RuleLength = nullptr;
+
+  // backing storage for tables that are not generated at build time
+  std::vector<std::string> m_OwnedNames;
+  std::vector<std::string_view> m_OwnedSymbols;
+  CompressedTable m_OwnedTable;
+  std::vector<uint16_t> m_OwnedRuleLhs;
+  std::vector<uint16_t> m_OwnedRuleLength;
+};
+
+#endif
@@ -7,8 +7,9 @@
 #include <string>
 #include <vector>
 #include <iostream>
-#include <atomic>
-#include "parser_file_handler.h"
+#include <memory>
+#include "parse_table.h"
+#include "syntax_tree.h"
 
 struct SyntaxError : public std::exception
 {
@@ -17,6 +18,7 @@ private:
 
 public:
   explicit SyntaxError(const std::string &msg, std::string filename, const int &line);
+  explicit SyntaxError(const std::string &msg, std::string filename, const SourceSpan &span);
   explicit SyntaxError(const std::string &msg);
   const char *what() const noexcept override;
 };
@@ -24,95 +26,54 @@ public:
 struct StackItem
 {
   int state;
-  std::string symbol;
-};
-
-struct SyntaxTreeNode
-{
-  static std::atomic<int> syntaxTreeNodeCounter;
-  int id;
-  std::string symbol;
-  std::string tokenValue;
-  int lineNumber;
-  std::vector<SyntaxTreeNode *> children;
-
-  SyntaxTreeNode(const std::string &sym, const std::string &val, const int &line) : id(syntaxTreeNodeCounter++), symbol(sym), tokenValue(val), lineNumber(line) {}
-  SyntaxTreeNode(const std::string &sym, const int &line) : id(syntaxTreeNodeCounter++), symbol(sym), lineNumber(line) {}
-
-  void addChild(SyntaxTreeNode *child)
-  {
-    this->children.insert(this->children.begin(), child);
-  }
-
-  void printTree(int depth = 0) const
-  {
-    for (int i = 0; i < depth; ++i)
-    {
-      std::cout << "  ";
-    }
-    // std::cout << symbol << " (ID: " << id << ")" << std::endl;
-    std::cout << this->getSymbolOrValue() << std::endl;
-    for (const auto &child : this->children)
-    {
-      child->printTree(depth + 1);
-    }
-  }
-
-  std::vector<SyntaxTreeNode *> getChildren() const
-  {
-    return this->children;
-  }
-
-  std::string getSymbol() const
-  {
-    return this->symbol;
-  }
-
-  std::string getActualValue() const
-  {
-    return this->tokenValue;
-  }
-
-  std::string getSymbolOrValue() const
-  {
-    if (this->symbol == "varname" || this->symbol == "numliteral" || this->symbol == "textliteral" || this->symbol == "fname")
-    {
-      return this->tokenValue;
-    }
-    else
-    {
-      return this->symbol;
-    }
-  }
-
-  int getLineNumber() const
-  {
-    return this->lineNumber;
-  }
+  int symbol;
 };
 
 class Parser
 {
 private:
   bool delayReduce = false;
-  std::vector<Token> m_Tokens;
-  std::map<std::string, std::map<std::string, std::string>> parseTable;
+  bool printTree = true;
+  std::string filename;
+  std::unique_ptr<TokenSource> m_OwnedTokens;
+  TokenSource *m_Tokens;
+  SourceSpan m_EndSpan{};
+  const ParseTable *parseTable;
   std::stack<StackItem> stateStack;
-  std::stack<SyntaxTreeNode *> syntaxTreeStack;
-  std::vector<std::pair<std::string, std::vector<std::string>>> grammarRules;
-
-  void loadParseTable(ParserFileHandler fileHandler);
-  void loadGrammarRules(ParserFileHandler fileHandler);
-  std::string getAction(int state, const std::string &token);
-  void shift(int state, std::string currentTokenSymbol, std::string currentTokenValue, int line);
-  void reduce(std::pair<std::string, std::vector<std::string>> rule, int line);
+  std::unique_ptr<SyntaxTree> tree;
+  std::vector<SyntaxTreeNode *> nodeStack;
+
+  // table symbol ids translated to GrammarSymbol, for tables numbered
+  // differently from the standard one
+  std::vector<GrammarSymbol> grammarSymbols;
+
+  // terminal ids resolved once per parser, indexed by token payload
+  int keywordTerminals[Keyword::Return + 1];
+  int punctTerminals[128];
+  int varnameTerminal, numliteralTerminal, textliteralTerminal, fnameTerminal, endTerminal;
+
+  void loadTerminals();
+  int classifyToken(const Token &token) const;
+  Token lookahead();
+  ParseTable::Action getAction(int state, int terminal) const;
+  void shift(int state, int terminal, const Token &token);
+  void reduce(const ParseTable::Rule &rule, const SourceSpan &span);
   void printStateStack(std::string action);
 
 public:
-  Parser(TokenStream tokens);
-  Parser(const Parser &other);
-  Parser &operator=(const Parser &other);
-  SyntaxTreeNode *parse();
+  // pulls tokens from the source while parsing; the source must outlive
+  // the parser
+  Parser(TokenSource &tokens);
+  Parser(TokenSource &tokens, const ParseTable &table);
+  Parser(TokenStream &&tokens);
+  Parser(TokenStream &&tokens, const ParseTable &table);
+  Parser(const Parser &other) = delete;
+  Parser &operator=(const Parser &other) = delete;
+  std::unique_ptr<SyntaxTree> parse();
+  void setFilename(const std::string &filename);
+
+  // whether parse() prints the syntax tree on success (the default)
+  void setPrintTree(bool printTree);
 };
 
 #endif // SPL_PARSER_H
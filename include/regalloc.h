@@ -0,0 +1,28 @@
+#ifndef SPL_REGALLOC_H
+#define SPL_REGALLOC_H
+
+#include <cstdint>
+#include <imc.h>
+#include <vector>
+
+// Where each temporary of a function lives: one of the backend's
+// registers, or a spill slot in its frame. Temporaries whose lifetimes do
+// not overlap share a register.
+struct RegisterAllocation {
+  static constexpr uint32_t SPILLED = UINT32_MAX;
+
+  std::vector<uint32_t> registers; // per temporary, or SPILLED
+  std::vector<uint32_t> slots;     // per spilled temporary, else unused
+  uint32_t used = 0;               // registers handed out
+  uint32_t spilled = 0;            // spill slots handed out
+};
+
+// Linear-scan allocation (Poletto and Sarkar) of the temporaries of a
+// function to `registers` registers. A temporary's interval runs from its
+// first to its last live point in code order, with liveness computed over
+// the function's control-flow graph; when more intervals overlap than
+// there are registers, the one ending last is spilled.
+RegisterAllocation allocate_registers(const IMCFunction &function,
+                                      uint32_t registers);
+
+#endif
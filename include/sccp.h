@@ -0,0 +1,32 @@
+#ifndef SPL_SCCP_H
+#define SPL_SCCP_H
+
+#include <cfg.h>
+#include <imc.h>
+#include <ostream>
+
+// What a run of constant propagation took out of the code.
+struct SCCPReport {
+  std::size_t folded = 0;       // assignments and phis of a constant
+  std::size_t branches = 0;     // conditional jumps that only go one way
+  std::size_t blocks = 0;       // blocks no execution reaches
+  std::size_t instructions = 0; // the code of those blocks
+
+  SCCPReport &operator+=(const SCCPReport &other);
+  void print(std::ostream &out) const;
+};
+
+// Sparse conditional constant propagation (Wegman and Zadeck) over one
+// function in SSA form. Only the edges a run can take are followed, so a
+// branch on a constant never contributes the values of its dead arm.
+// Afterwards every use of a constant temporary reads the constant itself,
+// the assignments and phis that defined them are gone, decided branches
+// are plain jumps or fall through, and the blocks no run reaches are
+// removed. Division by zero, the square root of a negative number and
+// ordering text, which compares it character by character, are left for
+// run time; equal texts are the same constant, so eq on text folds. The
+// graph's dominators must be up to date, and are again afterwards.
+SCCPReport propagate_constants(IMCProgram &program, CFG &cfg,
+                               std::size_t function);
+
+#endif
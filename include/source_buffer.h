@@ -0,0 +1,39 @@
+#ifndef SPL_SOURCE_BUFFER_H
+#define SPL_SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Read-only program text. Regular files are memory-mapped so the lexer
+// scans the page cache directly; anything that cannot be mapped (stdin,
+// pipes) is read into memory in one bulk read.
+class SourceBuffer {
+public:
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  ~SourceBuffer();
+
+  // throws std::runtime_error if the file cannot be opened or read
+  static SourceBuffer open(const std::string &path);
+  static SourceBuffer read(std::istream &stream);
+
+  std::string_view text() const {
+    return std::string_view(this->m_Data, this->m_Size);
+  }
+  bool is_mapped() const { return this->m_Mapped; }
+
+private:
+  SourceBuffer() = default;
+  void release();
+
+  const char *m_Data = nullptr;
+  std::size_t m_Size = 0;
+  bool m_Mapped = false;
+  std::string m_Owned;
+};
+
+#endif
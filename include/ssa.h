@@ -0,0 +1,35 @@
+#ifndef SPL_SSA_H
+#define SPL_SSA_H
+
+#include <cfg.h>
+#include <imc.h>
+
+// Converts functions to static single assignment form and back.
+//
+// Only operands private to a function are renamed: its temporaries, and
+// the variables no other function mentions. Everything else may be read
+// or written by a call and so stays an ordinary variable in memory. A
+// renamed operand keeps its original id for the value it has on entry;
+// each assignment and phi defines a fresh temporary instead.
+class SSABuilder {
+public:
+  explicit SSABuilder(IMCProgram &program);
+
+  // whether an operand of the given function is renamed
+  bool renamable(std::size_t function, OperandId operand) const;
+
+  // places phis at the iterated dominance frontiers of each renamed
+  // operand's definitions (minimal SSA) and renames along the dominator
+  // tree; the graph's dominators must be up to date
+  void construct(CFG &cfg, std::size_t function);
+
+  // replaces phis with copies at the end of the predecessors, splitting
+  // critical edges; the graph's dominators are stale afterwards
+  void destruct(CFG &cfg, std::size_t function);
+
+private:
+  IMCProgram &m_Program;
+  std::vector<uint32_t> m_Owners; // the one function using each variable
+};
+
+#endif
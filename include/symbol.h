@@ -1,52 +1,114 @@
 #ifndef SPL_SYMBOL_H
 #define SPL_SYMBOL_H
 
+#include <cstdint>
+#include <deque>
+#include <interner.h>
 #include <memory>
-#include <optional>
-#include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+// Names are identified by their id in the global interner, the same ids
+// the lexer hands out for identifier tokens
+using SymbolId = Interner::Id;
+
+enum class TypeId : uint8_t
+{
+  Num,
+  Text,
+  Void,
+  Function,
+  Error, // an expression whose error has already been reported
+};
+
+std::string_view typeName(TypeId type);
+
 class Symbol
 {
 public:
-  Symbol(const std::string &identifier, std::string type);
+  Symbol(SymbolId identifier, TypeId type);
+  Symbol(std::string_view identifier, TypeId type);
 
-  const std::string &name() const;
-  std::string type() const;
+  // a function symbol: its type is TypeId::Function and the signature is
+  // kept alongside
+  static Symbol function(SymbolId identifier, TypeId returnType, std::vector<TypeId> paramTypes);
 
-  bool operator==(const Symbol &other) const;
+  SymbolId id() const;
+  std::string_view name() const;
+  TypeId type() const;
+  TypeId getReturnType() const;
 
-  std::vector<std::string> getParamTypes() const;
+  // where the symbol lives in generated code, such as its IMC operand or
+  // function index; its own name unless set
+  uint32_t place() const;
+  void setPlace(uint32_t place);
+
+  bool operator==(const Symbol &other) const;
 
-  void setParamTypes(std::vector<std::string> paramTypes);
+  const std::vector<TypeId> &getParamTypes() const;
 
 private:
-  std::string m_Ident;
-  std::string m_Type;
-  std::vector<std::string> paramTypes; // function symbol parameter types
-  std::string returnType;              // function symbol return type
+  SymbolId m_Ident;
+  uint32_t m_Place;
+  TypeId m_Type;
+  TypeId returnType;              // function symbol return type
+  std::vector<TypeId> paramTypes; // function symbol parameter types
 };
 
+// Scoped symbol table. Bindings are kept in one flat open-addressing hash
+// keyed by interned name; each slot points at the innermost binding of its
+// name, and every binding remembers the one it shadows. The bindings
+// themselves form an undo log, so leaving a scope pops the entries made
+// since the matching enter() and restores the shadowed ones.
 class SymbolTable
 {
 public:
-  SymbolTable(const SymbolTable &other);
-  SymbolTable &operator=(const SymbolTable &other);
-
   static std::shared_ptr<SymbolTable> empty();
 
   void bind(const Symbol &information);
-  std::optional<Symbol> lookup(const std::string &identifier) const;
+
+  // innermost binding visible from the current scope, or nullptr; the
+  // pointer stays valid until the binding's scope is exited
+  const Symbol *lookup(SymbolId identifier) const;
+  const Symbol *lookup(std::string_view identifier) const;
+
+  // binding made in the current scope itself, for redeclaration checks
+  const Symbol *lookup_local(SymbolId identifier) const;
+  const Symbol *lookup_local(std::string_view identifier) const;
 
   void enter();
   void exit();
 
+  std::size_t depth() const;
+
 private:
   SymbolTable();
 
-  std::shared_ptr<SymbolTable> m_Parent;
-  std::unordered_map<std::string, Symbol> m_Symbols;
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Entry
+  {
+    Symbol symbol;
+    uint32_t shadowed; // previous binding of the same name, or NONE
+  };
+
+  struct Slot
+  {
+    Interner::Id name; // Interner::INVALID marks an empty slot
+    uint32_t entry;    // innermost binding, or NONE once it went out of scope
+  };
+
+  std::size_t slotIndex(Interner::Id name) const;
+  const Slot *findSlot(Interner::Id name) const;
+  uint32_t findEntry(SymbolId identifier) const;
+  Slot &insertSlot(Interner::Id name);
+  void grow();
+
+  std::deque<Entry> m_Entries; // deque keeps handed-out pointers stable
+  std::vector<uint32_t> m_ScopeMarks;
+  std::vector<Slot> m_Slots;
+  unsigned m_SlotBits; // m_Slots holds 2^m_SlotBits slots
+  std::size_t m_UsedSlots;
 };
 
 #endif
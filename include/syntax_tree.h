@@ -0,0 +1,181 @@
+#ifndef SPL_SYNTAX_TREE_H
+#define SPL_SYNTAX_TREE_H
+
+#include <arena.h>
+#include <cstdint>
+#include <interner.h>
+#include <parse_table_data.h>
+#include <string>
+#include <string_view>
+#include <token.h>
+
+struct SyntaxTreeNode;
+
+// Read-only view of a node's children, which are stored contiguously
+class SyntaxTreeChildren
+{
+public:
+  SyntaxTreeChildren(SyntaxTreeNode *const *first, uint32_t count) : first(first), count(count) {}
+
+  SyntaxTreeNode *const *begin() const { return this->first; }
+  SyntaxTreeNode *const *end() const { return this->first + this->count; }
+  std::size_t size() const { return this->count; }
+  bool empty() const { return this->count == 0; }
+  SyntaxTreeNode *operator[](std::size_t index) const { return this->first[index]; }
+  SyntaxTreeNode *front() const { return this->first[0]; }
+  SyntaxTreeNode *back() const { return this->first[this->count - 1]; }
+
+private:
+  SyntaxTreeNode *const *first;
+  uint32_t count;
+};
+
+// A node of the concrete syntax tree. Nodes live in the arena of their
+// SyntaxTree and are never freed individually: the symbol is a grammar
+// symbol id, the token value an interned string id, and the children a
+// slice of pointers that is filled once when the node's rule is reduced.
+struct SyntaxTreeNode
+{
+  uint32_t id;
+  GrammarSymbol symbol;
+  Interner::Id tokenValue;
+  SourceSpan span;
+  SyntaxTreeNode **children;
+  uint32_t childCount;
+
+  SyntaxTreeChildren getChildren() const
+  {
+    return SyntaxTreeChildren(this->children, this->childCount);
+  }
+
+  // the index-th child, without building a view first
+  SyntaxTreeNode *child(std::size_t index) const
+  {
+    return this->children[index];
+  }
+
+  GrammarSymbol getSymbolId() const
+  {
+    return this->symbol;
+  }
+
+  // interned id of the token's lexeme, or Interner::INVALID
+  Interner::Id getValueId() const
+  {
+    return this->tokenValue;
+  }
+
+  std::string getSymbol() const
+  {
+    return std::string(symbolName());
+  }
+
+  std::string getActualValue() const
+  {
+    return std::string(value());
+  }
+
+  std::string getSymbolOrValue() const
+  {
+    return std::string(hasValue() ? value() : symbolName());
+  }
+
+  std::string_view symbolName() const;
+
+  std::string_view value() const
+  {
+    return this->tokenValue == Interner::INVALID ? std::string_view() : Interner::global().view(this->tokenValue);
+  }
+
+  // names and literals carry their lexeme; keywords and punctuation don't
+  bool hasValue() const
+  {
+    return this->symbol == GrammarSymbol::Varname || this->symbol == GrammarSymbol::Numliteral ||
+           this->symbol == GrammarSymbol::Textliteral || this->symbol == GrammarSymbol::Fname;
+  }
+
+  int getLineNumber() const
+  {
+    return this->span.line;
+  }
+
+  const SourceSpan &getSpan() const
+  {
+    return this->span;
+  }
+
+  void printTree(int depth = 0) const;
+};
+
+// Range over the links of a right-recursive list such as
+// INSTRUC -> COMMAND ; INSTRUC, first to last, excluding the empty link
+// that ends it. Iterating follows the list's tail in a loop rather than by
+// recursion, so walking a list of any length takes constant stack space.
+class SyntaxTreeList
+{
+public:
+  class iterator
+  {
+  public:
+    explicit iterator(SyntaxTreeNode *link) : link(link) {}
+
+    SyntaxTreeNode *operator*() const { return this->link; }
+    bool operator!=(const iterator &other) const { return this->link != other.link; }
+
+    iterator &operator++()
+    {
+      SyntaxTreeNode *tail = this->link->getChildren().back();
+      bool continues = tail->getSymbolId() == this->link->getSymbolId() && !tail->getChildren().empty();
+      this->link = continues ? tail : nullptr;
+      return *this;
+    }
+
+  private:
+    SyntaxTreeNode *link;
+  };
+
+  explicit SyntaxTreeList(SyntaxTreeNode *list) : list(list) {}
+
+  iterator begin() const { return iterator(this->list->getChildren().empty() ? nullptr : this->list); }
+  iterator end() const { return iterator(nullptr); }
+
+private:
+  SyntaxTreeNode *list;
+};
+
+// Owns every node of one parse. Destroying the tree releases all nodes at
+// once by dropping the arena's blocks.
+class SyntaxTree
+{
+public:
+  SyntaxTree() = default;
+  SyntaxTree(const SyntaxTree &) = delete;
+  SyntaxTree &operator=(const SyntaxTree &) = delete;
+
+  SyntaxTreeNode *makeLeaf(GrammarSymbol symbol, Interner::Id value, const SourceSpan &span);
+
+  // the children are copied out of [first, first + count)
+  SyntaxTreeNode *makeNode(GrammarSymbol symbol, SyntaxTreeNode *const *first, uint32_t count, const SourceSpan &span);
+
+  SyntaxTreeNode *getRoot() const
+  {
+    return this->root;
+  }
+
+  void setRoot(SyntaxTreeNode *root)
+  {
+    this->root = root;
+  }
+
+  std::size_t size() const
+  {
+    return this->nodeCount;
+  }
+
+private:
+  Arena arena;
+  SyntaxTreeNode *root = nullptr;
+  uint32_t nodeCount = 0;
+};
+
+#endif // SPL_SYNTAX_TREE_H
@@ -1,8 +1,10 @@
 #ifndef SPL_TOKEN_H
 #define SPL_TOKEN_H
 
+#include <cstdint>
 #include <ostream>
 #include <string>
+#include <string_view>
 
 struct TokenException : public std::exception {
 private:
@@ -13,7 +15,7 @@ public:
   const char *what() const noexcept override;
 };
 
-enum TokenType {
+enum TokenType : uint8_t {
   Variable,
   FunctionName,
   StringLiteral,
@@ -21,7 +23,7 @@ enum TokenType {
   Keyword,
   Punctuation
 };
-enum Keyword {
+enum Keyword : uint8_t {
   Main,
   Num,
   Text,
@@ -49,16 +51,30 @@ enum Keyword {
 };
 
 std::string keyword_to_string(enum Keyword keyword);
+std::string_view keyword_view(enum Keyword keyword);
 
+// Location of a token in the source buffer. `line` and `column` are 1-based,
+// `offset` is the byte offset of the first character and `length` the number
+// of bytes the token occupies.
+struct SourceSpan {
+  uint32_t line = 0;
+  uint32_t column = 0;
+  uint32_t offset = 0;
+  uint32_t length = 0;
+};
+
+// A token is a 16-byte POD record: its kind, a one-byte payload (keyword id
+// or punctuation character), and for names and literals the id of the lexeme
+// in the global Interner pool. Only the start of the span is stored; the
+// length is recovered from the token text. Columns past 65535 saturate.
 class Token {
 private:
-  TokenType m_Type;
-  std::string m_Identifier;
-  std::string m_StringLiteral;
-  std::string m_NumLiteral;
-  enum Keyword m_Keyword;
-  std::string m_Punct;
-  int m_LineNumber = 0;
+  TokenType m_Type = TokenType::Punctuation;
+  uint8_t m_Small = 0;
+  uint16_t m_Column = 0;
+  uint32_t m_Lexeme = 0;
+  uint32_t m_Offset = 0;
+  uint32_t m_Line = 0;
 
 public:
   TokenType type() const;
@@ -66,17 +82,26 @@ public:
   std::string to_xml() const;
 
   const std::string get_str_data() const;
+  std::string_view text() const;
+  uint32_t lexeme() const;
+  enum Keyword get_keyword() const;
+  char get_punct() const;
+
   int get_line_number() const;
   void set_line_number(const int &line_number);
+  SourceSpan span() const;
+  void set_span(const SourceSpan &span);
 
-  static Token identifier(const std::string &ident);
-  static Token function_name(const std::string &ident);
-  static Token string_lit(const std::string &literal);
-  static Token num_lit(const std::string &literal);
+  static Token identifier(std::string_view ident);
+  static Token function_name(std::string_view ident);
+  static Token string_lit(std::string_view literal);
+  static Token num_lit(std::string_view literal);
   static Token keyword(enum Keyword keyword);
   static Token punct(char punct);
 };
 
+static_assert(sizeof(Token) == 16, "Token must stay a compact 16-byte record");
+
 std::ostream &operator<<(std::ostream &stream, const Token &token);
 
 #endif
@@ -1,57 +1,62 @@
 #ifndef TYPECHECKER_H
 #define TYPECHECKER_H
 
+#include "ast_visitor.h"
+#include <array>
+#include "diagnostics.h"
 #include "parser.h"
 #include <unordered_map>
 #include <string>
 #include "symbol.h"
 
-struct TypeError : public std::exception
+// Checks declarations and types over the syntax tree. Node kinds are
+// dispatched through AstVisitor; every visit returns the type of the
+// visited expression, or TypeId::Void for declarations and statements.
+// Errors are collected rather than thrown: an ill-typed expression gets
+// TypeId::Error and checking carries on, so one run reports every error.
+class TypeChecker : private AstVisitor<TypeChecker, TypeId>
 {
-private:
-  std::string msg;
-
 public:
-  explicit TypeError(const std::string &msg, std::string filename, const int &line);
-  explicit TypeError(const std::string &msg);
-  const char *what() const noexcept override;
-};
+  explicit TypeChecker(SyntaxTreeNode *root, std::size_t errorLimit = DiagnosticEngine::DEFAULT_LIMIT);
 
-class TypeChecker
-{
-public:
-  TypeChecker(SyntaxTreeNode *root);
-  void check();
-  void setFilename(const std::string &filename);
+  // checks the whole program; the report is empty if it is well typed
+  DiagnosticReport check();
 
 private:
-  std::string filename;
+  friend class AstVisitor<TypeChecker, TypeId>;
+
+  using CallArgTypes = std::array<TypeId, 3>;
+
   SyntaxTreeNode *root;
   std::shared_ptr<SymbolTable> symbolTable;
+  DiagnosticEngine diagnostics;
+
+  void error(const SyntaxTreeNode *node, std::string message);
+
+  TypeId visitProg(SyntaxTreeNode *node);
+  TypeId visitGlobVars(SyntaxTreeNode *node);
+  TypeId visitAlgo(SyntaxTreeNode *node);
+  TypeId visitInstruc(SyntaxTreeNode *node);
+  TypeId visitCommand(SyntaxTreeNode *node);
+  TypeId visitAtomic(SyntaxTreeNode *node);
+  TypeId visitAssign(SyntaxTreeNode *node);
+  TypeId visitCall(SyntaxTreeNode *node);
+  TypeId visitBranch(SyntaxTreeNode *node);
+  TypeId visitTerm(SyntaxTreeNode *node);
+  TypeId visitOp(SyntaxTreeNode *node);
+  TypeId visitArg(SyntaxTreeNode *node);
+  TypeId visitCond(SyntaxTreeNode *node);
+  TypeId visitSimple(SyntaxTreeNode *node);
+  TypeId visitComposit(SyntaxTreeNode *node);
+  TypeId visitFunctions(SyntaxTreeNode *node);
+  TypeId visitDecl(SyntaxTreeNode *node);
+  TypeId visitHeader(SyntaxTreeNode *node);
+  TypeId visitBody(SyntaxTreeNode *node);
+  TypeId visitLocVars(SyntaxTreeNode *node);
 
-  void checkProgram(SyntaxTreeNode *node);
-  void checkGlobVars(SyntaxTreeNode *node);
-  void checkAlgo(SyntaxTreeNode *node);
-  void checkInstruc(SyntaxTreeNode *node);
-  void checkCommand(SyntaxTreeNode *node);
-  std::string checkAtomic(SyntaxTreeNode *node);
-  void checkAssign(SyntaxTreeNode *node);
-  std::optional<std::string> checkCall(SyntaxTreeNode *node);
-  void checkFunctionArguments(const Symbol &functionSymbol, std::vector<std::string> argTypes, int lineNumber);
-  void checkBranch(SyntaxTreeNode *node);
-  std::string checkTerm(SyntaxTreeNode *node);
-  std::string checkOp(SyntaxTreeNode *node);
-  std::string checkCond(SyntaxTreeNode *node);
-  std::string checkSimple(SyntaxTreeNode *node);
-  std::string checkComposit(SyntaxTreeNode *node);
-  std::string checkUnop(SyntaxTreeNode *node, SyntaxTreeNode *argNode);
-  std::string checkBinop(SyntaxTreeNode *node, SyntaxTreeNode *leftArgNode, SyntaxTreeNode *rightArgNode);
-  std::string checkArg(SyntaxTreeNode *node);
-  void checkFunctions(SyntaxTreeNode *node);
-  void checkDecl(SyntaxTreeNode *node);
-  void checkHeader(SyntaxTreeNode *node);
-  void checkBody(SyntaxTreeNode *node);
-  void checkLocVars(SyntaxTreeNode *node);
+  void checkFunctionArguments(const Symbol &functionSymbol, const CallArgTypes &argTypes, const SyntaxTreeNode *callNode);
+  TypeId checkUnop(SyntaxTreeNode *node, SyntaxTreeNode *argNode);
+  TypeId checkBinop(SyntaxTreeNode *node, SyntaxTreeNode *leftArgNode, SyntaxTreeNode *rightArgNode);
 };
 
-#endif // TYPECHECKER_H
\ No newline at end of file
+#endif // TYPECHECKER_H
@@ -0,0 +1,40 @@
+#ifndef SPL_VM_H
+#define SPL_VM_H
+
+#include <bytecode.h>
+#include <istream>
+#include <ostream>
+
+// Register machine running compiled bytecode. Frames live on one growing
+// stack of registers, so recursion is only bounded by MAX_DEPTH, not by
+// the native stack.
+class VM {
+public:
+  static constexpr std::size_t MAX_DEPTH = 1 << 20;
+
+  VM(const Bytecode &bytecode, std::istream &in, std::ostream &out);
+
+  // runs main until it halts; throws std::runtime_error if the input is
+  // not a number when one is read, or calls nest deeper than MAX_DEPTH
+  void run();
+
+  // instructions run so far
+  uint64_t executed() const { return this->m_Executed; }
+
+private:
+  struct Return {
+    const BytecodeInstruction *pc;
+    std::size_t frame;
+    uint32_t dst;
+  };
+
+  const Bytecode &m_Bytecode;
+  std::istream &m_In;
+  std::ostream &m_Out;
+  std::vector<BytecodeValue> m_Statics;
+  std::vector<BytecodeValue> m_Stack;
+  std::vector<Return> m_Calls;
+  uint64_t m_Executed = 0;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <arena.h>
+#include <cstdint>
+
+namespace {
+
+char *align_up(char *pointer, std::size_t alignment) {
+  auto address = reinterpret_cast<std::uintptr_t>(pointer);
+  return reinterpret_cast<char *>((address + alignment - 1) &
+                                  ~(alignment - 1));
+}
+
+} // namespace
+
+void *Arena::allocate(std::size_t size, std::size_t alignment) {
+  if (this->m_Cursor) {
+    char *start = align_up(this->m_Cursor, alignment);
+    if (start + size <= this->m_End) {
+      this->m_Cursor = start + size;
+      return start;
+    }
+  }
+
+  // blocks are left uninitialised; every object is constructed in place
+  std::size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+  this->m_Blocks.emplace_back(new char[blockSize]);
+  char *block = this->m_Blocks.back().get();
+  char *start = align_up(block, alignment);
+
+  // an oversized request gets a block of its own, and bumping continues in
+  // the current block
+  if (blockSize == BLOCK_SIZE) {
+    this->m_Cursor = start + size;
+    this->m_End = block + blockSize;
+  }
+  return start;
+}
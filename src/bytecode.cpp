@@ -0,0 +1,198 @@
+#include <bytecode.h>
+#include <stdexcept>
+
+namespace {
+BytecodeValue zero_of(TypeId type) {
+  BytecodeValue value;
+  if (type == TypeId::Text) {
+    value.text = Interner::global().intern("");
+  } else {
+    value.number = 0;
+  }
+  return value;
+}
+
+// the bytecode for an operation on values of the given type
+BytecodeOpcode typed(IMCOpcode opcode, TypeId type) {
+  bool text = type == TypeId::Text;
+  switch (opcode) {
+  case IMCOpcode::Copy:
+    return BytecodeOpcode::Move;
+  case IMCOpcode::Add:
+    return BytecodeOpcode::Add;
+  case IMCOpcode::Sub:
+    return BytecodeOpcode::Sub;
+  case IMCOpcode::Mul:
+    return BytecodeOpcode::Mul;
+  case IMCOpcode::Div:
+    return BytecodeOpcode::Div;
+  case IMCOpcode::And:
+    return BytecodeOpcode::And;
+  case IMCOpcode::Or:
+    return BytecodeOpcode::Or;
+  case IMCOpcode::Not:
+    return BytecodeOpcode::Not;
+  case IMCOpcode::Sqrt:
+    return BytecodeOpcode::Sqrt;
+  case IMCOpcode::Eq:
+    return text ? BytecodeOpcode::EqText : BytecodeOpcode::Eq;
+  case IMCOpcode::Grt:
+    return text ? BytecodeOpcode::GrtText : BytecodeOpcode::Grt;
+  case IMCOpcode::JumpIfEq:
+    return text ? BytecodeOpcode::JumpIfEqText : BytecodeOpcode::JumpIfEq;
+  case IMCOpcode::JumpIfGrt:
+    return text ? BytecodeOpcode::JumpIfGrtText : BytecodeOpcode::JumpIfGrt;
+  case IMCOpcode::Print:
+    return text ? BytecodeOpcode::PrintText : BytecodeOpcode::Print;
+  default:
+    throw std::logic_error("No bytecode for " +
+                           std::string(opcode_name(opcode)));
+  }
+}
+} // namespace
+
+Bytecode compile_bytecode(const IMCProgram &program) {
+  Bytecode bytecode;
+  std::vector<uint32_t> owners = program.owners();
+  uint32_t variables = static_cast<uint32_t>(program.variables.size());
+
+  for (const IMCVariable &variable : program.variables) {
+    bytecode.statics.push_back(zero_of(variable.type));
+  }
+  for (std::size_t i = 0; i < program.constants.size(); i++) {
+    const IMCConstantPool::Constant &constant = program.constants.get(i);
+    BytecodeValue value;
+    if (constant.type == TypeId::Text) {
+      value.text = constant.text;
+    } else {
+      value.number = constant.number;
+    }
+    bytecode.statics.push_back(value);
+  }
+
+  for (uint32_t index = 0; index < program.functions.size(); index++) {
+    const IMCFunction &function = program.functions[index];
+    BytecodeFunction lowered{
+        function.name, static_cast<uint32_t>(bytecode.code.size()),
+        static_cast<uint32_t>(function.params.size()), 0, {}};
+
+    // the frame holds the parameters, then the function's own variables,
+    // then its temporaries; parameters other functions can see are moved
+    // to their static register on entry
+    std::vector<uint32_t> registers(variables, Bytecode::NONE);
+    uint32_t next = lowered.params;
+    for (uint32_t i = 0; i < lowered.params; i++) {
+      uint32_t variable = IMCOperand::index(function.params[i]);
+      if (owners[variable] == index) {
+        registers[variable] = i;
+      } else {
+        bytecode.code.push_back(BytecodeInstruction{
+            BytecodeOpcode::Move, Bytecode::STATIC | variable, i});
+      }
+    }
+    for (uint32_t variable = 0; variable < variables; variable++) {
+      if (owners[variable] == index && registers[variable] == Bytecode::NONE) {
+        registers[variable] = next++;
+        lowered.initial.push_back(zero_of(program.variables[variable].type));
+      }
+    }
+    uint32_t temps = next;
+    for (TypeId type : function.temps) {
+      lowered.initial.push_back(zero_of(type));
+    }
+    lowered.frame_size = temps + static_cast<uint32_t>(function.temps.size());
+
+    auto reg = [&](OperandId operand) -> uint32_t {
+      uint32_t i = IMCOperand::index(operand);
+      switch (IMCOperand::kind(operand)) {
+      case IMCOperand::Kind::Variable:
+        return registers[i] != Bytecode::NONE ? registers[i]
+                                              : Bytecode::STATIC | i;
+      case IMCOperand::Kind::Temp:
+        return temps + i;
+      case IMCOperand::Kind::Constant:
+        return Bytecode::STATIC | (variables + i);
+      default:
+        return Bytecode::NONE;
+      }
+    };
+
+    // jumps are patched once every label of the function is placed
+    std::vector<uint32_t> labels(function.label_count, Bytecode::NONE);
+    std::vector<std::size_t> jumps;
+    uint32_t argument = 0;
+    for (std::size_t at = 0; at < function.code.size(); at++) {
+      const IMCInstruction &instruction = function.code[at];
+      std::vector<BytecodeInstruction> &code = bytecode.code;
+      TypeId type = instruction.src1 == IMCOperand::NONE
+                        ? TypeId::Void
+                        : program.type_of(function, instruction.src1);
+      switch (instruction.opcode) {
+      case IMCOpcode::Label:
+        labels[instruction.dst] = static_cast<uint32_t>(code.size());
+        break;
+      case IMCOpcode::Arg:
+        // straight into the register the callee will see it in
+        code.push_back(BytecodeInstruction{BytecodeOpcode::Move,
+                                           lowered.frame_size + argument++,
+                                           reg(instruction.src1)});
+        break;
+      case IMCOpcode::Call:
+        // the return after a tail call is left in place, but never runs
+        code.push_back(BytecodeInstruction{
+            program.tail_call(owners, index, at) ? BytecodeOpcode::TailCall
+                                                 : BytecodeOpcode::Call,
+            reg(instruction.dst), instruction.src1, lowered.frame_size});
+        argument = 0;
+        break;
+      case IMCOpcode::Input:
+        code.push_back(
+            BytecodeInstruction{BytecodeOpcode::Input, reg(instruction.dst)});
+        break;
+      case IMCOpcode::Jump:
+        jumps.push_back(code.size());
+        code.push_back(
+            BytecodeInstruction{BytecodeOpcode::Jump, instruction.dst});
+        break;
+      case IMCOpcode::JumpIfEq:
+      case IMCOpcode::JumpIfGrt:
+        jumps.push_back(code.size());
+        code.push_back(BytecodeInstruction{
+            typed(instruction.opcode, type), instruction.dst,
+            reg(instruction.src1), reg(instruction.src2)});
+        break;
+      case IMCOpcode::Print:
+        code.push_back(BytecodeInstruction{typed(instruction.opcode, type), 0,
+                                           reg(instruction.src1)});
+        break;
+      case IMCOpcode::Return:
+        code.push_back(BytecodeInstruction{BytecodeOpcode::Return,
+                                           reg(instruction.src1)});
+        break;
+      case IMCOpcode::Halt:
+        code.push_back(BytecodeInstruction{BytecodeOpcode::Halt});
+        break;
+      case IMCOpcode::And:
+      case IMCOpcode::Or:
+      case IMCOpcode::Not:
+        // the type checker allows logic on numbers only
+        if (type == TypeId::Text) {
+          throw std::logic_error(std::string(opcode_name(instruction.opcode)) +
+                                 " of text in " + function.name);
+        }
+        [[fallthrough]];
+      default:
+        code.push_back(BytecodeInstruction{
+            typed(instruction.opcode, type), reg(instruction.dst),
+            reg(instruction.src1),
+            source_count(instruction.opcode) > 1 ? reg(instruction.src2)
+                                                 : Bytecode::NONE});
+      }
+    }
+    for (std::size_t jump : jumps) {
+      bytecode.code[jump].a = labels[bytecode.code[jump].a];
+    }
+    bytecode.functions.push_back(std::move(lowered));
+  }
+  return bytecode;
+}
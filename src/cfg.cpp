@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cfg.h>
+#include <stdexcept>
+
+CFG::CFG(const IMCFunction &function) {
+  // a label opens a new block unless the current one is still empty, in
+  // which case the label just names it too; a jump, return or halt closes
+  // the current block. The entry is never named, so that no jump leads
+  // back to it and values on entry only come from the caller.
+  std::vector<uint32_t> label_blocks(function.label_count, NONE);
+  this->m_Blocks.push_back(BasicBlock{NONE, {}, {}, {}, {}});
+  bool closed = false;
+  for (const IMCInstruction &instruction : function.code) {
+    if (instruction.opcode == IMCOpcode::Label) {
+      BasicBlock &current = this->m_Blocks.back();
+      if (!current.code.empty() || closed || this->m_Blocks.size() == 1) {
+        this->m_Blocks.push_back(BasicBlock{instruction.dst, {}, {}, {}, {}});
+        closed = false;
+      } else if (current.label == NONE) {
+        current.label = instruction.dst;
+      }
+      label_blocks[instruction.dst] =
+          static_cast<uint32_t>(this->m_Blocks.size() - 1);
+      continue;
+    }
+
+    if (closed) {
+      this->m_Blocks.push_back(BasicBlock{NONE, {}, {}, {}, {}});
+      closed = false;
+    }
+    this->m_Blocks.back().code.push_back(instruction);
+    closed = is_jump(instruction.opcode) || is_terminator(instruction.opcode);
+  }
+
+  // jumps are pointed at the label their target block goes by
+  uint32_t count = static_cast<uint32_t>(this->m_Blocks.size());
+  for (uint32_t i = 0; i < count; i++) {
+    BasicBlock &block = this->m_Blocks[i];
+    IMCOpcode last =
+        block.code.empty() ? IMCOpcode::Label : block.code.back().opcode;
+    if (is_jump(last)) {
+      uint32_t target = label_blocks[block.code.back().dst];
+      block.code.back().dst = this->m_Blocks[target].label;
+      this->link(i, target);
+    }
+    if (!is_terminator(last) && i + 1 < count) {
+      this->link(i, i + 1);
+    }
+  }
+}
+
+void CFG::link(uint32_t from, uint32_t to) {
+  this->m_Blocks[from].successors.push_back(to);
+  this->m_Blocks[to].predecessors.push_back(from);
+}
+
+void CFG::compute_dominators() {
+  std::size_t count = this->m_Blocks.size();
+
+  // depth-first postorder from the entry with an explicit stack of
+  // (block, next successor to visit)
+  std::vector<uint32_t> postorder;
+  std::vector<bool> visited(count, false);
+  std::vector<std::pair<uint32_t, std::size_t>> stack = {{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto &[block, next] = stack.back();
+    const std::vector<uint32_t> &successors = this->m_Blocks[block].successors;
+    if (next < successors.size()) {
+      uint32_t successor = successors[next++];
+      if (!visited[successor]) {
+        visited[successor] = true;
+        stack.emplace_back(successor, 0);
+      }
+      continue;
+    }
+    postorder.push_back(block);
+    stack.pop_back();
+  }
+
+  this->m_Order.assign(postorder.rbegin(), postorder.rend());
+  this->m_OrderIndex.assign(count, NONE);
+  for (std::size_t i = 0; i < this->m_Order.size(); i++) {
+    this->m_OrderIndex[this->m_Order[i]] = static_cast<uint32_t>(i);
+  }
+
+  // a block's immediate dominator is where the dominator chains of its
+  // processed predecessors meet; iterate in reverse postorder until stable
+  auto intersect = [&](uint32_t a, uint32_t b) {
+    while (a != b) {
+      while (this->m_OrderIndex[a] > this->m_OrderIndex[b]) {
+        a = this->m_Idom[a];
+      }
+      while (this->m_OrderIndex[b] > this->m_OrderIndex[a]) {
+        b = this->m_Idom[b];
+      }
+    }
+    return a;
+  };
+
+  this->m_Idom.assign(count, NONE);
+  this->m_Idom[0] = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (std::size_t i = 1; i < this->m_Order.size(); i++) {
+      uint32_t block = this->m_Order[i];
+      uint32_t idom = NONE;
+      for (uint32_t predecessor : this->m_Blocks[block].predecessors) {
+        if (this->m_Idom[predecessor] == NONE) {
+          continue;
+        }
+        idom = idom == NONE ? predecessor : intersect(predecessor, idom);
+      }
+      if (this->m_Idom[block] != idom) {
+        this->m_Idom[block] = idom;
+        changed = true;
+      }
+    }
+  }
+}
+
+bool CFG::dominates(uint32_t dominator, uint32_t block) const {
+  if (!this->reachable(block) || !this->reachable(dominator)) {
+    return false;
+  }
+  while (block != dominator && block != 0) {
+    block = this->m_Idom[block];
+  }
+  return block == dominator;
+}
+
+std::vector<std::vector<uint32_t>> CFG::dominator_tree() const {
+  std::vector<std::vector<uint32_t>> children(this->m_Blocks.size());
+  for (std::size_t i = 1; i < this->m_Order.size(); i++) {
+    uint32_t block = this->m_Order[i];
+    children[this->m_Idom[block]].push_back(block);
+  }
+  return children;
+}
+
+std::vector<std::vector<uint32_t>> CFG::dominance_frontiers() const {
+  // a join point is in the frontier of every block on the dominator chains
+  // of its predecessors, up to its own immediate dominator
+  std::vector<std::vector<uint32_t>> frontiers(this->m_Blocks.size());
+  for (uint32_t block : this->m_Order) {
+    const std::vector<uint32_t> &predecessors =
+        this->m_Blocks[block].predecessors;
+    if (predecessors.size() < 2) {
+      continue;
+    }
+    for (uint32_t runner : predecessors) {
+      if (!this->reachable(runner)) {
+        continue;
+      }
+      while (runner != this->m_Idom[block]) {
+        std::vector<uint32_t> &frontier = frontiers[runner];
+        if (frontier.empty() || frontier.back() != block) {
+          frontier.push_back(block);
+        }
+        runner = this->m_Idom[runner];
+      }
+    }
+  }
+  return frontiers;
+}
+
+uint32_t CFG::split_edge(IMCFunction &function, uint32_t from, uint32_t to) {
+  if (this->m_Blocks[to].label == NONE) {
+    this->m_Blocks[to].label = function.new_label();
+  }
+
+  uint32_t middle = static_cast<uint32_t>(this->m_Blocks.size());
+  this->m_Blocks.push_back(BasicBlock{
+      function.new_label(),
+      {},
+      {IMCInstruction{IMCOpcode::Jump, this->m_Blocks[to].label}},
+      {to},
+      {from}});
+
+  BasicBlock &source = this->m_Blocks[from];
+  auto successor =
+      std::find(source.successors.begin(), source.successors.end(), to);
+  *successor = middle;
+  if (successor == source.successors.begin() && !source.code.empty() &&
+      is_jump(source.code.back().opcode)) {
+    source.code.back().dst = this->m_Blocks[middle].label;
+  }
+
+  std::vector<uint32_t> &predecessors = this->m_Blocks[to].predecessors;
+  *std::find(predecessors.begin(), predecessors.end(), from) = middle;
+  return middle;
+}
+
+void CFG::remove_predecessor(uint32_t block, std::size_t index) {
+  BasicBlock &target = this->m_Blocks[block];
+  target.predecessors.erase(target.predecessors.begin() + index);
+  for (Phi &phi : target.phis) {
+    phi.args.erase(phi.args.begin() + index);
+  }
+}
+
+void CFG::remove_edge(uint32_t from, std::size_t slot) {
+  std::vector<uint32_t> &successors = this->m_Blocks[from].successors;
+  uint32_t to = successors[slot];
+  successors.erase(successors.begin() + slot);
+
+  const std::vector<uint32_t> &predecessors = this->m_Blocks[to].predecessors;
+  this->remove_predecessor(
+      to, std::find(predecessors.begin(), predecessors.end(), from) -
+              predecessors.begin());
+}
+
+std::size_t CFG::remove_unreachable() {
+  std::size_t count = this->m_Blocks.size();
+  std::vector<bool> reached(count, false);
+  std::vector<uint32_t> work = {0};
+  reached[0] = true;
+  while (!work.empty()) {
+    uint32_t block = work.back();
+    work.pop_back();
+    for (uint32_t successor : this->m_Blocks[block].successors) {
+      if (!reached[successor]) {
+        reached[successor] = true;
+        work.push_back(successor);
+      }
+    }
+  }
+
+  // the survivors forget their dead predecessors, then move down over the
+  // gaps
+  for (uint32_t block = 0; block < count; block++) {
+    std::vector<uint32_t> &predecessors = this->m_Blocks[block].predecessors;
+    for (std::size_t j = predecessors.size(); reached[block] && j-- > 0;) {
+      if (!reached[predecessors[j]]) {
+        this->remove_predecessor(block, j);
+      }
+    }
+  }
+
+  std::vector<uint32_t> renumbered(count, NONE);
+  std::size_t removed = 0;
+  uint32_t kept = 0;
+  for (uint32_t block = 0; block < count; block++) {
+    if (!reached[block]) {
+      removed += this->m_Blocks[block].code.size();
+      continue;
+    }
+    renumbered[block] = kept;
+    if (kept != block) {
+      this->m_Blocks[kept] = std::move(this->m_Blocks[block]);
+    }
+    kept++;
+  }
+  this->m_Blocks.resize(kept);
+  for (BasicBlock &block : this->m_Blocks) {
+    for (uint32_t &successor : block.successors) {
+      successor = renumbered[successor];
+    }
+    for (uint32_t &predecessor : block.predecessors) {
+      predecessor = renumbered[predecessor];
+    }
+  }
+
+  this->m_Idom.clear();
+  this->m_Order.clear();
+  this->m_OrderIndex.clear();
+  return removed;
+}
+
+void CFG::flatten(IMCFunction &function) {
+  uint32_t count = static_cast<uint32_t>(this->m_Blocks.size());
+
+  // the block control falls through to at the end of a block, or NONE
+  auto fallthrough = [&](const BasicBlock &block) {
+    IMCOpcode last =
+        block.code.empty() ? IMCOpcode::Label : block.code.back().opcode;
+    if (is_terminator(last) || block.successors.empty()) {
+      return NONE;
+    }
+    return is_jump(last) ? block.successors[1] : block.successors[0];
+  };
+
+  std::vector<IMCInstruction> code;
+  std::vector<bool> targeted(function.label_count, false);
+  for (uint32_t i = 0; i < count; i++) {
+    BasicBlock &block = this->m_Blocks[i];
+    if (!block.phis.empty()) {
+      throw std::logic_error("Cannot flatten a block with phis");
+    }
+    if (block.label != NONE) {
+      code.push_back(IMCInstruction{IMCOpcode::Label, block.label});
+    }
+
+    std::size_t size = block.code.size();
+    // a jump to the very next block is left out
+    if (size > 0 && block.code.back().opcode == IMCOpcode::Jump &&
+        block.successors[0] == i + 1) {
+      size--;
+    }
+    code.insert(code.end(), block.code.begin(), block.code.begin() + size);
+
+    uint32_t next = fallthrough(block);
+    if (next != NONE && next != i + 1) {
+      BasicBlock &target = this->m_Blocks[next];
+      if (target.label == NONE) {
+        target.label = function.new_label();
+        targeted.resize(function.label_count, false);
+      }
+      code.push_back(IMCInstruction{IMCOpcode::Jump, target.label});
+    }
+  }
+
+  // labels nothing jumps to any more are dropped
+  for (const IMCInstruction &instruction : code) {
+    if (is_jump(instruction.opcode)) {
+      targeted[instruction.dst] = true;
+    }
+  }
+  code.erase(std::remove_if(code.begin(), code.end(),
+                            [&](const IMCInstruction &instruction) {
+                              return instruction.opcode == IMCOpcode::Label &&
+                                     !targeted[instruction.dst];
+                            }),
+             code.end());
+  function.code = std::move(code);
+}
+
+std::string CFG::to_string(const IMCProgram &program) const {
+  std::string text;
+  for (std::size_t i = 0; i < this->m_Blocks.size(); i++) {
+    const BasicBlock &block = this->m_Blocks[i];
+    text += "B" + std::to_string(i);
+    if (block.label != NONE) {
+      text += " (L" + std::to_string(block.label + 1) + ")";
+    }
+    text += ":\n";
+    for (const Phi &phi : block.phis) {
+      text += "  " + program.operand_string(phi.dst) + " := PHI(";
+      for (std::size_t j = 0; j < phi.args.size(); j++) {
+        text += (j ? ", " : "") + program.operand_string(phi.args[j]);
+      }
+      text += ")\n";
+    }
+    for (const IMCInstruction &instruction : block.code) {
+      text += "  " + program.instruction_string(instruction) + "\n";
+    }
+    if (!block.successors.empty()) {
+      text += "  ->";
+      for (uint32_t successor : block.successors) {
+        text += " B" + std::to_string(successor);
+      }
+      text += "\n";
+    }
+  }
+  return text;
+}
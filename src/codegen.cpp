@@ -0,0 +1,793 @@
+#include <cmath>
+#include <codegen.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <regalloc.h>
+#include <stdexcept>
+
+namespace {
+// printing, input and the operations on text that compiled programs call;
+// numbers are printed exactly like format_number() does
+const char *RUNTIME = R"(/* SPL runtime */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void spl_main(void);
+
+void spl_print_number(double x) {
+  char buffer[32];
+  if (x == trunc(x) && fabs(x) < 1e15) {
+    snprintf(buffer, sizeof buffer, "%.0f", x);
+  } else {
+    for (int precision = 1; precision <= 17; precision++) {
+      snprintf(buffer, sizeof buffer, "%.*g", precision, x);
+      if (strtod(buffer, NULL) == x) {
+        break;
+      }
+    }
+  }
+  puts(buffer);
+}
+
+void spl_print_text(const char *text) { puts(text); }
+
+double spl_input(void) {
+  double x;
+  if (scanf("%lf", &x) != 1) {
+    fflush(stdout);
+    fputs("error: expected a number on the input\n", stderr);
+    exit(1);
+  }
+  return x;
+}
+
+int spl_text_grt(const char *a, const char *b) { return strcmp(a, b) > 0; }
+
+void spl_halt(void) {
+  fflush(stdout);
+  exit(0);
+}
+
+int main(void) {
+  spl_main();
+  return 0;
+}
+)";
+
+// C and GAS share the escapes of string literals
+std::string quote(std::string_view text) {
+  std::string quoted = "\"";
+  for (unsigned char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += static_cast<char>(c);
+    } else if (c < 0x20 || c >= 0x7F) {
+      char escape[8];
+      std::snprintf(escape, sizeof(escape), "\\%03o", c);
+      quoted += escape;
+    } else {
+      quoted += static_cast<char>(c);
+    }
+  }
+  return quoted + "\"";
+}
+
+std::string function_name(std::size_t index) {
+  return index == 0 ? "spl_main" : "spl_f" + std::to_string(index);
+}
+
+// and, or and not apply to numbers only, which the type checker ensures
+void expect_number_logic(bool text, const IMCInstruction &instruction,
+                         const IMCFunction &function) {
+  if (text) {
+    throw std::logic_error(std::string(opcode_name(instruction.opcode)) +
+                           " of text in " + function.name);
+  }
+}
+
+// What both backends need to know about the program as a whole: where
+// each variable lives and the table of text constants, which always holds
+// "" as the value text variables start with. Equal texts are the same
+// entry, so text compares for equality by address.
+struct Layout {
+  explicit Layout(const IMCProgram &program)
+      : program(program), owners(program.owners()) {
+    text(Interner::global().intern(""));
+    for (std::size_t i = 0; i < program.constants.size(); i++) {
+      const IMCConstantPool::Constant &constant = program.constants.get(i);
+      if (constant.type == TypeId::Text) {
+        text(constant.text);
+      }
+    }
+  }
+
+  // name of a text's entry in the table
+  std::string text(Interner::Id id) {
+    auto [it, inserted] =
+        this->texts.try_emplace(id, static_cast<uint32_t>(this->texts.size()));
+    if (inserted) {
+      this->order.push_back(id);
+    }
+    return "spl_t" + std::to_string(it->second);
+  }
+  std::string empty_text() { return "spl_t0"; }
+
+  // C initializer for the value a variable of the type starts with
+  std::string initial(TypeId type) {
+    return type == TypeId::Text ? "{.t = " + this->empty_text() + "}"
+                                : "{.n = 0}";
+  }
+
+  bool shared(uint32_t variable, std::size_t function) const {
+    return this->owners[variable] != function;
+  }
+
+  const IMCProgram &program;
+  std::vector<uint32_t> owners;
+  std::map<Interner::Id, uint32_t> texts;
+  std::vector<Interner::Id> order;
+};
+
+std::string c_number(double number) {
+  if (std::isnan(number)) {
+    return "(0.0 / 0.0)";
+  }
+  if (std::isinf(number)) {
+    return number > 0 ? "(1.0 / 0.0)" : "(-1.0 / 0.0)";
+  }
+  char buffer[40];
+  std::snprintf(buffer, sizeof(buffer), "%a", number);
+  return buffer;
+}
+
+// C: every value is a spl_value, temporaries share locals by allocation
+class CEmitter {
+public:
+  CEmitter(Layout &layout, std::size_t index)
+      : m_Layout(layout), m_Program(layout.program), m_Index(index),
+        m_Function(layout.program.functions[index]),
+        m_Allocation(allocate_registers(m_Function, UINT32_MAX)) {}
+
+  std::string signature() const {
+    std::string text = this->m_Index == 0 ? "void " : "static spl_value ";
+    for (std::size_t at = 0; at < this->m_Function.code.size(); at++) {
+      if (this->m_Function.code[at].opcode == IMCOpcode::Call &&
+          this->m_Program.tail_call(this->m_Layout.owners, this->m_Index,
+                                    at)) {
+        text = "SPL_TAIL_CALLER " + text;
+        break;
+      }
+    }
+    text += function_name(this->m_Index) + "(";
+    for (std::size_t i = 0; i < this->m_Function.params.size(); i++) {
+      text += (i ? ", spl_value p" : "spl_value p") + std::to_string(i);
+    }
+    return text + (this->m_Function.params.empty() ? "void)" : ")");
+  }
+
+  std::string emit() {
+    std::string text =
+        "/* " + this->m_Function.name + " */\n" + this->signature() + " {\n";
+    for (uint32_t v = 0; v < this->m_Program.variables.size(); v++) {
+      if (!this->m_Layout.shared(v, this->m_Index)) {
+        text += "  spl_value v" + std::to_string(v) + " = " +
+                this->m_Layout.initial(this->m_Program.variables[v].type) +
+                ";\n";
+      }
+    }
+    for (uint32_t r = 0; r < this->m_Allocation.used; r++) {
+      text += "  spl_value r" + std::to_string(r) + " = {0};\n";
+    }
+    for (std::size_t i = 0; i < this->m_Function.params.size(); i++) {
+      text += "  " + this->value(this->m_Function.params[i]) + " = p" +
+              std::to_string(i) + ";\n";
+    }
+
+    std::vector<OperandId> arguments;
+    for (std::size_t at = 0; at < this->m_Function.code.size(); at++) {
+      const IMCInstruction &instruction = this->m_Function.code[at];
+      if (instruction.opcode == IMCOpcode::Arg) {
+        arguments.push_back(instruction.src1);
+        continue;
+      }
+      if (instruction.opcode == IMCOpcode::Label) {
+        text += "L" + std::to_string(instruction.dst) + ":;\n";
+        continue;
+      }
+      bool tail = instruction.opcode == IMCOpcode::Call &&
+                  this->m_Program.tail_call(this->m_Layout.owners,
+                                            this->m_Index, at);
+      text += "  " + this->statement(instruction, arguments, tail) + "\n";
+      if (instruction.opcode == IMCOpcode::Call) {
+        arguments.clear();
+      }
+    }
+    return text + "}\n";
+  }
+
+private:
+  std::string value(OperandId operand) {
+    uint32_t index = IMCOperand::index(operand);
+    switch (IMCOperand::kind(operand)) {
+    case IMCOperand::Kind::Temp:
+      return "r" + std::to_string(this->m_Allocation.registers[index]);
+    case IMCOperand::Kind::Variable:
+      return (this->m_Layout.shared(index, this->m_Index) ? "spl_v" : "v") +
+             std::to_string(index);
+    case IMCOperand::Kind::Constant: {
+      const IMCConstantPool::Constant &constant =
+          this->m_Program.constants.get(index);
+      return constant.type == TypeId::Text
+                 ? "spl_text(" + this->m_Layout.text(constant.text) + ")"
+                 : "spl_num(" + c_number(constant.number) + ")";
+    }
+    default:
+      return "spl_num(0)";
+    }
+  }
+
+  std::string number(OperandId operand) {
+    if (IMCOperand::kind(operand) == IMCOperand::Kind::Constant) {
+      return c_number(
+          this->m_Program.constants.get(IMCOperand::index(operand)).number);
+    }
+    return this->value(operand) + ".n";
+  }
+
+  std::string text(OperandId operand) {
+    if (IMCOperand::kind(operand) == IMCOperand::Kind::Constant) {
+      return this->m_Layout.text(
+          this->m_Program.constants.get(IMCOperand::index(operand)).text);
+    }
+    return this->value(operand) + ".t";
+  }
+
+  bool is_text(OperandId operand) const {
+    return this->m_Program.type_of(this->m_Function, operand) == TypeId::Text;
+  }
+
+  std::string statement(const IMCInstruction &instruction,
+                        const std::vector<OperandId> &arguments, bool tail) {
+    std::string dst =
+        writes_dst(instruction.opcode) && instruction.dst != IMCOperand::NONE
+            ? this->value(instruction.dst)
+            : "";
+    std::string label = "L" + std::to_string(instruction.dst);
+    auto binary = [&](const char *op) {
+      return dst + ".n = " + this->number(instruction.src1) + " " + op + " " +
+             this->number(instruction.src2) + ";";
+    };
+
+    switch (instruction.opcode) {
+    case IMCOpcode::Copy:
+      return dst + " = " + this->value(instruction.src1) + ";";
+    case IMCOpcode::Add:
+      return binary("+");
+    case IMCOpcode::Sub:
+      return binary("-");
+    case IMCOpcode::Mul:
+      return binary("*");
+    case IMCOpcode::Div:
+      return binary("/");
+    case IMCOpcode::Grt:
+      if (this->is_text(instruction.src1)) {
+        return dst + ".n = spl_text_grt(" + this->text(instruction.src1) +
+               ", " + this->text(instruction.src2) + ");";
+      }
+      return binary(">");
+    case IMCOpcode::Eq:
+      if (this->is_text(instruction.src1)) {
+        return dst + ".n = " + this->text(instruction.src1) +
+               " == " + this->text(instruction.src2) + ";";
+      }
+      return binary("==");
+    case IMCOpcode::And:
+      expect_number_logic(this->is_text(instruction.src1), instruction,
+                          this->m_Function);
+      return dst + ".n = " + this->number(instruction.src1) + " != 0 && " +
+             this->number(instruction.src2) + " != 0;";
+    case IMCOpcode::Or:
+      expect_number_logic(this->is_text(instruction.src1), instruction,
+                          this->m_Function);
+      return dst + ".n = " + this->number(instruction.src1) + " != 0 || " +
+             this->number(instruction.src2) + " != 0;";
+    case IMCOpcode::Not:
+      expect_number_logic(this->is_text(instruction.src1), instruction,
+                          this->m_Function);
+      return dst + ".n = " + this->number(instruction.src1) + " == 0;";
+    case IMCOpcode::Sqrt:
+      return dst + ".n = sqrt(" + this->number(instruction.src1) + ");";
+    case IMCOpcode::Input:
+      return dst + ".n = spl_input();";
+    case IMCOpcode::Call: {
+      std::string call = function_name(instruction.src1) + "(";
+      for (std::size_t i = 0; i < arguments.size(); i++) {
+        call += (i ? ", " : "") + this->value(arguments[i]);
+      }
+      if (tail) {
+        // callers and callees agree on the signature, which musttail needs
+        const IMCFunction &callee = this->m_Program.functions[instruction.src1];
+        return (callee.params.size() == this->m_Function.params.size()
+                    ? "SPL_TAIL return "
+                    : "return ") +
+               call + ");";
+      }
+      return (dst.empty() ? "" : dst + " = ") + call + ");";
+    }
+    case IMCOpcode::Jump:
+      return "goto " + label + ";";
+    case IMCOpcode::JumpIfEq:
+      if (this->is_text(instruction.src1)) {
+        return "if (" + this->text(instruction.src1) + " == " +
+               this->text(instruction.src2) + ") goto " + label + ";";
+      }
+      return "if (" + this->number(instruction.src1) + " == " +
+             this->number(instruction.src2) + ") goto " + label + ";";
+    case IMCOpcode::JumpIfGrt:
+      if (this->is_text(instruction.src1)) {
+        return "if (spl_text_grt(" + this->text(instruction.src1) + ", " +
+               this->text(instruction.src2) + ")) goto " + label + ";";
+      }
+      return "if (" + this->number(instruction.src1) + " > " +
+             this->number(instruction.src2) + ") goto " + label + ";";
+    case IMCOpcode::Print:
+      return this->is_text(instruction.src1)
+                 ? "spl_print_text(" + this->text(instruction.src1) + ");"
+                 : "spl_print_number(" + this->number(instruction.src1) + ");";
+    case IMCOpcode::Return:
+      if (this->m_Index == 0) {
+        return "return;";
+      }
+      return "return " +
+             (instruction.src1 == IMCOperand::NONE
+                  ? std::string("spl_num(0)")
+                  : this->value(instruction.src1)) +
+             ";";
+    case IMCOpcode::Halt:
+      return "spl_halt();";
+    default:
+      throw std::logic_error("Cannot emit " +
+                             std::string(opcode_name(instruction.opcode)));
+    }
+  }
+
+  Layout &m_Layout;
+  const IMCProgram &m_Program;
+  std::size_t m_Index;
+  const IMCFunction &m_Function;
+  RegisterAllocation m_Allocation;
+};
+
+// x86-64: temporaries are allocated to the callee-saved registers, so
+// neither SPL calls nor runtime calls disturb them; everything else lives
+// in the frame below them or in static storage. Values are 64-bit
+// patterns: doubles, or addresses of texts. Arithmetic goes through %xmm0
+// and %xmm1, and %rax, %rcx and %rdx are scratch.
+const char *const REGISTERS[] = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+const char *const ARGUMENT_REGISTERS[] = {"%rdi", "%rsi", "%rdx",
+                                          "%rcx", "%r8",  "%r9"};
+constexpr std::size_t MAX_ARGUMENTS =
+    sizeof(ARGUMENT_REGISTERS) / sizeof(ARGUMENT_REGISTERS[0]);
+
+class AsmEmitter {
+public:
+  AsmEmitter(Layout &layout, std::size_t index)
+      : m_Layout(layout), m_Program(layout.program), m_Index(index),
+        m_Function(layout.program.functions[index]),
+        m_Allocation(allocate_registers(
+            m_Function, sizeof(REGISTERS) / sizeof(REGISTERS[0]))),
+        m_Slots(layout.program.variables.size(), 0) {
+    if (this->m_Function.params.size() > MAX_ARGUMENTS) {
+      throw std::logic_error("Too many parameters in " +
+                             this->m_Function.name);
+    }
+    for (uint32_t v = 0; v < this->m_Program.variables.size(); v++) {
+      if (!layout.shared(v, index)) {
+        this->m_Slots[v] = this->m_Frame++;
+      }
+    }
+    this->m_Spills = this->m_Frame;
+    this->m_Frame += this->m_Allocation.spilled;
+  }
+
+  std::string emit() {
+    std::string name = function_name(this->m_Index);
+    this->m_Text = "\n# " + this->m_Function.name + "\n";
+    if (this->m_Index == 0) {
+      this->m_Text += "\t.globl " + name + "\n";
+    }
+    this->m_Text += "\t.type " + name + ", @function\n" + name + ":\n";
+
+    // keep %rsp 16-byte aligned below the saved registers and the slots
+    uint32_t saved = this->m_Allocation.used;
+    uint32_t size = 8 * this->m_Frame;
+    if ((8 * saved + size) % 16 != 0) {
+      size += 8;
+    }
+    this->line("pushq %rbp");
+    this->line("movq %rsp, %rbp");
+    for (uint32_t r = 0; r < saved; r++) {
+      this->line("pushq " + std::string(REGISTERS[r]));
+    }
+    if (size > 0) {
+      this->line("subq $" + std::to_string(size) + ", %rsp");
+    }
+
+    for (uint32_t v = 0; v < this->m_Program.variables.size(); v++) {
+      if (!this->m_Layout.shared(v, this->m_Index)) {
+        this->load_zero(this->m_Program.variables[v].type, "%rax");
+        this->line("movq %rax, " + this->slot(this->m_Slots[v]));
+      }
+    }
+    for (std::size_t i = 0; i < this->m_Function.params.size(); i++) {
+      this->store(ARGUMENT_REGISTERS[i], this->m_Function.params[i]);
+    }
+
+    std::vector<OperandId> arguments;
+    for (std::size_t at = 0; at < this->m_Function.code.size(); at++) {
+      const IMCInstruction &instruction = this->m_Function.code[at];
+      if (instruction.opcode == IMCOpcode::Arg) {
+        arguments.push_back(instruction.src1);
+      } else {
+        bool tail = instruction.opcode == IMCOpcode::Call &&
+                    this->m_Program.tail_call(this->m_Layout.owners,
+                                              this->m_Index, at);
+        this->instruction(instruction, arguments, tail);
+        if (instruction.opcode == IMCOpcode::Call) {
+          arguments.clear();
+        }
+      }
+    }
+
+    this->m_Text += this->label("ret") + ":\n";
+    this->epilogue();
+    this->line("ret");
+    this->m_Text += "\t.size " + name + ", .-" + name + "\n";
+    return this->m_Text;
+  }
+
+private:
+  void line(const std::string &text) { this->m_Text += "\t" + text + "\n"; }
+
+  // restores the caller's registers and frame, leaving %rsp at the
+  // return address
+  void epilogue() {
+    uint32_t saved = this->m_Allocation.used;
+    if (saved > 0) {
+      this->line("leaq -" + std::to_string(8 * saved) + "(%rbp), %rsp");
+    }
+    for (uint32_t r = saved; r-- > 0;) {
+      this->line("popq " + std::string(REGISTERS[r]));
+    }
+    this->line("leave");
+  }
+
+  std::string label(const std::string &name) const {
+    return ".L" + std::to_string(this->m_Index) + "_" + name;
+  }
+
+  std::string slot(uint32_t index) const {
+    return "-" + std::to_string(8 * (this->m_Allocation.used + index + 1)) +
+           "(%rbp)";
+  }
+
+  // where an operand that is not a constant lives
+  std::string location(OperandId operand) const {
+    uint32_t index = IMCOperand::index(operand);
+    if (IMCOperand::kind(operand) == IMCOperand::Kind::Temp) {
+      uint32_t reg = this->m_Allocation.registers[index];
+      return reg != RegisterAllocation::SPILLED
+                 ? REGISTERS[reg]
+                 : this->slot(this->m_Spills +
+                              this->m_Allocation.slots[index]);
+    }
+    if (this->m_Layout.shared(index, this->m_Index)) {
+      return "spl_v" + std::to_string(index) + "(%rip)";
+    }
+    return this->slot(this->m_Slots[index]);
+  }
+
+  void load_zero(TypeId type, const std::string &reg) {
+    if (type == TypeId::Text) {
+      this->line("leaq " + this->m_Layout.empty_text() + "(%rip), " + reg);
+    } else {
+      this->line("movq $0, " + reg);
+    }
+  }
+
+  void load(OperandId operand, const std::string &reg) {
+    if (IMCOperand::kind(operand) != IMCOperand::Kind::Constant) {
+      this->line("movq " + this->location(operand) + ", " + reg);
+      return;
+    }
+    const IMCConstantPool::Constant &constant =
+        this->m_Program.constants.get(IMCOperand::index(operand));
+    if (constant.type == TypeId::Text) {
+      this->line("leaq " + this->m_Layout.text(constant.text) + "(%rip), " +
+                 reg);
+      return;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &constant.number, sizeof(bits));
+    this->line("movabsq $" + std::to_string(bits) + ", " + reg);
+  }
+
+  void store(const std::string &reg, OperandId operand) {
+    if (operand != IMCOperand::NONE) {
+      this->line("movq " + reg + ", " + this->location(operand));
+    }
+  }
+
+  bool is_text(OperandId operand) const {
+    return this->m_Program.type_of(this->m_Function, operand) == TypeId::Text;
+  }
+
+  // src1 and src2 into %xmm0 and %xmm1, or into %rax and %rcx for text
+  void operands(const IMCInstruction &instruction) {
+    this->load(instruction.src1, "%rax");
+    if (source_count(instruction.opcode) > 1) {
+      this->load(instruction.src2, "%rcx");
+    }
+    if (!this->is_text(instruction.src1)) {
+      this->line("movq %rax, %xmm0");
+      if (source_count(instruction.opcode) > 1) {
+        this->line("movq %rcx, %xmm1");
+      }
+    }
+  }
+
+  // %al := %xmm<n> != 0, counting NaN as true
+  void truth(const char *xmm) {
+    this->line("xorpd %xmm2, %xmm2");
+    this->line(std::string("ucomisd %xmm2, ") + xmm);
+    this->line("setne %al");
+    this->line("setp %dl");
+    this->line("orb %dl, %al");
+  }
+
+  // dst := %al as the number 1 or 0
+  void store_flag(OperandId dst) {
+    this->line("movzbl %al, %eax");
+    this->line("cvtsi2sdl %eax, %xmm0");
+    this->line("movq %xmm0, %rax");
+    this->store("%rax", dst);
+  }
+
+  void arithmetic(const IMCInstruction &instruction, const char *op) {
+    this->operands(instruction);
+    this->line(std::string(op) + " %xmm1, %xmm0");
+    this->line("movq %xmm0, %rax");
+    this->store("%rax", instruction.dst);
+  }
+
+  void instruction(const IMCInstruction &instruction,
+                   const std::vector<OperandId> &arguments, bool tail) {
+    std::string target = this->label(std::to_string(instruction.dst));
+    switch (instruction.opcode) {
+    case IMCOpcode::Copy:
+      this->load(instruction.src1, "%rax");
+      this->store("%rax", instruction.dst);
+      return;
+    case IMCOpcode::Add:
+      return this->arithmetic(instruction, "addsd");
+    case IMCOpcode::Sub:
+      return this->arithmetic(instruction, "subsd");
+    case IMCOpcode::Mul:
+      return this->arithmetic(instruction, "mulsd");
+    case IMCOpcode::Div:
+      return this->arithmetic(instruction, "divsd");
+    case IMCOpcode::Sqrt:
+      this->operands(instruction);
+      this->line("sqrtsd %xmm0, %xmm0");
+      this->line("movq %xmm0, %rax");
+      this->store("%rax", instruction.dst);
+      return;
+    case IMCOpcode::And:
+    case IMCOpcode::Or:
+      expect_number_logic(this->is_text(instruction.src1), instruction,
+                          this->m_Function);
+      this->operands(instruction);
+      this->truth("%xmm1");
+      this->line("movb %al, %cl");
+      this->truth("%xmm0");
+      this->line(instruction.opcode == IMCOpcode::And ? "andb %cl, %al"
+                                                      : "orb %cl, %al");
+      return this->store_flag(instruction.dst);
+    case IMCOpcode::Not:
+      expect_number_logic(this->is_text(instruction.src1), instruction,
+                          this->m_Function);
+      this->operands(instruction);
+      this->truth("%xmm0");
+      this->line("xorb $1, %al");
+      return this->store_flag(instruction.dst);
+    case IMCOpcode::Eq:
+      this->operands(instruction);
+      if (this->is_text(instruction.src1)) {
+        this->line("cmpq %rcx, %rax");
+        this->line("sete %al");
+      } else {
+        this->line("ucomisd %xmm1, %xmm0");
+        this->line("sete %al");
+        this->line("setnp %dl");
+        this->line("andb %dl, %al");
+      }
+      return this->store_flag(instruction.dst);
+    case IMCOpcode::Grt:
+      this->operands(instruction);
+      if (this->is_text(instruction.src1)) {
+        this->line("movq %rax, %rdi");
+        this->line("movq %rcx, %rsi");
+        this->line("call spl_text_grt");
+        this->line("testl %eax, %eax");
+        this->line("setne %al");
+      } else {
+        this->line("ucomisd %xmm1, %xmm0");
+        this->line("seta %al");
+      }
+      return this->store_flag(instruction.dst);
+    case IMCOpcode::Input:
+      this->line("call spl_input");
+      this->line("movq %xmm0, %rax");
+      this->store("%rax", instruction.dst);
+      return;
+    case IMCOpcode::Call:
+      for (std::size_t i = 0; i < arguments.size(); i++) {
+        if (i == MAX_ARGUMENTS) {
+          throw std::logic_error("Too many arguments in " +
+                                 this->m_Function.name);
+        }
+        this->load(arguments[i], ARGUMENT_REGISTERS[i]);
+      }
+      if (tail) {
+        // the callee returns straight to this function's caller
+        this->epilogue();
+        this->line("jmp " + function_name(instruction.src1));
+        return;
+      }
+      this->line("call " + function_name(instruction.src1));
+      this->store("%rax", instruction.dst);
+      return;
+    case IMCOpcode::Label:
+      this->m_Text += target + ":\n";
+      return;
+    case IMCOpcode::Jump:
+      this->line("jmp " + target);
+      return;
+    case IMCOpcode::JumpIfEq:
+      this->operands(instruction);
+      if (this->is_text(instruction.src1)) {
+        this->line("cmpq %rcx, %rax");
+        this->line("je " + target);
+      } else {
+        // unordered (NaN) compares set ZF too
+        this->line("ucomisd %xmm1, %xmm0");
+        this->line("jp 1f");
+        this->line("je " + target);
+        this->m_Text += "1:\n";
+      }
+      return;
+    case IMCOpcode::JumpIfGrt:
+      this->operands(instruction);
+      if (this->is_text(instruction.src1)) {
+        this->line("movq %rax, %rdi");
+        this->line("movq %rcx, %rsi");
+        this->line("call spl_text_grt");
+        this->line("testl %eax, %eax");
+        this->line("jne " + target);
+      } else {
+        this->line("ucomisd %xmm1, %xmm0");
+        this->line("ja " + target);
+      }
+      return;
+    case IMCOpcode::Print:
+      this->load(instruction.src1, "%rax");
+      if (this->is_text(instruction.src1)) {
+        this->line("movq %rax, %rdi");
+        this->line("call spl_print_text");
+      } else {
+        this->line("movq %rax, %xmm0");
+        this->line("call spl_print_number");
+      }
+      return;
+    case IMCOpcode::Return:
+      // a function that ends without a value returns zero, as in the VM
+      if (instruction.src1 != IMCOperand::NONE) {
+        this->load(instruction.src1, "%rax");
+      } else {
+        this->line("xorl %eax, %eax");
+      }
+      this->line("jmp " + this->label("ret"));
+      return;
+    case IMCOpcode::Halt:
+      this->line("call spl_halt");
+      return;
+    default:
+      throw std::logic_error("Cannot emit " +
+                             std::string(opcode_name(instruction.opcode)));
+    }
+  }
+
+  Layout &m_Layout;
+  const IMCProgram &m_Program;
+  std::size_t m_Index;
+  const IMCFunction &m_Function;
+  RegisterAllocation m_Allocation;
+  std::vector<uint32_t> m_Slots; // frame slot of each variable it owns
+  uint32_t m_Frame = 0;          // slots in all
+  uint32_t m_Spills = 0;         // first slot of the spilled temporaries
+  std::string m_Text;
+};
+} // namespace
+
+std::string emit_runtime() { return RUNTIME; }
+
+std::string emit_c(const IMCProgram &program) {
+  Layout layout(program);
+
+  // functions first, since they add to the text table
+  std::string prototypes;
+  std::string functions;
+  for (std::size_t i = 0; i < program.functions.size(); i++) {
+    CEmitter emitter(layout, i);
+    if (i > 0) {
+      prototypes += emitter.signature() + ";\n";
+    }
+    functions += "\n" + emitter.emit();
+  }
+
+  std::string text = RUNTIME;
+  text += "\n/* calls in tail position are jumps: guaranteed where the\n"
+          "   compiler has musttail, and otherwise left to its sibling-call\n"
+          "   optimization, which inlining the functions making them defeats "
+          "*/\n"
+          "#if defined(__has_attribute)\n#if __has_attribute(musttail)\n"
+          "#define SPL_TAIL __attribute__((musttail))\n#endif\n#endif\n"
+          "#ifdef SPL_TAIL\n#define SPL_TAIL_CALLER\n#else\n"
+          "#define SPL_TAIL\n#ifdef __GNUC__\n"
+          "#define SPL_TAIL_CALLER __attribute__((noinline))\n#else\n"
+          "#define SPL_TAIL_CALLER\n#endif\n#endif\n";
+  text += "\ntypedef union {\n  double n;\n  const char *t;\n} spl_value;\n\n"
+          "static spl_value spl_num(double n) {\n  spl_value v;\n  v.n = n;\n"
+          "  return v;\n}\n\n"
+          "static spl_value spl_text(const char *t) {\n  spl_value v;\n"
+          "  v.t = t;\n  return v;\n}\n\n";
+  for (std::size_t i = 0; i < layout.order.size(); i++) {
+    text += "static const char spl_t" + std::to_string(i) + "[] = " +
+            quote(Interner::global().view(layout.order[i])) + ";\n";
+  }
+  for (uint32_t v = 0; v < program.variables.size(); v++) {
+    if (layout.owners[v] == IMCProgram::SHARED) {
+      text += "static spl_value spl_v" + std::to_string(v) + " = " +
+              layout.initial(program.variables[v].type) + ";\n";
+    }
+  }
+  return text + prototypes + functions;
+}
+
+std::string emit_asm(const IMCProgram &program) {
+  Layout layout(program);
+  std::string text = "\t.text\n";
+  for (std::size_t i = 0; i < program.functions.size(); i++) {
+    text += AsmEmitter(layout, i).emit();
+  }
+
+  text += "\n\t.data\n\t.p2align 3\n";
+  for (uint32_t v = 0; v < program.variables.size(); v++) {
+    if (layout.owners[v] != IMCProgram::SHARED) {
+      continue;
+    }
+    text += "spl_v" + std::to_string(v) + ":\n";
+    text += program.variables[v].type == TypeId::Text
+                ? "\t.quad " + layout.empty_text() + "\n"
+                : "\t.quad 0\n";
+  }
+  text += "\n\t.section .rodata\n";
+  for (std::size_t i = 0; i < layout.order.size(); i++) {
+    text += "spl_t" + std::to_string(i) + ":\n\t.string " +
+            quote(Interner::global().view(layout.order[i])) + "\n";
+  }
+  return text + "\n\t.section .note.GNU-stack,\"\",@progbits\n";
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <copyprop.h>
+
+std::size_t propagate_copies(IMCProgram &program, const SSABuilder &ssa,
+                             CFG &cfg, std::size_t index) {
+  IMCFunction &function = program.functions[index];
+  std::vector<BasicBlock> &blocks = cfg.blocks();
+
+  // what each temporary stands for, following chains of copies; phis and
+  // copies define temporaries only, and each exactly once
+  std::vector<OperandId> replaced(function.temps.size(), IMCOperand::NONE);
+  auto resolve = [&](OperandId operand) {
+    while (operand != IMCOperand::NONE &&
+           IMCOperand::kind(operand) == IMCOperand::Kind::Temp &&
+           replaced[IMCOperand::index(operand)] != IMCOperand::NONE) {
+      operand = replaced[IMCOperand::index(operand)];
+    }
+    return operand;
+  };
+  auto is_temp = [](OperandId operand) {
+    return operand != IMCOperand::NONE &&
+           IMCOperand::kind(operand) == IMCOperand::Kind::Temp;
+  };
+
+  std::size_t removed = 0;
+  for (BasicBlock &block : blocks) {
+    for (const IMCInstruction &instruction : block.code) {
+      OperandId source = instruction.src1;
+      if (instruction.opcode == IMCOpcode::Copy && is_temp(instruction.dst) &&
+          (IMCOperand::kind(source) == IMCOperand::Kind::Constant ||
+           ssa.renamable(index, source))) {
+        replaced[IMCOperand::index(instruction.dst)] = source;
+        removed++;
+      }
+    }
+  }
+
+  // a phi whose arguments other than itself are all one value is that
+  // value; removing one may make another such, so repeat until none is
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (BasicBlock &block : blocks) {
+      for (const Phi &phi : block.phis) {
+        if (replaced[IMCOperand::index(phi.dst)] != IMCOperand::NONE) {
+          continue;
+        }
+        OperandId value = IMCOperand::NONE;
+        bool unique = true;
+        for (OperandId argument : phi.args) {
+          argument = resolve(argument);
+          if (argument == phi.dst || argument == value) {
+            continue;
+          }
+          unique = value == IMCOperand::NONE;
+          value = argument;
+          if (!unique) {
+            break;
+          }
+        }
+        if (unique && value != IMCOperand::NONE) {
+          replaced[IMCOperand::index(phi.dst)] = value;
+          removed++;
+          changed = true;
+        }
+      }
+    }
+  }
+  for (BasicBlock &block : blocks) {
+    block.phis.erase(std::remove_if(block.phis.begin(), block.phis.end(),
+                                    [&](const Phi &phi) {
+                                      return resolve(phi.dst) != phi.dst;
+                                    }),
+                     block.phis.end());
+    for (Phi &phi : block.phis) {
+      for (OperandId &argument : phi.args) {
+        argument = resolve(argument);
+      }
+    }
+
+    block.code.erase(
+        std::remove_if(block.code.begin(), block.code.end(),
+                       [&](const IMCInstruction &instruction) {
+                         return instruction.opcode == IMCOpcode::Copy &&
+                                is_temp(instruction.dst) &&
+                                resolve(instruction.dst) != instruction.dst;
+                       }),
+        block.code.end());
+    for (IMCInstruction &instruction : block.code) {
+      int sources = source_count(instruction.opcode);
+      if (sources > 0) {
+        instruction.src1 = resolve(instruction.src1);
+      }
+      if (sources > 1) {
+        instruction.src2 = resolve(instruction.src2);
+      }
+    }
+  }
+
+  // phis no instruction reads, directly or through other phis, are
+  // copies nothing needs
+  std::vector<bool> read(function.temps.size(), false);
+  std::vector<OperandId> work;
+  auto mark = [&](OperandId operand) {
+    if (is_temp(operand) && !read[IMCOperand::index(operand)]) {
+      read[IMCOperand::index(operand)] = true;
+      work.push_back(operand);
+    }
+  };
+  std::vector<const Phi *> phis(function.temps.size(), nullptr);
+  for (const BasicBlock &block : blocks) {
+    for (const Phi &phi : block.phis) {
+      phis[IMCOperand::index(phi.dst)] = &phi;
+    }
+    for (const IMCInstruction &instruction : block.code) {
+      int sources = source_count(instruction.opcode);
+      if (sources > 0) {
+        mark(instruction.src1);
+      }
+      if (sources > 1) {
+        mark(instruction.src2);
+      }
+    }
+  }
+  while (!work.empty()) {
+    const Phi *phi = phis[IMCOperand::index(work.back())];
+    work.pop_back();
+    if (phi) {
+      for (OperandId argument : phi->args) {
+        mark(argument);
+      }
+    }
+  }
+  for (BasicBlock &block : blocks) {
+    std::size_t before = block.phis.size();
+    block.phis.erase(std::remove_if(block.phis.begin(), block.phis.end(),
+                                    [&](const Phi &phi) {
+                                      return !read[IMCOperand::index(phi.dst)];
+                                    }),
+                     block.phis.end());
+    removed += before - block.phis.size();
+  }
+  return removed;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <dce.h>
+
+namespace {
+// instructions whose only effect is their assignment
+bool pure(IMCOpcode opcode) {
+  return writes_dst(opcode) && opcode != IMCOpcode::Input &&
+         opcode != IMCOpcode::Call;
+}
+
+// the operands an instruction mentions, for `visit`
+template <typename Visit>
+void for_each_operand(IMCInstruction &instruction, Visit visit) {
+  if (writes_dst(instruction.opcode)) {
+    visit(instruction.dst);
+  }
+  int sources = source_count(instruction.opcode);
+  if (sources > 0) {
+    visit(instruction.src1);
+  }
+  if (sources > 1) {
+    visit(instruction.src2);
+  }
+}
+} // namespace
+
+DeadCodeReport &DeadCodeReport::operator+=(const DeadCodeReport &other) {
+  this->stores += other.stores;
+  this->functions += other.functions;
+  this->variables += other.variables;
+  this->temps += other.temps;
+  return *this;
+}
+
+void DeadCodeReport::print(std::ostream &out) const {
+  out << "dead code: removed " << this->stores << " stores, "
+      << this->functions << " unreachable functions, " << this->variables
+      << " variables and " << this->temps << " temporaries" << std::endl;
+}
+
+std::size_t remove_dead_stores(IMCProgram &program,
+                               const std::vector<uint32_t> &owners, CFG &cfg,
+                               std::size_t index) {
+  const IMCFunction &function = program.functions[index];
+  std::vector<BasicBlock> &blocks = cfg.blocks();
+
+  // liveness is tracked for the temporaries, then the private variables
+  std::size_t temps = function.temps.size();
+  std::vector<uint32_t> slots(program.variables.size(), CFG::NONE);
+  std::size_t count = temps;
+  for (uint32_t v = 0; v < slots.size(); v++) {
+    if (owners[v] == index) {
+      slots[v] = static_cast<uint32_t>(count++);
+    }
+  }
+  auto slot = [&](OperandId operand) -> uint32_t {
+    if (operand == IMCOperand::NONE) {
+      return CFG::NONE;
+    }
+    switch (IMCOperand::kind(operand)) {
+    case IMCOperand::Kind::Temp:
+      return IMCOperand::index(operand);
+    case IMCOperand::Kind::Variable:
+      return slots[IMCOperand::index(operand)];
+    default:
+      return CFG::NONE;
+    }
+  };
+  // steps `live` back over an instruction
+  auto transfer = [&](const IMCInstruction &instruction,
+                      std::vector<bool> &live) {
+    if (writes_dst(instruction.opcode) && slot(instruction.dst) != CFG::NONE) {
+      live[slot(instruction.dst)] = false;
+    }
+    int sources = source_count(instruction.opcode);
+    if (sources > 0 && slot(instruction.src1) != CFG::NONE) {
+      live[slot(instruction.src1)] = true;
+    }
+    if (sources > 1 && slot(instruction.src2) != CFG::NONE) {
+      live[slot(instruction.src2)] = true;
+    }
+  };
+  auto dead = [&](const IMCInstruction &instruction,
+                  const std::vector<bool> &live) {
+    if (!pure(instruction.opcode)) {
+      return false;
+    }
+    uint32_t written = slot(instruction.dst);
+    return (written != CFG::NONE && !live[written]) ||
+           (instruction.opcode == IMCOpcode::Copy &&
+            instruction.dst == instruction.src1);
+  };
+
+  std::size_t removed = 0;
+  std::size_t round = 1;
+  while (round > 0) {
+    // what is live on entry to each block, to a fixed point; nothing is
+    // live after a return, as private operands start afresh on each call
+    std::vector<std::vector<bool>> live_in(blocks.size(),
+                                           std::vector<bool>(count, false));
+    auto live_out = [&](const BasicBlock &block) {
+      std::vector<bool> live(count, false);
+      for (uint32_t successor : block.successors) {
+        for (std::size_t s = 0; s < count; s++) {
+          live[s] = live[s] || live_in[successor][s];
+        }
+      }
+      return live;
+    };
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (std::size_t b = blocks.size(); b-- > 0;) {
+        std::vector<bool> live = live_out(blocks[b]);
+        for (auto it = blocks[b].code.rbegin(); it != blocks[b].code.rend();
+             ++it) {
+          transfer(*it, live);
+        }
+        if (live != live_in[b]) {
+          live_in[b] = std::move(live);
+          changed = true;
+        }
+      }
+    }
+
+    // a dead store no longer keeps its sources alive, so those before it
+    // in the block may die with it; those in other blocks next round
+    round = 0;
+    for (BasicBlock &block : blocks) {
+      std::vector<bool> live = live_out(block);
+      std::vector<IMCInstruction> code;
+      for (auto it = block.code.rbegin(); it != block.code.rend(); ++it) {
+        if (dead(*it, live)) {
+          round++;
+          continue;
+        }
+        transfer(*it, live);
+        code.push_back(*it);
+      }
+      std::reverse(code.begin(), code.end());
+      block.code = std::move(code);
+    }
+    removed += round;
+  }
+  return removed;
+}
+
+DeadCodeReport remove_unused(IMCProgram &program) {
+  DeadCodeReport report;
+
+  // functions called on some chain of calls from main, which keep their
+  // order
+  std::vector<uint32_t> renumbered(program.functions.size(), CFG::NONE);
+  renumbered[0] = 0;
+  std::vector<uint32_t> work = {0};
+  while (!work.empty()) {
+    uint32_t caller = work.back();
+    work.pop_back();
+    for (const IMCInstruction &instruction :
+         program.functions[caller].code) {
+      if (instruction.opcode == IMCOpcode::Call &&
+          renumbered[instruction.src1] == CFG::NONE) {
+        renumbered[instruction.src1] = 0;
+        work.push_back(instruction.src1);
+      }
+    }
+  }
+  std::vector<IMCFunction> functions;
+  for (uint32_t i = 0; i < program.functions.size(); i++) {
+    if (renumbered[i] != CFG::NONE) {
+      renumbered[i] = static_cast<uint32_t>(functions.size());
+      functions.push_back(std::move(program.functions[i]));
+    }
+  }
+  report.functions = program.functions.size() - functions.size();
+  program.functions = std::move(functions);
+
+  std::vector<bool> mentioned(program.variables.size(), false);
+  for (IMCFunction &function : program.functions) {
+    for (OperandId param : function.params) {
+      mentioned[IMCOperand::index(param)] = true;
+    }
+
+    std::vector<uint32_t> temps(function.temps.size(), CFG::NONE);
+    for (IMCInstruction &instruction : function.code) {
+      if (instruction.opcode == IMCOpcode::Call) {
+        instruction.src1 = renumbered[instruction.src1];
+      }
+      for_each_operand(instruction, [&](OperandId operand) {
+        if (operand == IMCOperand::NONE) {
+          return;
+        }
+        if (IMCOperand::kind(operand) == IMCOperand::Kind::Variable) {
+          mentioned[IMCOperand::index(operand)] = true;
+        } else if (IMCOperand::kind(operand) == IMCOperand::Kind::Temp) {
+          temps[IMCOperand::index(operand)] = 0;
+        }
+      });
+    }
+
+    // the temporaries still in use, in their old order
+    std::vector<TypeId> types;
+    for (uint32_t t = 0; t < temps.size(); t++) {
+      if (temps[t] != CFG::NONE) {
+        temps[t] = static_cast<uint32_t>(types.size());
+        types.push_back(function.temps[t]);
+      }
+    }
+    report.temps += function.temps.size() - types.size();
+    function.temps = std::move(types);
+    for (IMCInstruction &instruction : function.code) {
+      for_each_operand(instruction, [&](OperandId &operand) {
+        if (operand != IMCOperand::NONE &&
+            IMCOperand::kind(operand) == IMCOperand::Kind::Temp) {
+          operand = IMCOperand::temp(temps[IMCOperand::index(operand)]);
+        }
+      });
+    }
+  }
+
+  auto drop = [&](std::vector<OperandId> &variables) {
+    std::size_t before = variables.size();
+    variables.erase(std::remove_if(variables.begin(), variables.end(),
+                                   [&](OperandId variable) {
+                                     return !mentioned[IMCOperand::index(
+                                         variable)];
+                                   }),
+                    variables.end());
+    report.variables += before - variables.size();
+  };
+  for (IMCFunction &function : program.functions) {
+    drop(function.locals);
+  }
+  drop(program.globals);
+  return report;
+}
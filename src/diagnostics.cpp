@@ -0,0 +1,71 @@
+#include <diagnostics.h>
+#include <utility>
+
+void DiagnosticReport::print(std::ostream &out, std::string_view filename,
+                             bool color) const {
+  for (const Diagnostic &diagnostic : this->diagnostics) {
+    if (!filename.empty()) {
+      out << filename << ":";
+    }
+    out << diagnostic.span.line << ":" << diagnostic.span.column << ": ";
+
+    bool error = diagnostic.severity == Severity::Error;
+    if (color) {
+      out << (error ? "\033[31m" : "\033[33m");
+    }
+    out << (error ? "error" : "warning");
+    if (color) {
+      out << "\033[0m";
+    }
+    out << ": " << diagnostic.message << "\n";
+  }
+
+  if (this->suppressed() > 0) {
+    out << this->suppressed() << " more diagnostics not shown\n";
+  }
+  if (this->errors > 0) {
+    out << this->errors << (this->errors == 1 ? " error" : " errors")
+        << " generated\n";
+  }
+}
+
+DiagnosticEngine::DiagnosticEngine(std::size_t limit) : m_Limit(limit) {}
+
+void DiagnosticEngine::error(const SourceSpan &span, std::string message) {
+  this->add(Severity::Error, span, std::move(message));
+}
+
+void DiagnosticEngine::warning(const SourceSpan &span, std::string message) {
+  this->add(Severity::Warning, span, std::move(message));
+}
+
+void DiagnosticEngine::add(Severity severity, const SourceSpan &span,
+                           std::string message) {
+  if (severity == Severity::Error) {
+    this->m_Report.errors++;
+  } else {
+    this->m_Report.warnings++;
+  }
+
+  // past the limit only the counts are kept
+  if (this->m_Report.diagnostics.size() < this->m_Limit) {
+    this->m_Report.diagnostics.push_back(
+        Diagnostic{severity, span, std::move(message)});
+  }
+}
+
+bool DiagnosticEngine::has_errors() const {
+  return this->m_Report.errors > 0;
+}
+
+std::size_t DiagnosticEngine::error_count() const {
+  return this->m_Report.errors;
+}
+
+const DiagnosticReport &DiagnosticEngine::report() const {
+  return this->m_Report;
+}
+
+DiagnosticReport DiagnosticEngine::take() {
+  return std::exchange(this->m_Report, DiagnosticReport());
+}
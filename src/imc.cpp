@@ -1,115 +1,786 @@
 #include "parser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <imc.h>
+#include <stdexcept>
 
-IMCStatement IMCStatement::create_assignment(const std::string &place,
-                                             const IMCStatement &rhs) {
-  IMCStatement result;
-  result.m_LHS = place;
-  result.m_RHS = std::make_unique<IMCStatement>(rhs);
-  result.m_Type = IMCStatement::StatementType::Assignment;
+namespace {
+// opcode computing an UNOP or BINOP keyword
+IMCOpcode opcode_of(const SyntaxTreeNode *op) {
+  switch (op->getSymbolId()) {
+  case GrammarSymbol::Add:
+    return IMCOpcode::Add;
+  case GrammarSymbol::Sub:
+    return IMCOpcode::Sub;
+  case GrammarSymbol::Mul:
+    return IMCOpcode::Mul;
+  case GrammarSymbol::Div:
+    return IMCOpcode::Div;
+  case GrammarSymbol::Sqrt:
+    return IMCOpcode::Sqrt;
+  case GrammarSymbol::Not:
+    return IMCOpcode::Not;
+  case GrammarSymbol::And:
+    return IMCOpcode::And;
+  case GrammarSymbol::Or:
+    return IMCOpcode::Or;
+  case GrammarSymbol::Eq:
+    return IMCOpcode::Eq;
+  case GrammarSymbol::Grt:
+    return IMCOpcode::Grt;
+  default:
+    throw std::logic_error("Not an operator: " + op->getSymbol());
+  }
+}
 
-  return result;
+// type named by a VTYP or FTYP keyword
+TypeId type_of(const SyntaxTreeNode *keyword) {
+  switch (keyword->getSymbolId()) {
+  case GrammarSymbol::Text:
+    return TypeId::Text;
+  case GrammarSymbol::Void:
+    return TypeId::Void;
+  default:
+    return TypeId::Num;
+  }
 }
 
-IMCStatement::IMCStatement(const IMCStatement &other)
-    : m_Type(other.m_Type), m_Text(other.m_Text), m_Number(other.m_Number),
-      m_LHS(other.m_LHS) {
-  if (other.m_RHS.get()) {
-    this->m_RHS = std::make_unique<IMCStatement>(*other.m_RHS);
+// how an operation is written in the textual form
+const char *infix(IMCOpcode opcode) {
+  switch (opcode) {
+  case IMCOpcode::Add:
+    return "+";
+  case IMCOpcode::Sub:
+    return "-";
+  case IMCOpcode::Mul:
+    return "*";
+  case IMCOpcode::Div:
+    return "/";
+  case IMCOpcode::Eq:
+  case IMCOpcode::JumpIfEq:
+    return "=";
+  case IMCOpcode::Grt:
+  case IMCOpcode::JumpIfGrt:
+    return ">";
+  default:
+    return opcode_name(opcode).data();
   }
 }
 
-IMCStatement &IMCStatement::operator=(const IMCStatement &other) {
-  this->m_Type = other.m_Type;
-  this->m_Text = other.m_Text;
-  this->m_Number = other.m_Number;
-  this->m_LHS = other.m_LHS;
+std::string label_string(uint32_t label) {
+  return "L" + std::to_string(label + 1);
+}
+} // namespace
 
-  if (other.m_RHS.get()) {
-    this->m_RHS = std::make_unique<IMCStatement>(*other.m_RHS);
+std::string format_number(double number) {
+  char buffer[32];
+  // whole numbers are written out in full rather than as 1e+01
+  if (number == std::trunc(number) && std::fabs(number) < 1e15) {
+    std::snprintf(buffer, sizeof(buffer), "%.0f", number);
+    return buffer;
   }
+  for (int precision = 1; precision <= 17; precision++) {
+    std::snprintf(buffer, sizeof(buffer), "%.*g", precision, number);
+    if (std::strtod(buffer, nullptr) == number) {
+      break;
+    }
+  }
+  return buffer;
+}
 
-  return *this;
+std::string_view opcode_name(IMCOpcode opcode) {
+  switch (opcode) {
+  case IMCOpcode::Copy:
+    return "COPY";
+  case IMCOpcode::Add:
+    return "ADD";
+  case IMCOpcode::Sub:
+    return "SUB";
+  case IMCOpcode::Mul:
+    return "MUL";
+  case IMCOpcode::Div:
+    return "DIV";
+  case IMCOpcode::And:
+    return "AND";
+  case IMCOpcode::Or:
+    return "OR";
+  case IMCOpcode::Eq:
+    return "EQ";
+  case IMCOpcode::Grt:
+    return "GRT";
+  case IMCOpcode::Sqrt:
+    return "SQRT";
+  case IMCOpcode::Not:
+    return "NOT";
+  case IMCOpcode::Input:
+    return "INPUT";
+  case IMCOpcode::Arg:
+    return "ARG";
+  case IMCOpcode::Call:
+    return "CALL";
+  case IMCOpcode::Label:
+    return "LABEL";
+  case IMCOpcode::Jump:
+    return "GOTO";
+  case IMCOpcode::JumpIfEq:
+    return "IFEQ";
+  case IMCOpcode::JumpIfGrt:
+    return "IFGRT";
+  case IMCOpcode::Print:
+    return "PRINT";
+  case IMCOpcode::Return:
+    return "RETURN";
+  case IMCOpcode::Halt:
+    return "STOP";
+  }
+  return "?";
 }
 
-IMCStatement::IMCStatement() {}
+bool is_terminator(IMCOpcode opcode) {
+  return opcode == IMCOpcode::Jump || opcode == IMCOpcode::Return ||
+         opcode == IMCOpcode::Halt;
+}
 
-IMCStatement::StatementType IMCStatement::get_type() const {
-  return this->m_Type;
+bool writes_dst(IMCOpcode opcode) {
+  switch (opcode) {
+  case IMCOpcode::Copy:
+  case IMCOpcode::Add:
+  case IMCOpcode::Sub:
+  case IMCOpcode::Mul:
+  case IMCOpcode::Div:
+  case IMCOpcode::And:
+  case IMCOpcode::Or:
+  case IMCOpcode::Eq:
+  case IMCOpcode::Grt:
+  case IMCOpcode::Sqrt:
+  case IMCOpcode::Not:
+  case IMCOpcode::Input:
+  case IMCOpcode::Call:
+    return true;
+  default:
+    return false;
+  }
 }
 
-const std::string &IMCStatement::get_text() const {
-  return this->m_Text.value();
+int source_count(IMCOpcode opcode) {
+  switch (opcode) {
+  case IMCOpcode::Add:
+  case IMCOpcode::Sub:
+  case IMCOpcode::Mul:
+  case IMCOpcode::Div:
+  case IMCOpcode::And:
+  case IMCOpcode::Or:
+  case IMCOpcode::Eq:
+  case IMCOpcode::Grt:
+  case IMCOpcode::JumpIfEq:
+  case IMCOpcode::JumpIfGrt:
+    return 2;
+  case IMCOpcode::Copy:
+  case IMCOpcode::Sqrt:
+  case IMCOpcode::Not:
+  case IMCOpcode::Arg:
+  case IMCOpcode::Print:
+  case IMCOpcode::Return:
+    return 1;
+  default:
+    return 0;
+  }
 }
 
-int64_t IMCStatement::get_number() const { return this->m_Number.value(); }
-const std::string &IMCStatement::get_lhs_id() const {
-  return this->m_LHS.value();
+bool is_jump(IMCOpcode opcode) {
+  return opcode == IMCOpcode::Jump || opcode == IMCOpcode::JumpIfEq ||
+         opcode == IMCOpcode::JumpIfGrt;
 }
-const IMCStatement &IMCStatement::get_rhs() const {
-  if (!this->m_RHS.get()) {
-    throw std::runtime_error("Attempted to get RHS on statement without RHS");
+
+uint32_t IMCConstantPool::intern_number(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  auto [it, inserted] = this->m_Numbers.try_emplace(
+      bits, static_cast<uint32_t>(this->m_Constants.size()));
+  if (inserted) {
+    this->m_Constants.push_back(
+        Constant{TypeId::Num, value, Interner::INVALID});
   }
+  return it->second;
+}
 
-  return *this->m_RHS;
+uint32_t IMCConstantPool::intern_text(std::string_view value) {
+  Interner::Id text = Interner::global().intern(value);
+  auto [it, inserted] = this->m_Texts.try_emplace(
+      text, static_cast<uint32_t>(this->m_Constants.size()));
+  if (inserted) {
+    this->m_Constants.push_back(Constant{TypeId::Text, 0.0, text});
+  }
+  return it->second;
 }
 
-IMCStatement IMCStatement::create_value(int64_t number) {
-  IMCStatement stat{};
-  stat.m_Type = IMCStatement::StatementType::NumberValue;
-  stat.m_Number = number;
-  return stat;
+OperandId IMCFunction::new_temp(TypeId type) {
+  this->temps.push_back(type);
+  return IMCOperand::temp(static_cast<uint32_t>(this->temps.size() - 1));
 }
 
-IMCStatement IMCStatement::create_value(const std::string &text) {
-  IMCStatement stat{};
-  stat.m_Type = IMCStatement::StatementType::TextValue;
-  stat.m_Text = text;
-  return stat;
+TypeId IMCProgram::type_of(const IMCFunction &function,
+                           OperandId operand) const {
+  uint32_t index = IMCOperand::index(operand);
+  switch (IMCOperand::kind(operand)) {
+  case IMCOperand::Kind::Variable:
+    return this->variables[index].type;
+  case IMCOperand::Kind::Temp:
+    return function.temps[index];
+  case IMCOperand::Kind::Constant:
+    return this->constants.get(index).type;
+  case IMCOperand::Kind::None:
+    break;
+  }
+  return TypeId::Void;
 }
 
-bool IMCStatement::operator==(const IMCStatement &other) const {
-  bool base_eq = this->m_Type == other.m_Type && this->m_Text == other.m_Text &&
-                 this->m_LHS == other.m_LHS && this->m_Number == other.m_Number;
+std::string IMCProgram::operand_string(OperandId operand) const {
+  uint32_t index = IMCOperand::index(operand);
+  switch (IMCOperand::kind(operand)) {
+  case IMCOperand::Kind::Variable:
+    return "v" + std::to_string(index + 1);
+  case IMCOperand::Kind::Temp:
+    return "t" + std::to_string(index + 1);
+  case IMCOperand::Kind::Constant: {
+    const IMCConstantPool::Constant &constant = this->constants.get(index);
+    if (constant.type == TypeId::Text) {
+      return "\"" + std::string(Interner::global().view(constant.text)) +
+             "\"";
+    }
+    return format_number(constant.number);
+  }
+  case IMCOperand::Kind::None:
+    break;
+  }
+  return "_";
+}
+
+std::string
+IMCProgram::instruction_string(const IMCInstruction &instruction) const {
+  auto operand = [&](OperandId id) { return this->operand_string(id); };
+  switch (instruction.opcode) {
+  case IMCOpcode::Copy:
+    return operand(instruction.dst) + " := " + operand(instruction.src1);
+  case IMCOpcode::Add:
+  case IMCOpcode::Sub:
+  case IMCOpcode::Mul:
+  case IMCOpcode::Div:
+  case IMCOpcode::And:
+  case IMCOpcode::Or:
+  case IMCOpcode::Eq:
+  case IMCOpcode::Grt:
+    return operand(instruction.dst) + " := " + operand(instruction.src1) +
+           " " + infix(instruction.opcode) + " " + operand(instruction.src2);
+  case IMCOpcode::Sqrt:
+  case IMCOpcode::Not:
+    return operand(instruction.dst) + " := " + infix(instruction.opcode) +
+           " " + operand(instruction.src1);
+  case IMCOpcode::Input:
+    return operand(instruction.dst) + " := INPUT";
+  case IMCOpcode::Arg:
+    return "ARG " + operand(instruction.src1);
+  case IMCOpcode::Call: {
+    std::string call = "CALL " + this->functions[instruction.src1].name;
+    return instruction.dst == IMCOperand::NONE
+               ? call
+               : operand(instruction.dst) + " := " + call;
+  }
+  case IMCOpcode::Label:
+    return "LABEL " + label_string(instruction.dst);
+  case IMCOpcode::Jump:
+    return "GOTO " + label_string(instruction.dst);
+  case IMCOpcode::JumpIfEq:
+  case IMCOpcode::JumpIfGrt:
+    return "IF " + operand(instruction.src1) + " " +
+           infix(instruction.opcode) + " " + operand(instruction.src2) +
+           " GOTO " + label_string(instruction.dst);
+  case IMCOpcode::Print:
+    return "PRINT " + operand(instruction.src1);
+  case IMCOpcode::Return:
+    return instruction.src1 == IMCOperand::NONE
+               ? "RETURN"
+               : "RETURN " + operand(instruction.src1);
+  case IMCOpcode::Halt:
+    return "STOP";
+  }
+  return "";
+}
 
-  bool rhs = this->m_RHS.get();
-  bool other_rhs = other.m_RHS.get();
+std::vector<uint32_t> IMCProgram::owners() const {
+  std::vector<uint32_t> owners(this->variables.size(), UNUSED);
+  auto use = [&](uint32_t function, OperandId operand) {
+    if (IMCOperand::kind(operand) != IMCOperand::Kind::Variable) {
+      return;
+    }
+    uint32_t &owner = owners[IMCOperand::index(operand)];
+    owner = owner == UNUSED || owner == function ? function : SHARED;
+  };
 
-  if (rhs == other_rhs) {
-    if (rhs) {
-      return base_eq && *other.m_RHS == *this->m_RHS;
+  // a global is main's, even if main itself never mentions it, so the
+  // one function that does still shares it between its calls
+  for (OperandId operand : this->globals) {
+    use(0, operand);
+  }
+  for (uint32_t i = 0; i < this->functions.size(); i++) {
+    const IMCFunction &function = this->functions[i];
+    for (OperandId operand : function.params) {
+      use(i, operand);
     }
-  } else {
+    for (OperandId operand : function.locals) {
+      use(i, operand);
+    }
+    for (const IMCInstruction &instruction : function.code) {
+      if (writes_dst(instruction.opcode)) {
+        use(i, instruction.dst);
+      }
+      int sources = source_count(instruction.opcode);
+      if (sources > 0) {
+        use(i, instruction.src1);
+      }
+      if (sources > 1) {
+        use(i, instruction.src2);
+      }
+    }
+  }
+  return owners;
+}
+
+bool IMCProgram::tail_call(const std::vector<uint32_t> &owners,
+                           std::size_t index, std::size_t at) const {
+  // main returns nothing, and its return ends the program
+  if (index == 0) {
+    return false;
+  }
+  const std::vector<IMCInstruction> &code = this->functions[index].code;
+  OperandId result = code[at].dst;
+  if (result != IMCOperand::NONE &&
+      IMCOperand::kind(result) == IMCOperand::Kind::Variable &&
+      owners[IMCOperand::index(result)] != index) {
     return false;
   }
 
-  return base_eq;
+  // a jump per label at most, so a cycle of jumps ends the search
+  std::size_t jumps = 0;
+  std::size_t i = at + 1;
+  while (i < code.size() && jumps <= this->functions[index].label_count) {
+    const IMCInstruction &instruction = code[i];
+    if (instruction.opcode == IMCOpcode::Label) {
+      i++;
+    } else if (instruction.opcode == IMCOpcode::Jump) {
+      auto label = std::find(code.begin(), code.end(),
+                             IMCInstruction{IMCOpcode::Label, instruction.dst});
+      i = static_cast<std::size_t>(label - code.begin());
+      jumps++;
+    } else {
+      return instruction.opcode == IMCOpcode::Return &&
+             instruction.src1 == result;
+    }
+  }
+  return false;
 }
 
-bool IMCStatement::operator!=(const IMCStatement &other) const {
-  return !this->operator==(other);
+std::string IMCProgram::to_string() const {
+  auto join = [&](const std::vector<OperandId> &operands) {
+    std::string joined;
+    for (std::size_t i = 0; i < operands.size(); i++) {
+      joined += (i ? ", " : "") + this->operand_string(operands[i]);
+    }
+    return joined;
+  };
+
+  std::string text;
+  if (!this->globals.empty()) {
+    text += "GLOBAL " + join(this->globals) + "\n";
+  }
+  for (const IMCFunction &function : this->functions) {
+    text += "FUNCTION " + function.name + "(" + join(function.params) + ")\n";
+    if (!function.locals.empty()) {
+      text += "  LOCAL " + join(function.locals) + "\n";
+    }
+    for (const IMCInstruction &instruction : function.code) {
+      // labels stand out by sitting one level left of the code
+      bool label = instruction.opcode == IMCOpcode::Label;
+      text += (label ? "" : "  ") + this->instruction_string(instruction) +
+              "\n";
+    }
+    text += "END\n";
+  }
+  return text;
 }
 
 IMCGenerator::IMCGenerator(SyntaxTreeNode *root)
     : m_SyntaxTree(root), m_Functions(SymbolTable::empty()),
       m_Variables(SymbolTable::empty()) {}
 
-std::vector<IMCStatement>
-IMCGenerator::translate_expression(SyntaxTreeNode *, const std::string &) {
-  // TODO: Expression translation
-  return {};
+IMCProgram IMCGenerator::generate() {
+  // PROG -> main GLOBVARS ALGO FUNCTIONS
+  this->m_Program.functions.emplace_back();
+  this->m_Program.functions[0].name = "main";
+
+  this->translate_globals(this->m_SyntaxTree->child(1));
+  this->translate_functions(this->m_SyntaxTree->child(3));
+
+  this->m_Current = 0;
+  this->translate_algo(this->m_SyntaxTree->child(2));
+  this->emit(IMCOpcode::Halt);
+
+  this->eliminate_tail_recursion();
+  return std::move(this->m_Program);
+}
+
+void IMCGenerator::eliminate_tail_recursion() {
+  std::vector<uint32_t> owners = this->m_Program.owners();
+  for (std::size_t index = 1; index < this->m_Program.functions.size();
+       index++) {
+    IMCFunction &function = this->m_Program.functions[index];
+    std::vector<IMCInstruction> code;
+    uint32_t start = IMCOperand::NONE;
+    for (std::size_t at = 0; at < function.code.size(); at++) {
+      const IMCInstruction &instruction = function.code[at];
+      std::size_t params = function.params.size();
+      bool arguments_ready =
+          code.size() >= params &&
+          std::all_of(code.end() - params, code.end(),
+                      [](const IMCInstruction &arg) {
+                        return arg.opcode == IMCOpcode::Arg;
+                      });
+      if (instruction.opcode != IMCOpcode::Call || instruction.src1 != index ||
+          !arguments_ready || !this->m_Program.tail_call(owners, index, at)) {
+        code.push_back(instruction);
+        continue;
+      }
+      if (start == IMCOperand::NONE) {
+        start = function.new_label();
+      }
+
+      // the arguments are all read before any parameter is written, as a
+      // call would; the variables the function owns start over too
+      std::vector<OperandId> arguments;
+      for (auto arg = code.end() - params; arg != code.end(); arg++) {
+        arguments.push_back(function.new_temp(
+            this->m_Program.type_of(function, arg->src1)));
+        *arg = IMCInstruction{IMCOpcode::Copy, arguments.back(), arg->src1};
+      }
+      for (std::size_t k = 0; k < params; k++) {
+        code.push_back(IMCInstruction{IMCOpcode::Copy, function.params[k],
+                                      arguments[k]});
+      }
+      for (uint32_t v = 0; v < owners.size(); v++) {
+        OperandId variable = IMCOperand::variable(v);
+        if (owners[v] != index ||
+            std::find(function.params.begin(), function.params.end(),
+                      variable) != function.params.end()) {
+          continue;
+        }
+        uint32_t zero =
+            this->m_Program.variables[v].type == TypeId::Text
+                ? this->m_Program.constants.intern_text("")
+                : this->m_Program.constants.intern_number(0);
+        code.push_back(IMCInstruction{IMCOpcode::Copy, variable,
+                                      IMCOperand::constant(zero)});
+      }
+      code.push_back(IMCInstruction{IMCOpcode::Jump, start});
+    }
+
+    if (start != IMCOperand::NONE) {
+      code.insert(code.begin(), IMCInstruction{IMCOpcode::Label, start});
+      function.code = std::move(code);
+    }
+  }
 }
 
-IMCVariable::VariableType IMCVariable::get_type() const { return this->m_Type; }
-const char *IMCVariable::get_text() const {
-  if (this->m_Type != IMCVariable::VariableType::Text) {
-    throw std::runtime_error("Bad IMCVariable access (Tried to access Text)");
+void IMCGenerator::translate_globals(SyntaxTreeNode *globvars) {
+  // GLOBVARS -> '' | VTYP VNAME , GLOBVARS
+  for (SyntaxTreeNode *link : SyntaxTreeList(globvars)) {
+    this->m_Program.globals.push_back(this->declare_variable(
+        link->child(1)->child(0), type_of(link->child(0)->child(0))));
   }
-  return this->m_Data.m_Text;
 }
-int64_t IMCVariable::get_number() const {
-  if (this->m_Type != IMCVariable::VariableType::Number) {
-    throw std::runtime_error("Bad IMCVariable access");
+
+void IMCGenerator::translate_functions(SyntaxTreeNode *functions) {
+  // FUNCTIONS -> '' | DECL FUNCTIONS
+  // every function of the list gets its slot and name before any is
+  // translated, so the bodies may call each other in either order
+  for (SyntaxTreeNode *link : SyntaxTreeList(functions)) {
+    SyntaxTreeNode *header = link->child(0)->child(0);
+    SyntaxTreeNode *name = header->child(1)->child(0);
+
+    uint32_t index = static_cast<uint32_t>(this->m_Program.functions.size());
+    IMCFunction &function = this->m_Program.functions.emplace_back();
+    function.name = name->getActualValue();
+    function.return_type = type_of(header->child(0)->child(0));
+    std::size_t uses = this->m_FunctionNames[function.name]++;
+    if (uses > 0) {
+      function.name += "_" + std::to_string(uses);
+    }
+
+    Symbol symbol(name->getValueId(), TypeId::Function);
+    symbol.setPlace(index);
+    this->m_Functions->bind(symbol);
+  }
+
+  for (SyntaxTreeNode *link : SyntaxTreeList(functions)) {
+    this->translate_decl(link->child(0));
+  }
+}
+
+void IMCGenerator::translate_decl(SyntaxTreeNode *decl) {
+  // DECL -> HEADER BODY
+  // HEADER -> FTYP FNAME ( VNAME , VNAME , VNAME )
+  // BODY -> PROLOG LOCVARS ALGO EPILOG SUBFUNCS end
+  SyntaxTreeNode *header = decl->child(0);
+  SyntaxTreeNode *body = decl->child(1);
+
+  std::size_t caller = this->m_Current;
+  std::size_t index =
+      this->m_Functions->lookup(header->child(1)->child(0)->getValueId())
+          ->place();
+
+  this->m_Variables->enter();
+  this->m_Functions->enter();
+
+  // a parameter takes the type of the variable it is named after, as in
+  // the type checker
+  for (std::size_t i : {3, 5, 7}) {
+    SyntaxTreeNode *vname = header->child(i)->child(0);
+    const Symbol *outer = this->m_Variables->lookup(vname->getValueId());
+    OperandId param =
+        this->declare_variable(vname, outer ? outer->type() : TypeId::Num);
+    this->m_Program.functions[index].params.push_back(param);
+  }
+
+  // LOCVARS -> VTYP VNAME , VTYP VNAME , VTYP VNAME ,
+  SyntaxTreeNode *locvars = body->child(1);
+  for (std::size_t i = 0; i < locvars->getChildren().size(); i += 3) {
+    OperandId local = this->declare_variable(
+        locvars->child(i + 1)->child(0), type_of(locvars->child(i)->child(0)));
+    this->m_Program.functions[index].locals.push_back(local);
+  }
+
+  // SUBFUNCS -> FUNCTIONS
+  this->translate_functions(body->child(4)->child(0));
+
+  this->m_Current = index;
+  this->translate_algo(body->child(2));
+  const std::vector<IMCInstruction> &code = this->current().code;
+  if (code.empty() || !is_terminator(code.back().opcode)) {
+    this->emit(IMCOpcode::Return);
+  }
+
+  this->m_Functions->exit();
+  this->m_Variables->exit();
+  this->m_Current = caller;
+}
+
+void IMCGenerator::translate_algo(SyntaxTreeNode *algo) {
+  // ALGO -> begin INSTRUC end
+  // INSTRUC -> '' | COMMAND ; INSTRUC
+  for (SyntaxTreeNode *link : SyntaxTreeList(algo->child(1))) {
+    this->translate_command(link->child(0));
+  }
+}
+
+void IMCGenerator::translate_command(SyntaxTreeNode *command) {
+  // COMMAND -> skip | halt | print ATOMIC | ASSIGN | CALL | BRANCH
+  //          | return ATOMIC
+  SyntaxTreeNode *first = command->child(0);
+  switch (first->getSymbolId()) {
+  case GrammarSymbol::Skip:
+    break;
+  case GrammarSymbol::Halt:
+    this->emit(IMCOpcode::Halt);
+    break;
+  case GrammarSymbol::Print:
+    this->emit(IMCOpcode::Print, IMCOperand::NONE,
+               this->translate_atomic(command->child(1)));
+    break;
+  case GrammarSymbol::Return:
+    this->emit(IMCOpcode::Return, IMCOperand::NONE,
+               this->translate_atomic(command->child(1)));
+    break;
+  case GrammarSymbol::CALL:
+    this->translate_call(first, IMCOperand::NONE);
+    break;
+  case GrammarSymbol::BRANCH:
+    this->translate_branch(first);
+    break;
+  case GrammarSymbol::ASSIGN: {
+    // ASSIGN -> VNAME <input | VNAME = TERM
+    OperandId place = this->lookup_variable(first->child(0)->child(0));
+    if (first->child(1)->getSymbolId() == GrammarSymbol::Input) {
+      this->emit(IMCOpcode::Input, place);
+    } else {
+      this->translate_expression(first->child(2), place);
+    }
+    break;
+  }
+  default:
+    throw std::logic_error("Unexpected command " + first->getSymbol());
+  }
+}
+
+void IMCGenerator::translate_branch(SyntaxTreeNode *branch) {
+  // BRANCH -> if COND then ALGO else ALGO
+  uint32_t if_true = this->current().new_label();
+  uint32_t if_false = this->current().new_label();
+  uint32_t exit = this->current().new_label();
+
+  this->translate_condition(branch->child(1), if_true, if_false);
+  this->emit(IMCOpcode::Label, if_true);
+  this->translate_algo(branch->child(3));
+  this->emit(IMCOpcode::Jump, exit);
+  this->emit(IMCOpcode::Label, if_false);
+  this->translate_algo(branch->child(5));
+  this->emit(IMCOpcode::Label, exit);
+}
+
+void IMCGenerator::translate_expression(SyntaxTreeNode *expr,
+                                        OperandId place) {
+  switch (expr->getSymbolId()) {
+  case GrammarSymbol::TERM: // TERM -> ATOMIC | CALL | OP
+  case GrammarSymbol::ARG:  // ARG -> ATOMIC | OP
+    return this->translate_expression(expr->child(0), place);
+  case GrammarSymbol::ATOMIC:
+    return this->emit(IMCOpcode::Copy, place, this->translate_atomic(expr));
+  case GrammarSymbol::CALL:
+    return this->translate_call(expr, place);
+  case GrammarSymbol::OP:
+    break;
+  default:
+    throw std::logic_error("Unexpected expression " + expr->getSymbol());
+  }
+
+  // OP -> UNOP ( ARG ) | BINOP ( ARG , ARG )
+  // an atomic argument is used as it is, a nested operation is computed
+  // into a fresh temporary first
+  auto operand = [&](SyntaxTreeNode *arg) {
+    SyntaxTreeNode *inner = arg->child(0);
+    if (inner->getSymbolId() == GrammarSymbol::ATOMIC) {
+      return this->translate_atomic(inner);
+    }
+    OperandId temp = this->current().new_temp(TypeId::Num);
+    this->translate_expression(inner, temp);
+    return temp;
+  };
+
+  IMCOpcode opcode = opcode_of(expr->child(0)->child(0));
+  if (expr->child(0)->getSymbolId() == GrammarSymbol::UNOP) {
+    OperandId arg = operand(expr->child(2));
+    this->emit(opcode, place, arg);
+  } else {
+    OperandId left = operand(expr->child(2));
+    OperandId right = operand(expr->child(4));
+    this->emit(opcode, place, left, right);
+  }
+}
+
+void IMCGenerator::translate_condition(SyntaxTreeNode *cond, uint32_t if_true,
+                                       uint32_t if_false) {
+  // COND -> SIMPLE | COMPOSIT
+  SyntaxTreeNode *inner = cond->child(0);
+  if (inner->getSymbolId() == GrammarSymbol::SIMPLE) {
+    return this->translate_simple(inner, if_true, if_false);
+  }
+
+  // COMPOSIT -> BINOP ( SIMPLE , SIMPLE ) | UNOP ( SIMPLE )
+  // the second condition is only tested when the first does not already
+  // decide the outcome
+  switch (opcode_of(inner->child(0)->child(0))) {
+  case IMCOpcode::Not:
+    return this->translate_simple(inner->child(2), if_false, if_true);
+  case IMCOpcode::And: {
+    uint32_t second = this->current().new_label();
+    this->translate_simple(inner->child(2), second, if_false);
+    this->emit(IMCOpcode::Label, second);
+    return this->translate_simple(inner->child(4), if_true, if_false);
+  }
+  case IMCOpcode::Or: {
+    uint32_t second = this->current().new_label();
+    this->translate_simple(inner->child(2), if_true, second);
+    this->emit(IMCOpcode::Label, second);
+    return this->translate_simple(inner->child(4), if_true, if_false);
+  }
+  default:
+    throw std::logic_error("Unexpected operator in condition " +
+                           inner->child(0)->child(0)->getSymbol());
+  }
+}
+
+void IMCGenerator::translate_simple(SyntaxTreeNode *simple, uint32_t if_true,
+                                    uint32_t if_false) {
+  // SIMPLE -> BINOP ( ATOMIC , ATOMIC )
+  IMCOpcode opcode = opcode_of(simple->child(0)->child(0));
+  OperandId left = this->translate_atomic(simple->child(2));
+  OperandId right = this->translate_atomic(simple->child(4));
+
+  if (opcode == IMCOpcode::Eq || opcode == IMCOpcode::Grt) {
+    this->emit(opcode == IMCOpcode::Eq ? IMCOpcode::JumpIfEq
+                                       : IMCOpcode::JumpIfGrt,
+               if_true, left, right);
+    this->emit(IMCOpcode::Jump, if_false);
+    return;
+  }
+
+  // any other operator yields a number, which is true unless it is zero
+  OperandId value = this->current().new_temp(TypeId::Num);
+  OperandId zero =
+      IMCOperand::constant(this->m_Program.constants.intern_number(0.0));
+  this->emit(opcode, value, left, right);
+  this->emit(IMCOpcode::JumpIfEq, if_false, value, zero);
+  this->emit(IMCOpcode::Jump, if_true);
+}
+
+OperandId IMCGenerator::translate_atomic(SyntaxTreeNode *atomic) {
+  // ATOMIC -> VNAME | CONST, where VNAME -> varname and CONST -> literal
+  SyntaxTreeNode *value = atomic->child(0)->child(0);
+  switch (value->getSymbolId()) {
+  case GrammarSymbol::Varname:
+    return this->lookup_variable(value);
+  case GrammarSymbol::Numliteral:
+    return IMCOperand::constant(this->m_Program.constants.intern_number(
+        std::strtod(value->getActualValue().c_str(), nullptr)));
+  case GrammarSymbol::Textliteral: // the lexer already dropped the quotes
+    return IMCOperand::constant(
+        this->m_Program.constants.intern_text(value->value()));
+  default:
+    throw std::logic_error("Unexpected atomic " + value->getSymbol());
+  }
+}
+
+void IMCGenerator::translate_call(SyntaxTreeNode *call, OperandId place) {
+  // CALL -> FNAME ( ATOMIC , ATOMIC , ATOMIC )
+  SyntaxTreeNode *name = call->child(0)->child(0);
+  const Symbol *symbol = this->m_Functions->lookup(name->getValueId());
+  if (symbol == nullptr) {
+    throw std::logic_error("Undeclared function " + name->getActualValue());
+  }
+
+  for (std::size_t i : {2, 4, 6}) {
+    this->emit(IMCOpcode::Arg, IMCOperand::NONE,
+               this->translate_atomic(call->child(i)));
+  }
+  this->emit(IMCOpcode::Call, place, symbol->place());
+}
+
+OperandId IMCGenerator::declare_variable(SyntaxTreeNode *vname, TypeId type) {
+  OperandId place = IMCOperand::variable(
+      static_cast<uint32_t>(this->m_Program.variables.size()));
+  this->m_Program.variables.push_back(IMCVariable{vname->getValueId(), type});
+
+  Symbol symbol(vname->getValueId(), type);
+  symbol.setPlace(place);
+  this->m_Variables->bind(symbol);
+  return place;
+}
+
+OperandId IMCGenerator::lookup_variable(SyntaxTreeNode *vname) const {
+  const Symbol *symbol = this->m_Variables->lookup(vname->getValueId());
+  if (symbol == nullptr) {
+    throw std::logic_error("Undeclared variable " + vname->getActualValue());
   }
-  return this->m_Data.m_Number;
+  return symbol->place();
 }
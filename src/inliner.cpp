@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <inliner.h>
+
+namespace {
+// instructions that do something when run, which labels do not
+std::size_t size(const IMCFunction &function) {
+  return std::count_if(function.code.begin(), function.code.end(),
+                       [](const IMCInstruction &instruction) {
+                         return instruction.opcode != IMCOpcode::Label;
+                       });
+}
+} // namespace
+
+void InlineReport::print(std::ostream &out) const {
+  out << "inlining: inlined " << this->calls << " calls to "
+      << this->functions << " functions" << std::endl;
+}
+
+Inliner::Inliner(IMCProgram &program)
+    : m_Program(program), m_Owners(program.owners()),
+      m_Callees(program.functions.size()),
+      m_Inlined(program.functions.size(), false) {
+  for (std::size_t i = 0; i < program.functions.size(); i++) {
+    std::vector<uint32_t> &callees = this->m_Callees[i];
+    for (const IMCInstruction &instruction : program.functions[i].code) {
+      if (instruction.opcode == IMCOpcode::Call) {
+        callees.push_back(instruction.src1);
+      }
+    }
+    std::sort(callees.begin(), callees.end());
+    callees.erase(std::unique(callees.begin(), callees.end()), callees.end());
+  }
+}
+
+InlineReport Inliner::run() {
+  // callees before their callers: a depth-first postorder of the call
+  // graph, from main and then from whatever main never calls
+  std::size_t count = this->m_Program.functions.size();
+  std::vector<uint32_t> order;
+  std::vector<bool> visited(count, false);
+  for (uint32_t root = 0; root < count; root++) {
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = true;
+    std::vector<std::pair<uint32_t, std::size_t>> stack = {{root, 0}};
+    while (!stack.empty()) {
+      auto &[function, next] = stack.back();
+      if (next == this->m_Callees[function].size()) {
+        order.push_back(function);
+        stack.pop_back();
+        continue;
+      }
+      uint32_t callee = this->m_Callees[function][next++];
+      if (!visited[callee]) {
+        visited[callee] = true;
+        stack.emplace_back(callee, 0);
+      }
+    }
+  }
+
+  InlineReport report;
+  for (uint32_t function : order) {
+    this->inline_calls(function, report);
+  }
+  report.functions = std::count(this->m_Inlined.begin(),
+                                 this->m_Inlined.end(), true);
+  return report;
+}
+
+bool Inliner::recursive(uint32_t function) const {
+  std::vector<bool> seen(this->m_Program.functions.size(), false);
+  std::vector<uint32_t> work = this->m_Callees[function];
+  while (!work.empty()) {
+    uint32_t callee = work.back();
+    work.pop_back();
+    if (callee == function) {
+      return true;
+    }
+    if (!seen[callee]) {
+      seen[callee] = true;
+      work.insert(work.end(), this->m_Callees[callee].begin(),
+                  this->m_Callees[callee].end());
+    }
+  }
+  return false;
+}
+
+bool Inliner::inlinable(uint32_t callee, std::size_t caller_size) const {
+  const IMCFunction &function = this->m_Program.functions[callee];
+  // the arguments, the call and the return go away
+  std::size_t saved = function.params.size() + 2;
+  std::size_t body = size(function);
+  return callee != 0 && !function.code.empty() &&
+         body <= saved + INLINE_LIMIT &&
+         caller_size + body <= GROWTH_LIMIT && !this->recursive(callee);
+}
+
+void Inliner::inline_calls(uint32_t caller, InlineReport &report) {
+  std::vector<IMCInstruction> original =
+      std::move(this->m_Program.functions[caller].code);
+  std::size_t grown = original.size();
+  std::vector<IMCInstruction> code;
+  std::vector<OperandId> arguments;
+  for (const IMCInstruction &instruction : original) {
+    if (instruction.opcode == IMCOpcode::Call &&
+        arguments.size() ==
+            this->m_Program.functions[instruction.src1].params.size() &&
+        this->inlinable(instruction.src1, grown)) {
+      code.erase(code.end() - arguments.size(), code.end());
+      this->expand(caller, instruction, arguments, code);
+      grown += size(this->m_Program.functions[instruction.src1]);
+      this->m_Inlined[instruction.src1] = true;
+      report.calls++;
+    } else {
+      code.push_back(instruction);
+    }
+
+    if (instruction.opcode == IMCOpcode::Arg) {
+      arguments.push_back(instruction.src1);
+    } else {
+      arguments.clear();
+    }
+  }
+  this->m_Program.functions[caller].code = std::move(code);
+}
+
+void Inliner::expand(uint32_t caller_index, const IMCInstruction &call,
+                     const std::vector<OperandId> &arguments,
+                     std::vector<IMCInstruction> &code) {
+  IMCProgram &program = this->m_Program;
+  IMCFunction &caller = program.functions[caller_index];
+  const IMCFunction &callee = program.functions[call.src1];
+
+  // fresh places for everything private to the callee
+  std::vector<OperandId> temps;
+  for (TypeId type : callee.temps) {
+    temps.push_back(caller.new_temp(type));
+  }
+  std::vector<OperandId> variables(program.variables.size(), IMCOperand::NONE);
+  for (uint32_t v = 0; v < variables.size(); v++) {
+    if (this->m_Owners[v] == call.src1) {
+      variables[v] = IMCOperand::variable(
+          static_cast<uint32_t>(program.variables.size()));
+      program.variables.push_back(program.variables[v]);
+      this->m_Owners.push_back(caller_index);
+      caller.locals.push_back(variables[v]);
+    }
+  }
+  auto place = [&](OperandId operand) {
+    if (operand == IMCOperand::NONE) {
+      return operand;
+    }
+    uint32_t index = IMCOperand::index(operand);
+    switch (IMCOperand::kind(operand)) {
+    case IMCOperand::Kind::Temp:
+      return temps[index];
+    case IMCOperand::Kind::Variable:
+      return index < variables.size() && variables[index] != IMCOperand::NONE
+                 ? variables[index]
+                 : operand;
+    default:
+      return operand;
+    }
+  };
+  uint32_t labels = caller.label_count;
+  caller.label_count += callee.label_count + 1;
+  uint32_t end = labels + callee.label_count;
+
+  // the arguments are all read before any parameter is written, since an
+  // argument may be a shared parameter itself
+  std::vector<OperandId> values;
+  for (OperandId argument : arguments) {
+    values.push_back(caller.new_temp(program.type_of(caller, argument)));
+    code.push_back(IMCInstruction{IMCOpcode::Copy, values.back(), argument});
+  }
+  for (std::size_t k = 0; k < values.size(); k++) {
+    code.push_back(
+        IMCInstruction{IMCOpcode::Copy, place(callee.params[k]), values[k]});
+  }
+  for (uint32_t v = 0; v < variables.size(); v++) {
+    OperandId variable = IMCOperand::variable(v);
+    if (variables[v] == IMCOperand::NONE ||
+        std::find(callee.params.begin(), callee.params.end(), variable) !=
+            callee.params.end()) {
+      continue;
+    }
+    uint32_t initial = program.variables[v].type == TypeId::Text
+                           ? program.constants.intern_text("")
+                           : program.constants.intern_number(0);
+    code.push_back(IMCInstruction{IMCOpcode::Copy, variables[v],
+                                  IMCOperand::constant(initial)});
+  }
+
+  for (std::size_t i = 0; i < callee.code.size(); i++) {
+    IMCInstruction instruction = callee.code[i];
+    switch (instruction.opcode) {
+    case IMCOpcode::Label:
+    case IMCOpcode::Jump:
+    case IMCOpcode::JumpIfEq:
+    case IMCOpcode::JumpIfGrt:
+      instruction.dst += labels;
+      break;
+    case IMCOpcode::Call:
+      instruction.dst = place(instruction.dst);
+      code.push_back(instruction);
+      continue;
+    case IMCOpcode::Return:
+      // a function that ends without returning a value gives zero, or ""
+      if (call.dst != IMCOperand::NONE && instruction.src1 != IMCOperand::NONE) {
+        code.push_back(
+            IMCInstruction{IMCOpcode::Copy, call.dst, place(instruction.src1)});
+      } else if (call.dst != IMCOperand::NONE) {
+        uint32_t zero = program.type_of(caller, call.dst) == TypeId::Text
+                            ? program.constants.intern_text("")
+                            : program.constants.intern_number(0);
+        code.push_back(IMCInstruction{IMCOpcode::Copy, call.dst,
+                                      IMCOperand::constant(zero)});
+      }
+      if (i + 1 < callee.code.size()) {
+        code.push_back(IMCInstruction{IMCOpcode::Jump, end});
+      }
+      continue;
+    default:
+      if (writes_dst(instruction.opcode)) {
+        instruction.dst = place(instruction.dst);
+      }
+      break;
+    }
+    instruction.src1 = place(instruction.src1);
+    instruction.src2 = place(instruction.src2);
+    code.push_back(instruction);
+  }
+  code.push_back(IMCInstruction{IMCOpcode::Label, end});
+}
@@ -0,0 +1,67 @@
+#include <cstring>
+#include <interner.h>
+#include <stdexcept>
+
+Interner::Interner() : m_BlockUsed(BLOCK_SIZE) {}
+
+Interner &Interner::global() {
+  static Interner pool;
+  return pool;
+}
+
+std::string_view Interner::store(std::string_view text) {
+  if (text.empty()) {
+    return std::string_view();
+  }
+
+  if (text.size() > BLOCK_SIZE / 4) {
+    // large strings get a dedicated block so they don't waste the tail of
+    // the current one
+    auto block = std::make_unique<char[]>(text.size());
+    std::memcpy(block.get(), text.data(), text.size());
+    std::string_view stored(block.get(), text.size());
+    this->m_LargeBlocks.push_back(std::move(block));
+    return stored;
+  }
+
+  if (this->m_BlockUsed + text.size() > BLOCK_SIZE) {
+    this->m_Blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+    this->m_BlockUsed = 0;
+  }
+
+  char *dest = this->m_Blocks.back().get() + this->m_BlockUsed;
+  std::memcpy(dest, text.data(), text.size());
+  this->m_BlockUsed += text.size();
+  return std::string_view(dest, text.size());
+}
+
+Interner::Id Interner::intern(std::string_view text) {
+  auto existing = this->m_Index.find(text);
+  if (existing != this->m_Index.end()) {
+    return existing->second;
+  }
+
+  Id id = static_cast<Id>(this->m_Strings.size());
+  std::string_view stored = this->store(text);
+  this->m_Strings.push_back(stored);
+  this->m_Index.emplace(stored, id);
+  return id;
+}
+
+Interner::Id Interner::find(std::string_view text) const {
+  auto existing = this->m_Index.find(text);
+  if (existing == this->m_Index.end()) {
+    return INVALID;
+  }
+  return existing->second;
+}
+
+std::string_view Interner::view(Id id) const {
+  if (id >= this->m_Strings.size()) {
+    throw std::out_of_range("Invalid interned string id " +
+                            std::to_string(id));
+  }
+  return this->m_Strings[id];
+}
+
+std::size_t Interner::size() const { return this->m_Strings.size(); }
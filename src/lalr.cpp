@@ -0,0 +1,624 @@
+#include <algorithm>
+#include <deque>
+#include <lalr.h>
+#include <map>
+#include <parse_table.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// set of terminal ids; one extra bit is used for the propagation marker
+class TerminalSet {
+public:
+  explicit TerminalSet(int size) : m_Words((size + 63) / 64, 0) {}
+
+  bool insert(int terminal) {
+    uint64_t bit = uint64_t(1) << (terminal % 64);
+    uint64_t &word = this->m_Words[terminal / 64];
+    bool added = !(word & bit);
+    word |= bit;
+    return added;
+  }
+
+  bool contains(int terminal) const {
+    return this->m_Words[terminal / 64] & (uint64_t(1) << (terminal % 64));
+  }
+
+  bool merge(const TerminalSet &other) {
+    bool changed = false;
+    for (std::size_t i = 0; i < this->m_Words.size(); i++) {
+      uint64_t merged = this->m_Words[i] | other.m_Words[i];
+      changed |= merged != this->m_Words[i];
+      this->m_Words[i] = merged;
+    }
+    return changed;
+  }
+
+private:
+  std::vector<uint64_t> m_Words;
+};
+
+// an LR(0) item: a rule with a dot position, packed so that sorting items
+// orders them by rule first
+using Item = uint32_t;
+
+Item make_item(int rule, int dot) {
+  return (static_cast<uint32_t>(rule) << 16) | static_cast<uint32_t>(dot);
+}
+int item_rule(Item item) { return static_cast<int>(item >> 16); }
+int item_dot(Item item) { return static_cast<int>(item & 0xffff); }
+
+using Kernel = std::vector<Item>;
+using ItemSet = std::map<Item, TerminalSet>;
+
+class LalrBuilder {
+public:
+  explicit LalrBuilder(const Grammar &grammar)
+      : m_Grammar(grammar), m_Marker(grammar.terminal_count()),
+        m_SetSize(grammar.terminal_count() + 1) {
+    this->compute_first_sets();
+    this->build_lr0_automaton();
+    this->compute_lookaheads();
+  }
+
+  int state_count() const { return static_cast<int>(this->m_Kernels.size()); }
+  const Kernel &kernel(int state) const { return this->m_Kernels[state]; }
+  const std::map<int, int> &transitions(int state) const {
+    return this->m_Transitions[state];
+  }
+
+  // LR(1) closure of a state, with the final kernel lookaheads
+  ItemSet closure(int state) const {
+    ItemSet items;
+    for (std::size_t i = 0; i < this->m_Kernels[state].size(); i++) {
+      items.emplace(this->m_Kernels[state][i], this->m_Lookaheads[state][i]);
+    }
+    this->close(items);
+    return items;
+  }
+
+private:
+  const Grammar &m_Grammar;
+  int m_Marker;
+  int m_SetSize;
+
+  std::vector<bool> m_Nullable;
+  std::vector<TerminalSet> m_First;
+  std::vector<std::vector<int>> m_RulesFor;
+
+  std::vector<Kernel> m_Kernels;
+  std::vector<std::map<int, int>> m_Transitions;
+  std::vector<std::vector<TerminalSet>> m_Lookaheads;
+
+  int nonterminal_index(int symbol) const {
+    return symbol - this->m_Grammar.terminal_count();
+  }
+
+  const std::vector<Grammar::Rule> &rules() const {
+    return this->m_Grammar.rules();
+  }
+
+  void compute_first_sets() {
+    int count = this->m_Grammar.nonterminal_count();
+    this->m_Nullable.assign(count, false);
+    this->m_First.assign(count, TerminalSet(this->m_SetSize));
+    this->m_RulesFor.assign(count, {});
+
+    for (std::size_t r = 0; r < this->rules().size(); r++) {
+      this->m_RulesFor[this->nonterminal_index(this->rules()[r].lhs)]
+          .push_back(static_cast<int>(r));
+    }
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (const auto &rule : this->rules()) {
+        int lhs = this->nonterminal_index(rule.lhs);
+        bool nullable = true;
+        for (int symbol : rule.rhs) {
+          if (this->m_Grammar.is_terminal(symbol)) {
+            changed |= this->m_First[lhs].insert(symbol);
+            nullable = false;
+            break;
+          }
+
+          int index = this->nonterminal_index(symbol);
+          changed |= this->m_First[lhs].merge(this->m_First[index]);
+          if (!this->m_Nullable[index]) {
+            nullable = false;
+            break;
+          }
+        }
+
+        if (nullable && !this->m_Nullable[lhs]) {
+          this->m_Nullable[lhs] = true;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // adds FIRST(rhs[from..]) to set; returns whether that suffix is nullable
+  bool first_of_suffix(const Grammar::Rule &rule, std::size_t from,
+                       TerminalSet &set) const {
+    for (std::size_t i = from; i < rule.rhs.size(); i++) {
+      int symbol = rule.rhs[i];
+      if (this->m_Grammar.is_terminal(symbol)) {
+        set.insert(symbol);
+        return false;
+      }
+
+      int index = this->nonterminal_index(symbol);
+      set.merge(this->m_First[index]);
+      if (!this->m_Nullable[index]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void close(ItemSet &items) const {
+    std::deque<Item> work;
+    for (const auto &entry : items) {
+      work.push_back(entry.first);
+    }
+
+    while (!work.empty()) {
+      Item item = work.front();
+      work.pop_front();
+
+      const Grammar::Rule &rule = this->rules()[item_rule(item)];
+      std::size_t dot = item_dot(item);
+      if (dot >= rule.rhs.size() ||
+          this->m_Grammar.is_terminal(rule.rhs[dot])) {
+        continue;
+      }
+
+      TerminalSet lookahead(this->m_SetSize);
+      if (this->first_of_suffix(rule, dot + 1, lookahead)) {
+        lookahead.merge(items.at(item));
+      }
+
+      for (int r : this->m_RulesFor[this->nonterminal_index(rule.rhs[dot])]) {
+        Item start = make_item(r, 0);
+        auto existing = items.find(start);
+        if (existing == items.end()) {
+          items.emplace(start, lookahead);
+          work.push_back(start);
+        } else if (existing->second.merge(lookahead)) {
+          work.push_back(start);
+        }
+      }
+    }
+  }
+
+  void build_lr0_automaton() {
+    std::map<Kernel, int> ids;
+    this->m_Kernels.push_back({make_item(0, 0)});
+    ids.emplace(this->m_Kernels.front(), 0);
+
+    for (std::size_t state = 0; state < this->m_Kernels.size(); state++) {
+      ItemSet items;
+      for (Item item : this->m_Kernels[state]) {
+        items.emplace(item, TerminalSet(this->m_SetSize));
+      }
+      this->close(items);
+
+      // items advanced over each symbol form the kernel of its successor
+      std::map<int, Kernel> successors;
+      for (const auto &entry : items) {
+        const Grammar::Rule &rule = this->rules()[item_rule(entry.first)];
+        std::size_t dot = item_dot(entry.first);
+        if (dot < rule.rhs.size()) {
+          successors[rule.rhs[dot]].push_back(
+              make_item(item_rule(entry.first), static_cast<int>(dot) + 1));
+        }
+      }
+
+      std::map<int, int> transitions;
+      for (auto &successor : successors) {
+        Kernel &kernel = successor.second;
+        std::sort(kernel.begin(), kernel.end());
+
+        auto existing = ids.find(kernel);
+        if (existing == ids.end()) {
+          existing = ids.emplace(kernel, static_cast<int>(ids.size())).first;
+          this->m_Kernels.push_back(kernel);
+        }
+        transitions.emplace(successor.first, existing->second);
+      }
+      this->m_Transitions.push_back(std::move(transitions));
+    }
+  }
+
+  // lookaheads are generated spontaneously or propagated from the kernel
+  // item they were derived from; closing each kernel item on its own with a
+  // marker lookahead tells the two apart
+  void compute_lookaheads() {
+    struct Edge {
+      int state, item, target_state, target_item;
+    };
+
+    this->m_Lookaheads.clear();
+    for (const auto &kernel : this->m_Kernels) {
+      this->m_Lookaheads.emplace_back(kernel.size(),
+                                      TerminalSet(this->m_SetSize));
+    }
+    this->m_Lookaheads[0][0].insert(this->m_Grammar.end_marker());
+
+    std::vector<Edge> edges;
+    for (int state = 0; state < this->state_count(); state++) {
+      const Kernel &kernel = this->m_Kernels[state];
+      for (std::size_t k = 0; k < kernel.size(); k++) {
+        ItemSet items;
+        TerminalSet marker(this->m_SetSize);
+        marker.insert(this->m_Marker);
+        items.emplace(kernel[k], marker);
+        this->close(items);
+
+        for (const auto &entry : items) {
+          const Grammar::Rule &rule = this->rules()[item_rule(entry.first)];
+          std::size_t dot = item_dot(entry.first);
+          if (dot >= rule.rhs.size()) {
+            continue;
+          }
+
+          int target = this->m_Transitions[state].at(rule.rhs[dot]);
+          const Kernel &targetKernel = this->m_Kernels[target];
+          Item advanced =
+              make_item(item_rule(entry.first), static_cast<int>(dot) + 1);
+          int targetItem = static_cast<int>(
+              std::lower_bound(targetKernel.begin(), targetKernel.end(),
+                               advanced) -
+              targetKernel.begin());
+
+          TerminalSet &lookahead = this->m_Lookaheads[target][targetItem];
+          for (int t = 0; t < this->m_Grammar.terminal_count(); t++) {
+            if (entry.second.contains(t)) {
+              lookahead.insert(t);
+            }
+          }
+          if (entry.second.contains(this->m_Marker)) {
+            edges.push_back({state, static_cast<int>(k), target, targetItem});
+          }
+        }
+      }
+    }
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (const Edge &edge : edges) {
+        const TerminalSet &from = this->m_Lookaheads[edge.state][edge.item];
+        changed |=
+            this->m_Lookaheads[edge.target_state][edge.target_item].merge(from);
+      }
+    }
+  }
+};
+
+std::string csv_field(const std::string &text) {
+  if (text.find(',') == std::string::npos) {
+    return text;
+  }
+  return "\"" + text + "\"";
+}
+
+std::string action_name(int16_t action) {
+  if (action == ParseTable::ACCEPT) {
+    return "acc";
+  } else if (ParseTable::is_shift(action)) {
+    return "s" + std::to_string(ParseTable::shift_state(action));
+  } else if (ParseTable::is_reduce(action)) {
+    return "r" + std::to_string(ParseTable::reduce_rule(action));
+  }
+  return "";
+}
+
+struct PackedRows {
+  std::vector<uint16_t> base;
+  std::vector<int16_t> next;
+  std::vector<int16_t> check;
+};
+
+// overlays sparse rows into one array, placing the fullest rows first
+PackedRows pack_rows(const std::vector<std::vector<std::pair<int, int16_t>>> &rows,
+                     int width) {
+  std::vector<int> order(rows.size());
+  for (std::size_t i = 0; i < order.size(); i++) {
+    order[i] = static_cast<int>(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&rows](int a, int b) {
+    return rows[a].size() > rows[b].size();
+  });
+
+  PackedRows packed;
+  packed.base.assign(rows.size(), 0);
+  std::vector<bool> used;
+  int end = 0;
+
+  for (int row : order) {
+    if (rows[row].empty()) {
+      continue;
+    }
+
+    int base = 0;
+    for (;; base++) {
+      bool fits = true;
+      for (const auto &cell : rows[row]) {
+        std::size_t slot = base + cell.first;
+        if (slot < used.size() && used[slot]) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) {
+        break;
+      }
+    }
+
+    if (base > UINT16_MAX) {
+      throw std::runtime_error("Parse table too large to compress");
+    }
+
+    packed.base[row] = static_cast<uint16_t>(base);
+    for (const auto &cell : rows[row]) {
+      std::size_t slot = base + cell.first;
+      if (slot >= used.size()) {
+        used.resize(slot + 1, false);
+        packed.next.resize(slot + 1, 0);
+        packed.check.resize(slot + 1, -1);
+      }
+      used[slot] = true;
+      packed.next[slot] = cell.second;
+      packed.check[slot] = static_cast<int16_t>(row);
+    }
+    end = std::max(end, base + width);
+  }
+
+  // every row may be probed over its full width
+  packed.next.resize(std::max<std::size_t>(end, width), 0);
+  packed.check.resize(packed.next.size(), -1);
+  return packed;
+}
+
+} // namespace
+
+Grammar Grammar::parse(std::string_view source) {
+  struct RawRule {
+    std::string lhs;
+    std::vector<std::string> rhs;
+  };
+
+  std::vector<RawRule> raw;
+  std::istringstream stream{std::string(source)};
+  std::string line;
+  while (std::getline(stream, line)) {
+    std::istringstream words(line);
+    RawRule rule;
+    std::string arrow, symbol;
+    if (!(words >> rule.lhs)) {
+      continue;
+    }
+    if (!(words >> arrow) || arrow != "->") {
+      throw std::runtime_error("Invalid grammar rule: " + line);
+    }
+
+    while (words >> symbol) {
+      if (symbol != "''") {
+        rule.rhs.push_back(symbol);
+      }
+    }
+    raw.push_back(rule);
+  }
+
+  if (raw.empty()) {
+    throw std::runtime_error("Grammar has no rules");
+  }
+
+  std::vector<std::string> nonterminals;
+  for (const auto &rule : raw) {
+    if (std::find(nonterminals.begin(), nonterminals.end(), rule.lhs) ==
+        nonterminals.end()) {
+      nonterminals.push_back(rule.lhs);
+    }
+  }
+
+  Grammar grammar;
+  for (const auto &rule : raw) {
+    for (const auto &symbol : rule.rhs) {
+      if (symbol == END_MARKER) {
+        throw std::runtime_error("Grammar uses the reserved symbol $");
+      }
+      bool nonterminal = std::find(nonterminals.begin(), nonterminals.end(),
+                                   symbol) != nonterminals.end();
+      if (!nonterminal && grammar.symbol_id(symbol) < 0) {
+        grammar.m_Symbols.push_back(symbol);
+      }
+    }
+  }
+  grammar.m_Symbols.emplace_back(END_MARKER);
+  grammar.m_TerminalCount = static_cast<int>(grammar.m_Symbols.size());
+  grammar.m_Symbols.insert(grammar.m_Symbols.end(), nonterminals.begin(),
+                           nonterminals.end());
+
+  for (const auto &rule : raw) {
+    Rule resolved{grammar.symbol_id(rule.lhs), {}};
+    for (const auto &symbol : rule.rhs) {
+      if (symbol == raw.front().lhs) {
+        throw std::runtime_error("Start symbol " + symbol +
+                                 " may not appear on a right-hand side");
+      }
+      resolved.rhs.push_back(grammar.symbol_id(symbol));
+    }
+    grammar.m_Rules.push_back(resolved);
+  }
+
+  int start = grammar.m_Rules.front().lhs;
+  if (std::count_if(grammar.m_Rules.begin(), grammar.m_Rules.end(),
+                    [start](const Rule &rule) { return rule.lhs == start; }) >
+      1) {
+    throw std::runtime_error("Start symbol " + raw.front().lhs +
+                             " must have exactly one rule");
+  }
+
+  return grammar;
+}
+
+int Grammar::symbol_id(std::string_view name) const {
+  for (std::size_t i = 0; i < this->m_Symbols.size(); i++) {
+    if (this->m_Symbols[i] == name) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+LalrTable LalrTable::build(const Grammar &grammar) {
+  LalrBuilder builder(grammar);
+
+  LalrTable table;
+  table.m_StateCount = builder.state_count();
+  int terminals = grammar.terminal_count();
+  int nonterminals = grammar.nonterminal_count();
+  table.m_Action.assign(table.m_StateCount * terminals, ParseTable::ERROR);
+  table.m_Goto.assign(table.m_StateCount * nonterminals, -1);
+
+  auto set_action = [&table, terminals](int state, int terminal,
+                                        int16_t action) {
+    int16_t &cell = table.m_Action[state * terminals + terminal];
+    if (cell == ParseTable::ERROR) {
+      cell = action;
+    } else if (cell != action) {
+      table.m_Conflicts.push_back({state, terminal, cell, action});
+    }
+  };
+
+  for (int state = 0; state < table.m_StateCount; state++) {
+    for (const auto &transition : builder.transitions(state)) {
+      if (grammar.is_terminal(transition.first)) {
+        set_action(state, transition.first,
+                   ParseTable::encode_shift(transition.second));
+      } else {
+        table.m_Goto[state * nonterminals + transition.first - terminals] =
+            static_cast<int16_t>(transition.second);
+      }
+    }
+
+    for (const auto &entry : builder.closure(state)) {
+      int rule = item_rule(entry.first);
+      if (static_cast<std::size_t>(item_dot(entry.first)) <
+          grammar.rules()[rule].rhs.size()) {
+        continue;
+      }
+
+      for (int t = 0; t < terminals; t++) {
+        if (!entry.second.contains(t)) {
+          continue;
+        }
+        set_action(state, t,
+                   rule == 0 ? ParseTable::ACCEPT
+                             : ParseTable::encode_reduce(rule));
+      }
+    }
+  }
+
+  return table;
+}
+
+std::string LalrTable::describe(const Grammar &grammar,
+                                const Conflict &conflict) const {
+  bool shift = ParseTable::is_shift(conflict.kept) ||
+               ParseTable::is_shift(conflict.rejected);
+  return std::string(shift ? "shift/reduce" : "reduce/reduce") +
+         " conflict in state " + std::to_string(conflict.state) + " on '" +
+         grammar.symbol_name(conflict.terminal) + "': " +
+         action_name(conflict.kept) + " vs " + action_name(conflict.rejected);
+}
+
+std::string LalrTable::to_csv(const Grammar &grammar) const {
+  int terminals = grammar.terminal_count();
+  int nonterminals = grammar.nonterminal_count();
+  std::ostringstream out;
+
+  out << "State,ACTION" << std::string(terminals - 1, ',') << ",GOTO"
+      << std::string(nonterminals - 1, ',') << "\n";
+  for (int symbol = 0; symbol < grammar.symbol_count(); symbol++) {
+    out << "," << csv_field(grammar.symbol_name(symbol));
+  }
+  out << "\n";
+
+  for (int state = 0; state < this->m_StateCount; state++) {
+    out << state;
+    for (int t = 0; t < terminals; t++) {
+      out << "," << action_name(this->m_Action[state * terminals + t]);
+    }
+    for (int n = 0; n < nonterminals; n++) {
+      int16_t target = this->m_Goto[state * nonterminals + n];
+      out << ",";
+      if (target >= 0) {
+        out << target;
+      }
+    }
+    out << "\n";
+  }
+
+  return out.str();
+}
+
+CompressedTable CompressedTable::compress(const std::vector<int16_t> &action,
+                                          const std::vector<int16_t> &go_to,
+                                          int terminal_count,
+                                          int nonterminal_count,
+                                          int state_count) {
+  CompressedTable table;
+  table.terminal_count = terminal_count;
+  table.nonterminal_count = nonterminal_count;
+  table.state_count = state_count;
+  table.action_default.assign(state_count, ParseTable::ERROR);
+
+  std::vector<std::vector<std::pair<int, int16_t>>> actionRows(state_count);
+  std::vector<std::vector<std::pair<int, int16_t>>> gotoRows(state_count);
+
+  for (int state = 0; state < state_count; state++) {
+    const int16_t *row = action.data() + state * terminal_count;
+
+    // the most frequent reduction becomes the default; ties go to the
+    // reduction seen first
+    std::map<int16_t, int> counts;
+    int16_t best = ParseTable::ERROR;
+    for (int t = 0; t < terminal_count; t++) {
+      if (ParseTable::is_reduce(row[t]) &&
+          ++counts[row[t]] > (best == ParseTable::ERROR ? 0 : counts[best])) {
+        best = row[t];
+      }
+    }
+    table.action_default[state] = best;
+
+    for (int t = 0; t < terminal_count; t++) {
+      if (row[t] != ParseTable::ERROR && row[t] != best) {
+        actionRows[state].emplace_back(t, row[t]);
+      }
+    }
+
+    for (int n = 0; n < nonterminal_count; n++) {
+      int16_t target = go_to[state * nonterminal_count + n];
+      if (target >= 0) {
+        gotoRows[state].emplace_back(n, target);
+      }
+    }
+  }
+
+  PackedRows actions = pack_rows(actionRows, terminal_count);
+  table.action_base = std::move(actions.base);
+  table.action_next = std::move(actions.next);
+  table.action_check = std::move(actions.check);
+
+  PackedRows gotos = pack_rows(gotoRows, nonterminal_count);
+  table.goto_base = std::move(gotos.base);
+  table.goto_next = std::move(gotos.next);
+  table.goto_check = std::move(gotos.check);
+
+  return table;
+}
@@ -1,14 +1,30 @@
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <lexer.h>
 #include <optional>
 #include <regex>
+#include <sstream>
+#include <string_view>
 #include <vector>
 
-Lexer::Lexer(const std::string &input)
-{
+Lexer::Lexer(std::string_view input, LexerEngine engine)
+    : m_Engine(engine), m_Input(input) {
+  if (this->m_Engine == LexerEngine::Table) {
+    // the table engine scans the original buffer in place and resolves
+    // token locations through an index of line start offsets
+    this->m_LineStarts.push_back(0);
+    std::size_t newline = 0;
+    while ((newline = input.find('\n', newline)) != std::string::npos) {
+      this->m_LineStarts.push_back(++newline);
+    }
+    return;
+  }
+
   // split the input line by line and store in a vector
   // of strings (data to be used later during type checking)
-  std::stringstream ss(input);
+  this->m_Source = std::string(input);
+  std::stringstream ss(this->m_Source);
   std::string line;
 
   // loop until the end of the string
@@ -17,7 +33,6 @@ Lexer::Lexer(const std::string &input)
       this->unprocessed_input.push_back(line);
   }
 
-  this->m_Source = input;
   std::size_t loc;
   while ((loc = this->m_Source.find("\n")) != std::string::npos) {
     this->m_Source.replace(loc, 1, " ");
@@ -28,7 +43,7 @@ Lexer::Lexer(const std::string &input)
 
   // add spaces around all punctuation marks
   std::string pre_processed_input =
-      std::regex_replace(input, punctuation_regex, " $1 ");
+      std::regex_replace(std::string(input), punctuation_regex, " $1 ");
 
   std::regex space_regex("\\s+"); // match any sequence of whitespace characters
                                   // (spaces, tabs, newlines)
@@ -41,6 +56,223 @@ Lexer::Lexer(const std::string &input)
 }
 
 std::optional<Token> Lexer::next_token() {
+  if (this->m_Engine == LexerEngine::Table) {
+    return this->next_token_table();
+  }
+
+  return this->next_token_regex();
+}
+
+std::pair<std::size_t, std::size_t> Lexer::token_offsets() const {
+  return {this->m_TokenStart, this->m_TokenEnd};
+}
+
+SourceSpan Lexer::locate(std::size_t offset, std::size_t length) const {
+  auto next_line = std::upper_bound(this->m_LineStarts.begin(),
+                                    this->m_LineStarts.end(), offset);
+  std::size_t line = std::distance(this->m_LineStarts.begin(), next_line);
+  std::size_t column = offset - (line > 0 ? *std::prev(next_line) : 0) + 1;
+
+  return {static_cast<uint32_t>(line), static_cast<uint32_t>(column),
+          static_cast<uint32_t>(offset), static_cast<uint32_t>(length)};
+}
+
+const std::vector<std::size_t> &Lexer::line_starts() const {
+  return this->m_LineStarts;
+}
+
+namespace {
+
+enum CharClass : uint8_t { Blank, Punct, Word };
+
+constexpr std::array<uint8_t, 256> make_char_classes() {
+  std::array<uint8_t, 256> classes{};
+  for (auto &c : classes) {
+    c = CharClass::Word;
+  }
+  for (unsigned char c : {' ', '\t', '\n', '\r', '\f', '\v'}) {
+    classes[c] = CharClass::Blank;
+  }
+  for (unsigned char c : {';', ',', '(', ')', '=', '{', '}'}) {
+    classes[c] = CharClass::Punct;
+  }
+  return classes;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = make_char_classes();
+
+constexpr bool is_lower(char c) { return c >= 'a' && c <= 'z'; }
+constexpr bool is_upper(char c) { return c >= 'A' && c <= 'Z'; }
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// V_[a-z]([a-z]|[0-9])* and F_[a-z]([a-z]|[0-9])*
+bool match_name(std::string_view word, char prefix) {
+  if (word.size() < 3 || word[0] != prefix || word[1] != '_' ||
+      !is_lower(word[2])) {
+    return false;
+  }
+  for (std::size_t i = 3; i < word.size(); i++) {
+    if (!is_lower(word[i]) && !is_digit(word[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// "[A-Z][a-z]{0,7}"
+bool match_string_literal(std::string_view word) {
+  if (word.size() < 3 || word.size() > 10 || word.front() != '"' ||
+      word.back() != '"' || !is_upper(word[1])) {
+    return false;
+  }
+  for (std::size_t i = 2; i + 1 < word.size(); i++) {
+    if (!is_lower(word[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// (0|-?[1-9]*[0-9](\.[0-9]*[1-9])?) as an explicit DFA
+bool match_num_literal(std::string_view word) {
+  enum State { Start, Sign, Int, IntZero, Frac, FracEnd, Reject };
+  State state = Start;
+
+  for (char c : word) {
+    bool zero = c == '0';
+    bool nonzero = c >= '1' && c <= '9';
+
+    switch (state) {
+    case Start:
+      state = c == '-' ? Sign : zero ? IntZero : nonzero ? Int : Reject;
+      break;
+    case Sign:
+      state = zero ? IntZero : nonzero ? Int : Reject;
+      break;
+    case Int:
+      state = c == '.' ? Frac : zero ? IntZero : nonzero ? Int : Reject;
+      break;
+    case IntZero:
+      state = c == '.' ? Frac : Reject;
+      break;
+    case Frac:
+    case FracEnd:
+      state = zero ? Frac : nonzero ? FracEnd : Reject;
+      break;
+    case Reject:
+      return false;
+    }
+  }
+
+  return state == Int || state == IntZero || state == FracEnd;
+}
+
+constexpr std::pair<std::string_view, enum Keyword> KEYWORDS[] = {
+    {"main", Keyword::Main},    {"num", Keyword::Num},
+    {"text", Keyword::Text},    {"begin", Keyword::Begin},
+    {"end", Keyword::End},      {"skip", Keyword::Skip},
+    {"halt", Keyword::Halt},    {"print", Keyword::Print},
+    {"<input", Keyword::Input}, {"if", Keyword::If},
+    {"then", Keyword::Then},    {"else", Keyword::Else},
+    {"not", Keyword::Not},      {"sqrt", Keyword::Sqrt},
+    {"or", Keyword::Or},        {"and", Keyword::And},
+    {"eq", Keyword::Eq},        {"grt", Keyword::Grt},
+    {"add", Keyword::Add},      {"sub", Keyword::Sub},
+    {"mul", Keyword::Mul},      {"div", Keyword::Div},
+    {"void", Keyword::Void},    {"return", Keyword::Return},
+};
+
+std::optional<Token> classify_word(std::string_view word) {
+  // every keyword starts with a lowercase letter or '<', which no other
+  // token class can, so only those words need the keyword table
+  if (is_lower(word[0]) || word[0] == '<') {
+    for (const auto &[text, keyword] : KEYWORDS) {
+      if (text == word) {
+        return Token::keyword(keyword);
+      }
+    }
+  } else if (match_name(word, 'V')) {
+    return Token::identifier(word);
+  } else if (match_name(word, 'F')) {
+    return Token::function_name(word);
+  } else if (match_string_literal(word)) {
+    return Token::string_lit(word.substr(1, word.size() - 2));
+  }
+
+  if (match_num_literal(word)) {
+    return Token::num_lit(word);
+  }
+
+  return {};
+}
+
+} // namespace
+
+std::optional<Token> Lexer::next_token_table() {
+  std::string_view source = this->m_Input;
+  std::size_t pos = this->m_Position;
+
+  while (pos < source.size() &&
+         CHAR_CLASSES[static_cast<unsigned char>(source[pos])] ==
+             CharClass::Blank) {
+    pos++;
+  }
+
+  if (pos == source.size()) {
+    this->m_Position = pos;
+    return {};
+  }
+
+  std::size_t start = pos;
+  if (CHAR_CLASSES[static_cast<unsigned char>(source[pos])] ==
+      CharClass::Punct) {
+    pos++;
+  } else {
+    while (pos < source.size() &&
+           CHAR_CLASSES[static_cast<unsigned char>(source[pos])] ==
+               CharClass::Word) {
+      pos++;
+    }
+  }
+
+  this->m_Position = pos;
+  this->m_TokenStart = start;
+  this->m_TokenEnd = pos;
+
+  // token offsets only ever increase, so the current line is found by
+  // advancing through the line index rather than searching it
+  while (this->m_Line + 1 < this->m_LineStarts.size() &&
+         this->m_LineStarts[this->m_Line + 1] <= start) {
+    this->m_Line++;
+  }
+
+  SourceSpan span;
+  span.line = this->m_Line + 1;
+  span.column = start - this->m_LineStarts[this->m_Line] + 1;
+  span.offset = start;
+  span.length = pos - start;
+
+  if (pos - start == 1 &&
+      CHAR_CLASSES[static_cast<unsigned char>(source[start])] ==
+          CharClass::Punct) {
+    Token token = Token::punct(source[start]);
+    token.set_span(span);
+    return token;
+  }
+
+  auto word = source.substr(start, pos - start);
+  std::optional<Token> token = classify_word(word);
+  if (!token.has_value()) {
+    throw LexerException("Invalid Token: \"" + std::string(word) +
+                         "\" at line " + std::to_string(span.line) +
+                         ", column " + std::to_string(span.column));
+  }
+
+  token->set_span(span);
+  return token;
+}
+
+std::optional<Token> Lexer::next_token_regex() {
   if (this->m_Source.empty()) {
     return {};
   }
@@ -168,12 +400,36 @@ TokenStream Lexer::lex_all() {
   std::vector<Token> tokens;
   std::optional<Token> t;
 
-  while ((t = this->next_token()).has_value()) {
-    t.value().set_line_number(this->getTokenLineNumber(t.value().get_str_data()));
+  while ((t = this->next()).has_value()) {
     tokens.push_back(t.value());
   }
 
-  return TokenStream(tokens);
+  return TokenStream(std::move(tokens));
+}
+
+std::optional<Token> Lexer::read_token() {
+  std::optional<Token> token = this->next_token();
+  if (token.has_value() && this->m_Engine == LexerEngine::Regex) {
+    // the regex engine does not track offsets, so lines are recovered by
+    // searching the unprocessed input
+    token.value().set_line_number(
+        this->getTokenLineNumber(token.value().get_str_data()));
+  }
+  return token;
+}
+
+std::optional<Token> Lexer::peek() {
+  if (!this->m_HasLookahead) {
+    this->m_Lookahead = this->read_token();
+    this->m_HasLookahead = true;
+  }
+  return this->m_Lookahead;
+}
+
+std::optional<Token> Lexer::next() {
+  std::optional<Token> token = this->peek();
+  this->m_HasLookahead = false;
+  return token;
 }
 
 int Lexer::getTokenLineNumber(std::string tokenValue) {
@@ -192,16 +448,22 @@ int Lexer::getTokenLineNumber(std::string tokenValue) {
   return -1;
 }
 
-TokenStream::TokenStream(const std::vector<Token> &tokens) {
-  for (auto it = tokens.begin(); it != tokens.end(); it++) {
-    this->m_Tokens.push_back(*it);
-  }
-}
+TokenStream::TokenStream(const std::vector<Token> &tokens)
+    : m_Tokens(tokens) {}
+
+TokenStream::TokenStream(std::vector<Token> &&tokens)
+    : m_Tokens(std::move(tokens)) {}
 
 // auto TokenStream::begin() const { return this->m_Tokens.begin(); }
 // auto TokenStream::end() const { return this->m_Tokens.end(); }
 
-std::vector<Token> TokenStream::getTokens() { return this->m_Tokens; }
+const std::vector<Token> &TokenStream::getTokens() const & {
+  return this->m_Tokens;
+}
+
+std::vector<Token> TokenStream::getTokens() && {
+  return std::move(this->m_Tokens);
+}
 
 std::string TokenStream::to_xml() const {
   std::stringstream stream;
@@ -222,12 +484,17 @@ std::string TokenStream::to_xml() const {
   return stream.str();
 }
 
-std::optional<Token> TokenStream::next() {
-  if (this->m_Tokens.size() == 0) {
+std::optional<Token> TokenStream::peek() {
+  if (this->m_Cursor >= this->m_Tokens.size()) {
     return {};
   }
+  return this->m_Tokens[this->m_Cursor];
+}
 
-  Token ret = this->m_Tokens[this->m_Tokens.size() - 1];
-  this->m_Tokens.pop_back();
-  return ret;
+std::optional<Token> TokenStream::next() {
+  std::optional<Token> token = this->peek();
+  if (token.has_value()) {
+    this->m_Cursor++;
+  }
+  return token;
 }
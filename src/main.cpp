@@ -1,77 +1,184 @@
+#include <bytecode.h>
+#include <codegen.h>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <imc.h>
 #include <iostream>
 #include <lexer.h>
+#include <optimizer.h>
 #include <parser.h>
+#include <optional>
+#include <source_buffer.h>
 #include <typechecker.h>
-#include <sstream>
+#include <unistd.h>
+#include <vm.h>
 
 int main(int argc, const char **argv)
 {
-  if (argc < 2)
+  bool dumpTokens = false;
+  std::string_view emit; // imc, c, asm or runtime
+  bool runProgram = false;
+  bool optimizeImc = false;
+  bool printStats = false;
+  std::size_t maxErrors = DiagnosticEngine::DEFAULT_LIMIT;
+  const char *input = nullptr;
+  for (int i = 1; i < argc; i++)
   {
-    std::cerr << "Usage: splc [file|-]" << std::endl
-              << " `-` - Read input from stdin" << std::endl;
+    std::string_view arg = argv[i];
+    if (i == 1 && arg == "run")
+    {
+      runProgram = true;
+    }
+    else if (arg == "--dump-tokens")
+    {
+      dumpTokens = true;
+    }
+    else if (arg == "--emit=imc" || arg == "--emit=c" || arg == "--emit=asm" || arg == "--emit=runtime")
+    {
+      emit = arg.substr(std::strlen("--emit="));
+    }
+    else if (arg == "-O")
+    {
+      optimizeImc = true;
+    }
+    else if (arg == "--stats")
+    {
+      printStats = true;
+    }
+    else if (arg.rfind("--max-errors=", 0) == 0)
+    {
+      maxErrors = std::strtoul(argv[i] + std::strlen("--max-errors="), nullptr, 10);
+    }
+    else
+    {
+      input = argv[i];
+    }
+  }
+
+  // the runtime is the same for every program
+  if (emit == "runtime")
+  {
+    std::cout << emit_runtime();
+    return 0;
+  }
+
+  if (!input)
+  {
+    std::cerr << "Usage: splc [run] [--dump-tokens] [--emit=imc|c|asm|runtime] [-O] [--stats] [--max-errors=<n>] [file|-]" << std::endl
+              << " `run` - Run the program, reading its input from stdin" << std::endl
+              << " `-` - Read input from stdin" << std::endl
+              << " `--dump-tokens` - Write the token stream to tokens.xml" << std::endl
+              << " `--emit=imc` - Print the intermediate code instead of the syntax tree" << std::endl
+              << " `--emit=c` - Print the program as a self-contained C file" << std::endl
+              << " `--emit=asm` - Print the program as x86-64 assembly for the System V ABI" << std::endl
+              << " `--emit=runtime` - Print the C runtime that assembly output links against" << std::endl
+              << " `-O` - Optimize the intermediate code" << std::endl
+              << " `--stats` - With -O, report what the optimizer removed" << std::endl
+              << " `--max-errors=<n>` - Show at most n type errors (default " << DiagnosticEngine::DEFAULT_LIMIT << ")" << std::endl;
     return -1;
   }
 
-  auto input = argv[1];
   std::string filename = "";
-  std::string source;
-  if (std::string(input) == "-")
+  std::optional<SourceBuffer> source;
+  try
   {
-    std::stringstream stream;
-
-    std::string line;
-    while (std::getline(std::cin, line))
+    if (std::string(input) == "-")
+    {
+      source = SourceBuffer::read(std::cin);
+    }
+    else
     {
-      stream << line << std::endl;
+      filename = input;
+      source = SourceBuffer::open(filename);
     }
-    source = stream.str();
   }
-  else
+  catch (const std::runtime_error &e)
   {
-    filename = input;
-    std::ifstream fs(input);
-    if (!fs.is_open())
+    std::cerr << "Failed to open file! (" << e.what() << ")" << std::endl;
+    return -1;
+  }
+
+  // lexical and syntax analysis; the parser pulls tokens from the lexer as
+  // it goes unless the token stream has to be dumped first
+  auto *lexer = new Lexer(source->text());
+  Parser *parser;
+  if (dumpTokens)
+  {
+    auto stream = lexer->lex_all();
+
+    std::ofstream file("tokens.xml");
+    if (!file.is_open())
     {
-      std::cerr << "Failed to open file!" << std::endl;
       return -1;
     }
 
-    std::stringstream stream;
-    std::string line;
-    while (std::getline(fs, line))
-    {
-      stream << line << std::endl;
-    }
-    source = stream.str();
-  }
+    file << stream.to_xml() << std::endl;
+    file.close();
 
-  // lexical analysis
-  auto *lexer = new Lexer(source);
-  auto stream = lexer->lex_all();
+    parser = new Parser(std::move(stream));
+  }
+  else
+  {
+    parser = new Parser(*lexer);
+  }
 
-  std::ofstream file("tokens.xml");
-  if (!file.is_open())
+  parser->setFilename(filename);
+  parser->setPrintTree(emit.empty() && !runProgram);
+  std::unique_ptr<SyntaxTree> syntaxTree = parser->parse();
+  if (!syntaxTree)
   {
+    delete parser;
+    delete lexer;
     return -1;
   }
 
-  file << stream.to_xml() << std::endl;
-  file.close();
-
-  // syntax analysis
-  auto *parser = new Parser(stream);
-  SyntaxTreeNode *syntaxTreeRoot = parser->parse();
+  // type checking; every error in the program is reported at once
+  DiagnosticReport report = TypeChecker(syntaxTree->getRoot(), maxErrors).check();
+  report.print(std::cerr, filename.empty() ? "<stdin>" : filename, isatty(STDERR_FILENO));
 
-  // type checking
-  auto *typeChecker = new TypeChecker(syntaxTreeRoot);
-  typeChecker->setFilename(filename);
-  typeChecker->check();
+  // translation to intermediate code, for well-typed programs only
+  int status = report.ok() ? 0 : 1;
+  if (report.ok() && (!emit.empty() || runProgram))
+  {
+    IMCProgram program = IMCGenerator(syntaxTree->getRoot()).generate();
+    if (optimizeImc)
+    {
+      OptimizationReport optimized = optimize(program);
+      if (printStats)
+      {
+        optimized.print(std::cerr);
+      }
+    }
+    if (emit == "imc")
+    {
+      std::cout << program.to_string();
+    }
+    else if (emit == "c")
+    {
+      std::cout << emit_c(program);
+    }
+    else if (emit == "asm")
+    {
+      std::cout << emit_asm(program);
+    }
+    if (runProgram)
+    {
+      try
+      {
+        Bytecode bytecode = compile_bytecode(program);
+        VM(bytecode, std::cin, std::cout).run();
+      }
+      catch (const std::exception &e)
+      {
+        std::cerr << "error: " << e.what() << std::endl;
+        status = 1;
+      }
+    }
+  }
 
-  delete typeChecker;
   delete parser;
   delete lexer;
 
-  return 0;
+  return status;
 }
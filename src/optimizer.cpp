@@ -0,0 +1,33 @@
+#include <cfg.h>
+#include <copyprop.h>
+#include <dce.h>
+#include <optimizer.h>
+#include <ssa.h>
+
+void OptimizationReport::print(std::ostream &out) const {
+  this->inlined.print(out);
+  this->constants.print(out);
+  out << "copy propagation: removed " << this->copies << " copies"
+      << std::endl;
+  this->dead.print(out);
+}
+
+OptimizationReport optimize(IMCProgram &program) {
+  OptimizationReport report;
+  report.inlined = Inliner(program).run();
+
+  SSABuilder ssa(program);
+  std::vector<uint32_t> owners = program.owners();
+  for (std::size_t i = 0; i < program.functions.size(); i++) {
+    CFG cfg(program.functions[i]);
+    cfg.compute_dominators();
+    ssa.construct(cfg, i);
+    report.constants += propagate_constants(program, cfg, i);
+    report.copies += propagate_copies(program, ssa, cfg, i);
+    ssa.destruct(cfg, i);
+    report.dead.stores += remove_dead_stores(program, owners, cfg, i);
+    cfg.flatten(program.functions[i]);
+  }
+  report.dead += remove_unused(program);
+  return report;
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <parse_table.h>
+#include <parse_table_data.h>
+#include <stdexcept>
+
+ParseTable ParseTable::from_file_handler(const ParserFileHandler &fileHandler) {
+  auto cells = fileHandler.getParseTable();
+  auto rules = fileHandler.getGrammarRules();
+
+  ParseTable table;
+
+  // nonterminals are exactly the rule heads, in order of first definition;
+  // every other column of the table is a terminal
+  std::vector<std::string> nonterminals;
+  for (const auto &rule : rules) {
+    if (std::find(nonterminals.begin(), nonterminals.end(), rule.first) ==
+        nonterminals.end()) {
+      nonterminals.push_back(rule.first);
+    }
+  }
+
+  std::vector<std::string> &names = table.m_OwnedNames;
+  for (const auto &row : cells) {
+    table.m_StateCount = std::max(table.m_StateCount, std::stoi(row.first) + 1);
+    for (const auto &cell : row.second) {
+      bool known =
+          std::find(names.begin(), names.end(), cell.first) != names.end();
+      bool nonterminal = std::find(nonterminals.begin(), nonterminals.end(),
+                                   cell.first) != nonterminals.end();
+      if (!known && !nonterminal) {
+        names.push_back(cell.first);
+      }
+    }
+  }
+
+  table.m_TerminalCount = static_cast<int>(names.size());
+  table.m_NonterminalCount = static_cast<int>(nonterminals.size());
+  names.insert(names.end(), nonterminals.begin(), nonterminals.end());
+  table.m_OwnedSymbols.assign(names.begin(), names.end());
+  table.m_Symbols = table.m_OwnedSymbols.data();
+
+  std::vector<Action> actions(table.m_StateCount * table.m_TerminalCount,
+                              ERROR);
+  std::vector<int16_t> gotos(table.m_StateCount * table.m_NonterminalCount, -1);
+
+  for (const auto &row : cells) {
+    int state = std::stoi(row.first);
+    for (const auto &cell : row.second) {
+      const std::string &value = cell.second;
+      if (value.empty()) {
+        continue;
+      }
+
+      int symbol = table.symbol_id(cell.first);
+      if (!table.is_terminal(symbol)) {
+        gotos[state * table.m_NonterminalCount +
+              (symbol - table.m_TerminalCount)] =
+            static_cast<int16_t>(std::stoi(value));
+        continue;
+      }
+
+      Action action;
+      if (value == "acc") {
+        action = ACCEPT;
+      } else if (value[0] == 's') {
+        action = encode_shift(std::stoi(value.substr(1)));
+      } else if (value[0] == 'r') {
+        action = encode_reduce(std::stoi(value.substr(1)));
+      } else {
+        throw std::runtime_error("Invalid parse table action '" + value +
+                                 "' in state " + row.first);
+      }
+      actions[state * table.m_TerminalCount + symbol] = action;
+    }
+  }
+
+  for (const auto &rule : rules) {
+    table.m_OwnedRuleLhs.push_back(
+        static_cast<uint16_t>(table.symbol_id(rule.first)));
+    table.m_OwnedRuleLength.push_back(
+        static_cast<uint16_t>(rule.second.size()));
+  }
+  table.m_RuleCount = static_cast<int>(rules.size());
+
+  CompressedTable &owned = table.m_OwnedTable;
+  owned = CompressedTable::compress(actions, gotos, table.m_TerminalCount,
+                                    table.m_NonterminalCount,
+                                    table.m_StateCount);
+  table.m_ActionDefault = owned.action_default.data();
+  table.m_ActionBase = owned.action_base.data();
+  table.m_ActionNext = owned.action_next.data();
+  table.m_ActionCheck = owned.action_check.data();
+  table.m_GotoBase = owned.goto_base.data();
+  table.m_GotoNext = owned.goto_next.data();
+  table.m_GotoCheck = owned.goto_check.data();
+  table.m_RuleLhs = table.m_OwnedRuleLhs.data();
+  table.m_RuleLength = table.m_OwnedRuleLength.data();
+
+  return table;
+}
+
+const ParseTable &ParseTable::standard() {
+  static const ParseTable table = [] {
+    namespace data = parse_table_data;
+
+    ParseTable generated;
+    generated.m_TerminalCount = data::TERMINAL_COUNT;
+    generated.m_NonterminalCount = data::NONTERMINAL_COUNT;
+    generated.m_StateCount = data::STATE_COUNT;
+    generated.m_RuleCount = data::RULE_COUNT;
+    generated.m_Symbols = data::SYMBOLS;
+    generated.m_ActionDefault = data::ACTION_DEFAULT;
+    generated.m_ActionBase = data::ACTION_BASE;
+    generated.m_ActionNext = data::ACTION_NEXT;
+    generated.m_ActionCheck = data::ACTION_CHECK;
+    generated.m_GotoBase = data::GOTO_BASE;
+    generated.m_GotoNext = data::GOTO_NEXT;
+    generated.m_GotoCheck = data::GOTO_CHECK;
+    generated.m_RuleLhs = data::RULE_LHS;
+    generated.m_RuleLength = data::RULE_LENGTH;
+    return generated;
+  }();
+  return table;
+}
+
+int ParseTable::symbol_id(std::string_view name) const {
+  int count = this->m_TerminalCount + this->m_NonterminalCount;
+  for (int i = 0; i < count; i++) {
+    if (this->m_Symbols[i] == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+std::string_view ParseTable::symbol_name(int id) const {
+  if (id < 0 || id >= this->m_TerminalCount + this->m_NonterminalCount) {
+    throw std::out_of_range("Invalid grammar symbol id " + std::to_string(id));
+  }
+  return this->m_Symbols[id];
+}
@@ -15,164 +15,213 @@ SyntaxError::SyntaxError(const std::string &msg, std::string filename, const int
   }
 }
 
+SyntaxError::SyntaxError(const std::string &msg, std::string filename, const SourceSpan &span)
+{
+  std::string location = std::to_string(span.line) + ":" + std::to_string(span.column);
+  if (filename.empty())
+  {
+    this->msg = location + ": \033[31mSyntax Error\033[0m: " + msg;
+  }
+  else
+  {
+    this->msg = filename + ":" + location + ": \033[31mSyntax Error\033[0m: " + msg;
+  }
+}
+
 SyntaxError::SyntaxError(const std::string &msg) : msg("\033[31mSyntax Error\033[0m: " + msg) {}
 
 const char *SyntaxError::what() const noexcept { return this->msg.c_str(); }
 
-std::atomic<int> SyntaxTreeNode::syntaxTreeNodeCounter{0};
+Parser::Parser(TokenSource &tokens) : Parser(tokens, ParseTable::standard()) {}
 
-Parser::Parser(TokenStream tokens) : m_Tokens(tokens.getTokens())
+Parser::Parser(TokenSource &tokens, const ParseTable &table) : m_Tokens(&tokens), parseTable(&table)
 {
-  ParserFileHandler parserFileHandler;
-  loadParseTable(parserFileHandler);
-  loadGrammarRules(parserFileHandler);
+  loadTerminals();
 }
 
-Parser::Parser(const Parser &other) : m_Tokens(other.m_Tokens), parseTable(other.parseTable), stateStack(other.stateStack) {}
+Parser::Parser(TokenStream &&tokens) : Parser(std::move(tokens), ParseTable::standard()) {}
+
+Parser::Parser(TokenStream &&tokens, const ParseTable &table) : m_OwnedTokens(std::make_unique<TokenStream>(std::move(tokens))), m_Tokens(m_OwnedTokens.get()), parseTable(&table)
+{
+  loadTerminals();
+}
 
-Parser &Parser::operator=(const Parser &other)
+void Parser::loadTerminals()
 {
-  if (this != &other)
+  // map token classes to terminal ids once, so the parse loop never has to
+  // build or compare symbol names
+  for (int keyword = 0; keyword <= Keyword::Return; keyword++)
   {
-    this->m_Tokens = other.m_Tokens;
-    this->parseTable = other.parseTable;
-    this->stateStack = other.stateStack;
+    this->keywordTerminals[keyword] = this->parseTable->symbol_id(keyword_view(static_cast<enum Keyword>(keyword)));
   }
-  return *this;
+
+  for (int punct = 0; punct < 128; punct++)
+  {
+    this->punctTerminals[punct] = this->parseTable->symbol_id(std::string(1, static_cast<char>(punct)));
+  }
+
+  // nodes always carry standard symbol ids, whatever table built them
+  const ParseTable &standard = ParseTable::standard();
+  int symbolCount = this->parseTable->terminal_count() + this->parseTable->nonterminal_count();
+  this->grammarSymbols.resize(symbolCount);
+  for (int symbol = 0; symbol < symbolCount; symbol++)
+  {
+    this->grammarSymbols[symbol] = static_cast<GrammarSymbol>(standard.symbol_id(this->parseTable->symbol_name(symbol)));
+  }
+
+  this->varnameTerminal = this->parseTable->symbol_id("varname");
+  this->numliteralTerminal = this->parseTable->symbol_id("numliteral");
+  this->textliteralTerminal = this->parseTable->symbol_id("textliteral");
+  this->fnameTerminal = this->parseTable->symbol_id("fname");
+  this->endTerminal = this->parseTable->symbol_id("$");
 }
 
-void Parser::loadParseTable(ParserFileHandler fileHandler)
+int Parser::classifyToken(const Token &token) const
 {
-  this->parseTable = fileHandler.getParseTable();
+  switch (token.type())
+  {
+  case TokenType::Variable:
+    return this->varnameTerminal;
+  case TokenType::NumLiteral:
+    return this->numliteralTerminal;
+  case TokenType::StringLiteral:
+    return token.text() == "$" ? this->endTerminal : this->textliteralTerminal;
+  case TokenType::FunctionName:
+    return this->fnameTerminal;
+  case TokenType::Keyword:
+    return this->keywordTerminals[token.get_keyword()];
+  case TokenType::Punctuation:
+    return this->punctTerminals[token.get_punct() & 0x7f];
+  }
+
+  return -1;
 }
 
-void Parser::loadGrammarRules(ParserFileHandler fileHandler)
+Token Parser::lookahead()
 {
-  this->grammarRules = fileHandler.getGrammarRules();
+  std::optional<Token> token = this->m_Tokens->peek();
+  if (token.has_value())
+  {
+    return token.value();
+  }
+
+  Token endOfInput = Token::string_lit("$");
+  endOfInput.set_span(this->m_EndSpan);
+  return endOfInput;
 }
 
-std::string Parser::getAction(int state, const std::string &token)
+ParseTable::Action Parser::getAction(int state, int terminal) const
 {
-  std::string action = this->parseTable[std::to_string(state)][token];
-  return action;
+  if (terminal < 0)
+  {
+    return ParseTable::ERROR;
+  }
+  return this->parseTable->action(state, terminal);
 }
 
-void Parser::shift(int state, std::string currentTokenSymbol, std::string currentTokenValue, int line)
+void Parser::setFilename(const std::string &filename)
 {
-  this->stateStack.push({state, currentTokenSymbol});
-  this->syntaxTreeStack.push(new SyntaxTreeNode(currentTokenSymbol, currentTokenValue, line));
+  this->filename = filename;
 }
 
-void Parser::reduce(std::pair<std::string, std::vector<std::string>> rule, int line)
+void Parser::setPrintTree(bool printTree)
 {
-  int productionLength = rule.second.size();
+  this->printTree = printTree;
+}
 
-  // create a new node for the LHS of the production
-  SyntaxTreeNode *lhsNode = new SyntaxTreeNode(rule.first, line);
+void Parser::shift(int state, int terminal, const Token &token)
+{
+  // only names and literals carry a value into the syntax tree
+  Interner::Id value = Interner::INVALID;
+  if (token.type() != TokenType::Keyword && token.type() != TokenType::Punctuation)
+  {
+    value = token.lexeme();
+  }
 
-  // if (delayReduce && rule.second.size() > 0 && rule.second[0] == "COMMAND")
-  // {
-  //   delayReduce = false;
-  //   productionLength = 1;
-  // }
-  // else if (rule.second.size() > 0 && ((rule.second[0] == "ASSIGN") || (rule.second[0] == "CALL") || (rule.second[0] == "BRANCH")))
-  // {
-  //   delayReduce = true;
-  // }
+  this->stateStack.push({state, terminal});
+  this->nodeStack.push_back(this->tree->makeLeaf(this->grammarSymbols[terminal], value, token.span()));
+}
 
+void Parser::reduce(const ParseTable::Rule &rule, const SourceSpan &span)
+{
+  int productionLength = rule.length;
   for (int i = 0; i < productionLength; ++i)
   {
     this->stateStack.pop();
-    auto rhsNode = syntaxTreeStack.top(); // get the node for the RHS of the production
-    this->syntaxTreeStack.pop();
-    lhsNode->addChild(rhsNode); // add the RHS node as a child of the LHS node
   }
 
-  this->syntaxTreeStack.push(lhsNode); // push the LHS node onto the stack
+  // the RHS nodes are the top of the node stack, already in order
+  SyntaxTreeNode *const *children = this->nodeStack.data() + this->nodeStack.size() - productionLength;
+
+  // a non-empty production starts where its first symbol starts
+  SourceSpan lhsSpan = productionLength > 0 ? children[0]->span : span;
+  SyntaxTreeNode *lhsNode = this->tree->makeNode(this->grammarSymbols[rule.lhs], children, productionLength, lhsSpan);
+
+  this->nodeStack.resize(this->nodeStack.size() - productionLength);
+  this->nodeStack.push_back(lhsNode);
 
   int currentState = this->stateStack.top().state;
-  std::string nonTerminal = rule.first;
 
   // get the GOTO action after reduction
-  std::string gotoAction = this->getAction(currentState, nonTerminal);
-  if (gotoAction.empty())
+  int gotoState = this->parseTable->go_to(currentState, rule.lhs);
+  if (gotoState < 0)
   {
     return;
   }
 
-  int gotoState = std::stoi(gotoAction);
-  this->stateStack.push({gotoState, nonTerminal});
+  this->stateStack.push({gotoState, rule.lhs});
 }
 
-SyntaxTreeNode *Parser::parse()
+std::unique_ptr<SyntaxTree> Parser::parse()
 {
-  this->stateStack.push({0, ""});
+  this->stateStack.push({0, -1});
+  this->tree = std::make_unique<SyntaxTree>();
+  this->nodeStack.clear();
 
   try
   {
-    this->m_Tokens.push_back(Token::string_lit("$")); // add end of input token
-
-    while (!m_Tokens.empty())
+    while (true)
     {
       int currentState = this->stateStack.top().state;
-      TokenType currentTokenType = this->m_Tokens.front().type();
-      std::string currentTokenSymbol = "";
-      std::string currentTokenValue = "";
-      if (currentTokenType == TokenType::Variable)
-      {
-        currentTokenSymbol = "varname";
-        currentTokenValue = this->m_Tokens.front().get_str_data();
-      }
-      else if (currentTokenType == TokenType::NumLiteral)
-      {
-        currentTokenSymbol = "numliteral";
-        currentTokenValue = this->m_Tokens.front().get_str_data();
-      }
-      else if (currentTokenType == TokenType::StringLiteral && this->m_Tokens.front().get_str_data() != "$")
-      {
-        currentTokenSymbol = "textliteral";
-        currentTokenValue = this->m_Tokens.front().get_str_data();
-      }
-      else if (currentTokenType == TokenType::FunctionName)
-      {
-        currentTokenSymbol = "fname";
-        currentTokenValue = this->m_Tokens.front().get_str_data();
-      }
-      else
-      {
-        currentTokenSymbol = this->m_Tokens.front().get_str_data();
-      }
+      const Token currentToken = this->lookahead();
+      int terminal = this->classifyToken(currentToken);
 
-      std::string action = this->getAction(currentState, currentTokenSymbol);
+      ParseTable::Action action = this->getAction(currentState, terminal);
 
       // print state stack
-      // this->printStateStack(action);
+      // this->printStateStack(std::to_string(action));
 
-      if (action[0] == 's')
+      if (ParseTable::is_shift(action))
       {
-        int nextState = std::stoi(action.substr(1));
-        shift(nextState, currentTokenSymbol, currentTokenValue, this->m_Tokens.front().get_line_number());
-
-        m_Tokens.erase(m_Tokens.begin());
+        shift(ParseTable::shift_state(action), terminal, currentToken);
+        this->m_Tokens->next();
+
+        // end of input is located just past the last real token
+        this->m_EndSpan = currentToken.span();
+        this->m_EndSpan.column += this->m_EndSpan.length;
+        this->m_EndSpan.offset += this->m_EndSpan.length;
+        this->m_EndSpan.length = 0;
       }
-      else if (action[0] == 'r')
+      else if (ParseTable::is_reduce(action))
       {
-        int ruleNum = std::stoi(action.substr(1));
-        auto rule = grammarRules[ruleNum];
-
-        reduce(rule, this->m_Tokens.front().get_line_number());
+        reduce(this->parseTable->rule(ParseTable::reduce_rule(action)), currentToken.span());
       }
-      else if (action == "acc")
+      else if (action == ParseTable::ACCEPT)
       {
-        std::cout << "\nInput successfully parsed, syntax tree is shown below\n"
-                  << std::endl;
-        auto syntaxTreeRoot = this->syntaxTreeStack.top();
-        syntaxTreeRoot->printTree(); // print the final syntax tree
-        return syntaxTreeRoot;
+        this->tree->setRoot(this->nodeStack.back());
+        if (this->printTree)
+        {
+          std::cout << "\nInput successfully parsed, syntax tree is shown below\n"
+                    << std::endl;
+          this->tree->getRoot()->printTree(); // print the final syntax tree
+        }
+        this->nodeStack.clear();
+        return std::move(this->tree);
       }
       else
       {
-        throw SyntaxError("Unexpected token symbol " + currentTokenSymbol + " in state " + std::to_string(currentState) + " Action: " + action);
+        std::string symbol = terminal < 0 ? currentToken.get_str_data() : std::string(this->parseTable->symbol_name(terminal));
+        throw SyntaxError("Unexpected token symbol " + symbol + " in state " + std::to_string(currentState), this->filename, currentToken.span());
       }
     }
   }
@@ -191,6 +240,8 @@ SyntaxTreeNode *Parser::parse()
     std::cerr << "Unknown exception caught during parsing" << std::endl;
   }
 
+  this->nodeStack.clear();
+  this->tree.reset();
   return nullptr;
 }
 
@@ -201,7 +252,8 @@ void Parser::printStateStack(std::string action = "")
   while (!tempStack.empty())
   {
     std::stringstream ss;
-    ss << "(" << tempStack.top().state << ", " << tempStack.top().symbol << ") ";
+    int symbol = tempStack.top().symbol;
+    ss << "(" << tempStack.top().state << ", " << (symbol < 0 ? "" : this->parseTable->symbol_name(symbol)) << ") ";
     stackVector.push_back(ss.str());
     tempStack.pop();
   }
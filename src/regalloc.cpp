@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cfg.h>
+#include <functional>
+#include <regalloc.h>
+
+namespace {
+struct Interval {
+  uint32_t temp;
+  uint32_t start;
+  uint32_t end;
+};
+
+bool is_temp(OperandId operand) {
+  return operand != IMCOperand::NONE &&
+         IMCOperand::kind(operand) == IMCOperand::Kind::Temp;
+}
+} // namespace
+
+RegisterAllocation allocate_registers(const IMCFunction &function,
+                                      uint32_t registers) {
+  std::size_t temps = function.temps.size();
+  CFG cfg(function);
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+
+  // positions number the instructions in code order; each block records
+  // which temporaries it reads before writing them, and which it writes
+  std::vector<uint32_t> first(blocks.size());
+  std::vector<std::vector<bool>> uses(blocks.size(),
+                                      std::vector<bool>(temps, false));
+  std::vector<std::vector<bool>> defs = uses;
+  std::vector<Interval> intervals(temps, Interval{0, UINT32_MAX, 0});
+  auto touch = [&](OperandId operand, uint32_t position) {
+    Interval &interval = intervals[IMCOperand::index(operand)];
+    interval.start = std::min(interval.start, position);
+    interval.end = std::max(interval.end, position);
+  };
+
+  uint32_t position = 0;
+  for (std::size_t b = 0; b < blocks.size(); b++) {
+    first[b] = position;
+    for (const IMCInstruction &instruction : blocks[b].code) {
+      int sources = source_count(instruction.opcode);
+      for (OperandId source : {instruction.src1, instruction.src2}) {
+        if (sources-- > 0 && is_temp(source)) {
+          touch(source, position);
+          if (!defs[b][IMCOperand::index(source)]) {
+            uses[b][IMCOperand::index(source)] = true;
+          }
+        }
+      }
+      if (writes_dst(instruction.opcode) && is_temp(instruction.dst)) {
+        touch(instruction.dst, position);
+        defs[b][IMCOperand::index(instruction.dst)] = true;
+      }
+      position++;
+    }
+  }
+
+  // live-in = uses + (live-out - defs), to a fixed point
+  std::vector<std::vector<bool>> live_in = uses;
+  std::vector<std::vector<bool>> live_out(blocks.size(),
+                                          std::vector<bool>(temps, false));
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (std::size_t b = blocks.size(); b-- > 0;) {
+      for (uint32_t successor : blocks[b].successors) {
+        for (std::size_t t = 0; t < temps; t++) {
+          if (live_in[successor][t] && !live_out[b][t]) {
+            live_out[b][t] = true;
+            if (!defs[b][t] && !live_in[b][t]) {
+              live_in[b][t] = true;
+            }
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // a temporary live into or out of a block covers its first or last
+  // instruction
+  for (std::size_t b = 0; b < blocks.size(); b++) {
+    uint32_t last = first[b] + static_cast<uint32_t>(blocks[b].code.size());
+    for (std::size_t t = 0; t < temps; t++) {
+      if (live_in[b][t]) {
+        touch(IMCOperand::temp(static_cast<uint32_t>(t)), first[b]);
+      }
+      if (live_out[b][t] && last > first[b]) {
+        touch(IMCOperand::temp(static_cast<uint32_t>(t)), last - 1);
+      }
+    }
+  }
+
+  RegisterAllocation allocation;
+  allocation.registers.assign(temps, RegisterAllocation::SPILLED);
+  allocation.slots.assign(temps, 0);
+  std::vector<Interval> order;
+  for (uint32_t t = 0; t < temps; t++) {
+    intervals[t].temp = t;
+    if (intervals[t].start != UINT32_MAX) {
+      order.push_back(intervals[t]);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Interval &a, const Interval &b) {
+                     return a.start < b.start;
+                   });
+
+  // an interval may take the register of one that ends where it starts,
+  // since an instruction reads its sources before it writes
+  std::vector<Interval> active;    // by increasing end
+  std::vector<uint32_t> available; // lowest register last
+  auto spill = [&](uint32_t temp) {
+    allocation.registers[temp] = RegisterAllocation::SPILLED;
+    allocation.slots[temp] = allocation.spilled++;
+  };
+  for (const Interval &interval : order) {
+    while (!active.empty() && active.front().end <= interval.start) {
+      available.push_back(allocation.registers[active.front().temp]);
+      active.erase(active.begin());
+    }
+    std::sort(available.begin(), available.end(), std::greater<uint32_t>());
+
+    uint32_t reg;
+    if (!available.empty()) {
+      reg = available.back();
+      available.pop_back();
+    } else if (allocation.used < registers) {
+      reg = allocation.used++;
+    } else {
+      // the active interval ending last gives up its register if it
+      // outlives this one
+      if (active.empty() || active.back().end <= interval.end) {
+        spill(interval.temp);
+        continue;
+      }
+      reg = allocation.registers[active.back().temp];
+      spill(active.back().temp);
+      active.pop_back();
+    }
+
+    allocation.registers[interval.temp] = reg;
+    auto at = std::upper_bound(active.begin(), active.end(), interval,
+                               [](const Interval &a, const Interval &b) {
+                                 return a.end < b.end;
+                               });
+    active.insert(at, interval);
+  }
+  return allocation;
+}
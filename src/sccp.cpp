@@ -0,0 +1,414 @@
+#include <cmath>
+#include <sccp.h>
+
+namespace {
+// Lattice values of temporaries, besides the constant operands themselves:
+// TOP is a value not seen yet, BOTTOM one not known until run time
+constexpr OperandId TOP = IMCOperand::NONE;
+constexpr OperandId BOTTOM = IMCOperand::NONE - 1;
+
+bool is_constant(OperandId value) {
+  return value != TOP && value != BOTTOM &&
+         IMCOperand::kind(value) == IMCOperand::Kind::Constant;
+}
+
+OperandId meet(OperandId a, OperandId b) {
+  if (a == TOP) {
+    return b;
+  }
+  if (b == TOP || a == b) {
+    return a;
+  }
+  return BOTTOM;
+}
+
+// a phi or an instruction reading a temporary
+struct Use {
+  uint32_t block;
+  uint32_t index;
+  bool phi;
+};
+
+class Solver {
+public:
+  Solver(IMCProgram &program, CFG &cfg, IMCFunction &function);
+
+  // runs the flow and SSA worklists to a fixed point
+  void solve();
+  SCCPReport rewrite();
+
+private:
+  OperandId value(OperandId operand) const;
+  OperandId number(double value);
+  OperandId evaluate(IMCOpcode opcode, OperandId a, OperandId b);
+  void lower(OperandId dst, OperandId value);
+  void mark(uint32_t block, std::size_t slot);
+  bool executable(uint32_t from, uint32_t to) const;
+  void visit_phi(uint32_t block, const Phi &phi);
+  void visit(uint32_t block, const IMCInstruction &instruction);
+  void enter(uint32_t block);
+
+  IMCProgram &m_Program;
+  CFG &m_CFG;
+  std::vector<OperandId> m_Values;             // per temporary
+  std::vector<std::vector<Use>> m_Uses;        // per temporary
+  std::vector<std::vector<bool>> m_Executable; // per successor slot
+  std::vector<bool> m_Entered;                 // per block
+  std::vector<std::pair<uint32_t, std::size_t>> m_Edges;
+  std::vector<uint32_t> m_Changed;
+};
+
+Solver::Solver(IMCProgram &program, CFG &cfg, IMCFunction &function)
+    : m_Program(program), m_CFG(cfg), m_Values(function.temps.size(), BOTTOM),
+      m_Uses(function.temps.size()), m_Entered(cfg.blocks().size(), false) {
+  // a temporary starts at TOP only if it is assigned here; the rest hold
+  // their value on entry
+  auto use = [&](OperandId operand, Use site) {
+    if (operand != IMCOperand::NONE &&
+        IMCOperand::kind(operand) == IMCOperand::Kind::Temp) {
+      this->m_Uses[IMCOperand::index(operand)].push_back(site);
+    }
+  };
+  auto define = [&](OperandId operand) {
+    if (operand != IMCOperand::NONE &&
+        IMCOperand::kind(operand) == IMCOperand::Kind::Temp) {
+      this->m_Values[IMCOperand::index(operand)] = TOP;
+    }
+  };
+
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+  for (uint32_t block = 0; block < blocks.size(); block++) {
+    this->m_Executable.emplace_back(blocks[block].successors.size(), false);
+    for (uint32_t i = 0; i < blocks[block].phis.size(); i++) {
+      const Phi &phi = blocks[block].phis[i];
+      define(phi.dst);
+      for (OperandId arg : phi.args) {
+        use(arg, Use{block, i, true});
+      }
+    }
+    for (uint32_t i = 0; i < blocks[block].code.size(); i++) {
+      const IMCInstruction &instruction = blocks[block].code[i];
+      if (writes_dst(instruction.opcode)) {
+        define(instruction.dst);
+      }
+      int sources = source_count(instruction.opcode);
+      if (sources > 0) {
+        use(instruction.src1, Use{block, i, false});
+      }
+      if (sources > 1) {
+        use(instruction.src2, Use{block, i, false});
+      }
+    }
+  }
+}
+
+OperandId Solver::value(OperandId operand) const {
+  switch (IMCOperand::kind(operand)) {
+  case IMCOperand::Kind::Constant:
+    return operand;
+  case IMCOperand::Kind::Temp:
+    return this->m_Values[IMCOperand::index(operand)];
+  default:
+    return BOTTOM;
+  }
+}
+
+OperandId Solver::number(double value) {
+  return IMCOperand::constant(this->m_Program.constants.intern_number(value));
+}
+
+OperandId Solver::evaluate(IMCOpcode opcode, OperandId a, OperandId b) {
+  const IMCConstantPool &pool = this->m_Program.constants;
+  auto is_false = [&](OperandId value) {
+    return is_constant(value) &&
+           pool.get(IMCOperand::index(value)).type == TypeId::Num &&
+           pool.get(IMCOperand::index(value)).number == 0;
+  };
+  auto is_true = [&](OperandId value) {
+    return is_constant(value) &&
+           pool.get(IMCOperand::index(value)).type == TypeId::Num &&
+           pool.get(IMCOperand::index(value)).number != 0;
+  };
+
+  // one false operand decides `and`, one true operand `or`, whatever the
+  // other turns out to be
+  if (opcode == IMCOpcode::And && (is_false(a) || is_false(b))) {
+    return this->number(0);
+  }
+  if (opcode == IMCOpcode::Or && (is_true(a) || is_true(b))) {
+    return this->number(1);
+  }
+
+  bool unary = opcode == IMCOpcode::Sqrt || opcode == IMCOpcode::Not;
+  if (a == BOTTOM || (!unary && b == BOTTOM)) {
+    return BOTTOM;
+  }
+  if (a == TOP || (!unary && b == TOP)) {
+    return TOP;
+  }
+
+  const IMCConstantPool::Constant &left = pool.get(IMCOperand::index(a));
+  const IMCConstantPool::Constant &right =
+      unary ? left : pool.get(IMCOperand::index(b));
+  if (opcode == IMCOpcode::Eq && left.type == right.type) {
+    return this->number(left.type == TypeId::Num ? left.number == right.number
+                                                 : left.text == right.text);
+  }
+  if (left.type != TypeId::Num || right.type != TypeId::Num) {
+    return BOTTOM;
+  }
+
+  double x = left.number;
+  double y = right.number;
+  switch (opcode) {
+  case IMCOpcode::Add:
+    return this->number(x + y);
+  case IMCOpcode::Sub:
+    return this->number(x - y);
+  case IMCOpcode::Mul:
+    return this->number(x * y);
+  case IMCOpcode::Div:
+    return y == 0 ? BOTTOM : this->number(x / y);
+  case IMCOpcode::And:
+    return this->number(x != 0 && y != 0);
+  case IMCOpcode::Or:
+    return this->number(x != 0 || y != 0);
+  case IMCOpcode::Grt:
+    return this->number(x > y);
+  case IMCOpcode::Sqrt:
+    return x < 0 ? BOTTOM : this->number(std::sqrt(x));
+  case IMCOpcode::Not:
+    return this->number(x == 0);
+  default:
+    return BOTTOM;
+  }
+}
+
+void Solver::lower(OperandId dst, OperandId value) {
+  if (IMCOperand::kind(dst) != IMCOperand::Kind::Temp) {
+    return;
+  }
+  OperandId &current = this->m_Values[IMCOperand::index(dst)];
+  OperandId lowered = meet(current, value);
+  if (lowered != current) {
+    current = lowered;
+    this->m_Changed.push_back(IMCOperand::index(dst));
+  }
+}
+
+void Solver::mark(uint32_t block, std::size_t slot) {
+  if (!this->m_Executable[block][slot]) {
+    this->m_Executable[block][slot] = true;
+    this->m_Edges.emplace_back(block, slot);
+  }
+}
+
+bool Solver::executable(uint32_t from, uint32_t to) const {
+  const std::vector<uint32_t> &successors = this->m_CFG.blocks()[from].successors;
+  for (std::size_t slot = 0; slot < successors.size(); slot++) {
+    if (successors[slot] == to && this->m_Executable[from][slot]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Solver::visit_phi(uint32_t block, const Phi &phi) {
+  const std::vector<uint32_t> &predecessors =
+      this->m_CFG.blocks()[block].predecessors;
+  OperandId merged = TOP;
+  for (std::size_t j = 0; j < predecessors.size(); j++) {
+    if (this->executable(predecessors[j], block)) {
+      merged = meet(merged, this->value(phi.args[j]));
+    }
+  }
+  this->lower(phi.dst, merged);
+}
+
+void Solver::visit(uint32_t block, const IMCInstruction &instruction) {
+  switch (instruction.opcode) {
+  case IMCOpcode::Copy:
+    return this->lower(instruction.dst, this->value(instruction.src1));
+  case IMCOpcode::Input:
+  case IMCOpcode::Call:
+    if (instruction.dst != IMCOperand::NONE) {
+      this->lower(instruction.dst, BOTTOM);
+    }
+    return;
+  case IMCOpcode::Jump:
+    return this->mark(block, 0);
+  case IMCOpcode::JumpIfEq:
+  case IMCOpcode::JumpIfGrt: {
+    OperandId taken = this->evaluate(instruction.opcode == IMCOpcode::JumpIfEq
+                                         ? IMCOpcode::Eq
+                                         : IMCOpcode::Grt,
+                                     this->value(instruction.src1),
+                                     this->value(instruction.src2));
+    if (taken == TOP) {
+      return;
+    }
+    bool jumps = taken != BOTTOM &&
+                 this->m_Program.constants.get(IMCOperand::index(taken))
+                         .number != 0;
+    if (taken == BOTTOM || jumps) {
+      this->mark(block, 0);
+    }
+    if (taken == BOTTOM || !jumps) {
+      this->mark(block, 1);
+    }
+    return;
+  }
+  default:
+    if (writes_dst(instruction.opcode)) {
+      this->lower(instruction.dst,
+                  this->evaluate(instruction.opcode,
+                                 this->value(instruction.src1),
+                                 this->value(instruction.src2)));
+    }
+  }
+}
+
+void Solver::enter(uint32_t block) {
+  this->m_Entered[block] = true;
+  const BasicBlock &current = this->m_CFG.blocks()[block];
+  for (const IMCInstruction &instruction : current.code) {
+    this->visit(block, instruction);
+  }
+  IMCOpcode last =
+      current.code.empty() ? IMCOpcode::Label : current.code.back().opcode;
+  if (!is_jump(last) && !is_terminator(last) && !current.successors.empty()) {
+    this->mark(block, 0);
+  }
+}
+
+void Solver::solve() {
+  const std::vector<BasicBlock> &blocks = this->m_CFG.blocks();
+  this->enter(0);
+  while (!this->m_Edges.empty() || !this->m_Changed.empty()) {
+    if (!this->m_Edges.empty()) {
+      auto [from, slot] = this->m_Edges.back();
+      this->m_Edges.pop_back();
+      uint32_t to = blocks[from].successors[slot];
+      for (const Phi &phi : blocks[to].phis) {
+        this->visit_phi(to, phi);
+      }
+      if (!this->m_Entered[to]) {
+        this->enter(to);
+      }
+      continue;
+    }
+
+    uint32_t temp = this->m_Changed.back();
+    this->m_Changed.pop_back();
+    for (const Use &use : this->m_Uses[temp]) {
+      if (!this->m_Entered[use.block]) {
+        continue;
+      }
+      if (use.phi) {
+        this->visit_phi(use.block, blocks[use.block].phis[use.index]);
+      } else {
+        this->visit(use.block, blocks[use.block].code[use.index]);
+      }
+    }
+  }
+}
+
+SCCPReport Solver::rewrite() {
+  SCCPReport report;
+  std::vector<BasicBlock> &blocks = this->m_CFG.blocks();
+
+  // a branch that only went one way becomes a jump, or falls through
+  for (uint32_t block = 0; block < blocks.size(); block++) {
+    std::vector<IMCInstruction> &code = blocks[block].code;
+    if (!this->m_Entered[block] || code.empty() ||
+        code.back().opcode == IMCOpcode::Jump || !is_jump(code.back().opcode)) {
+      continue;
+    }
+    const std::vector<bool> &taken = this->m_Executable[block];
+    if (taken[0] == taken[1]) {
+      continue;
+    }
+    if (taken[0]) {
+      code.back() = IMCInstruction{IMCOpcode::Jump, code.back().dst};
+      this->m_CFG.remove_edge(block, 1);
+    } else {
+      code.pop_back();
+      this->m_CFG.remove_edge(block, 0);
+    }
+    report.branches++;
+  }
+
+  std::size_t count = blocks.size();
+  report.instructions = this->m_CFG.remove_unreachable();
+  report.blocks = count - blocks.size();
+
+  // constants replace the temporaries that held them
+  auto substitute = [&](OperandId &operand) {
+    if (IMCOperand::kind(operand) == IMCOperand::Kind::Temp &&
+        is_constant(this->value(operand))) {
+      operand = this->value(operand);
+    }
+  };
+  auto folded = [&](OperandId dst) {
+    return dst != IMCOperand::NONE &&
+           IMCOperand::kind(dst) == IMCOperand::Kind::Temp &&
+           is_constant(this->value(dst));
+  };
+  for (BasicBlock &block : blocks) {
+    std::vector<Phi> phis;
+    for (Phi &phi : block.phis) {
+      if (folded(phi.dst)) {
+        report.folded++;
+        continue;
+      }
+      for (OperandId &arg : phi.args) {
+        substitute(arg);
+      }
+      phis.push_back(std::move(phi));
+    }
+    block.phis = std::move(phis);
+
+    std::vector<IMCInstruction> code;
+    for (IMCInstruction &instruction : block.code) {
+      if (writes_dst(instruction.opcode) && folded(instruction.dst)) {
+        report.folded++;
+        continue;
+      }
+      int sources = source_count(instruction.opcode);
+      if (sources > 0 && instruction.src1 != IMCOperand::NONE) {
+        substitute(instruction.src1);
+      }
+      if (sources > 1) {
+        substitute(instruction.src2);
+      }
+      code.push_back(instruction);
+    }
+    block.code = std::move(code);
+  }
+
+  this->m_CFG.compute_dominators();
+  return report;
+}
+} // namespace
+
+SCCPReport &SCCPReport::operator+=(const SCCPReport &other) {
+  this->folded += other.folded;
+  this->branches += other.branches;
+  this->blocks += other.blocks;
+  this->instructions += other.instructions;
+  return *this;
+}
+
+void SCCPReport::print(std::ostream &out) const {
+  out << "constant propagation: folded " << this->folded
+      << " assignments, decided " << this->branches << " branches, removed "
+      << this->blocks << " unreachable blocks (" << this->instructions
+      << " instructions)" << std::endl;
+}
+
+SCCPReport propagate_constants(IMCProgram &program, CFG &cfg,
+                               std::size_t function) {
+  Solver solver(program, cfg, program.functions[function]);
+  solver.solve();
+  return solver.rewrite();
+}
@@ -0,0 +1,108 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <source_buffer.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept {
+  *this = std::move(other);
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    this->m_Mapped = other.m_Mapped;
+    this->m_Size = other.m_Size;
+    this->m_Owned = std::move(other.m_Owned);
+    this->m_Data = this->m_Mapped ? other.m_Data : this->m_Owned.data();
+
+    other.m_Data = nullptr;
+    other.m_Size = 0;
+    other.m_Mapped = false;
+  }
+  return *this;
+}
+
+SourceBuffer::~SourceBuffer() { this->release(); }
+
+void SourceBuffer::release() {
+  if (this->m_Mapped) {
+    munmap(const_cast<char *>(this->m_Data), this->m_Size);
+  }
+  this->m_Data = nullptr;
+  this->m_Size = 0;
+  this->m_Mapped = false;
+  this->m_Owned.clear();
+}
+
+SourceBuffer SourceBuffer::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + path + ": " +
+                             std::strerror(errno));
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    int error = errno;
+    close(fd);
+    throw std::runtime_error("Failed to stat " + path + ": " +
+                             std::strerror(error));
+  }
+
+  SourceBuffer buffer;
+  if (S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                         PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      madvise(mapping, static_cast<std::size_t>(info.st_size),
+              MADV_SEQUENTIAL);
+      close(fd);
+      buffer.m_Data = static_cast<const char *>(mapping);
+      buffer.m_Size = static_cast<std::size_t>(info.st_size);
+      buffer.m_Mapped = true;
+      return buffer;
+    }
+  }
+
+  // empty files, FIFOs and anything else mmap refuses are read instead
+  std::string contents;
+  char chunk[64 * 1024];
+  ssize_t count;
+  while ((count = ::read(fd, chunk, sizeof(chunk))) != 0) {
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int error = errno;
+      close(fd);
+      throw std::runtime_error("Failed to read " + path + ": " +
+                               std::strerror(error));
+    }
+    contents.append(chunk, static_cast<std::size_t>(count));
+  }
+  close(fd);
+
+  buffer.m_Owned = std::move(contents);
+  buffer.m_Data = buffer.m_Owned.data();
+  buffer.m_Size = buffer.m_Owned.size();
+  return buffer;
+}
+
+SourceBuffer SourceBuffer::read(std::istream &stream) {
+  std::ostringstream contents;
+  contents << stream.rdbuf();
+  if (stream.bad()) {
+    throw std::runtime_error("Failed to read input");
+  }
+
+  SourceBuffer buffer;
+  buffer.m_Owned = contents.str();
+  buffer.m_Data = buffer.m_Owned.data();
+  buffer.m_Size = buffer.m_Owned.size();
+  return buffer;
+}
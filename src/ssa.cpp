@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <ssa.h>
+
+namespace {
+struct Copy {
+  OperandId dst;
+  OperandId src;
+};
+
+// Orders the copies of a phi's incoming edge, which all happen at once,
+// into a sequence: a copy waits until nothing else still reads its
+// destination, and a cycle is broken by saving one destination in a
+// fresh temporary.
+std::vector<IMCInstruction> sequentialize(std::vector<Copy> copies,
+                                          const IMCProgram &program,
+                                          IMCFunction &function) {
+  copies.erase(std::remove_if(copies.begin(), copies.end(),
+                              [](const Copy &copy) {
+                                return copy.dst == copy.src;
+                              }),
+               copies.end());
+
+  std::vector<IMCInstruction> code;
+  while (!copies.empty()) {
+    auto ready = std::find_if(copies.begin(), copies.end(), [&](const Copy &c) {
+      return std::none_of(copies.begin(), copies.end(), [&](const Copy &other) {
+        return other.src == c.dst;
+      });
+    });
+
+    if (ready == copies.end()) {
+      OperandId dst = copies.front().dst;
+      OperandId saved = function.new_temp(program.type_of(function, dst));
+      code.push_back(IMCInstruction{IMCOpcode::Copy, saved, dst});
+      for (Copy &copy : copies) {
+        if (copy.src == dst) {
+          copy.src = saved;
+        }
+      }
+      continue;
+    }
+
+    code.push_back(IMCInstruction{IMCOpcode::Copy, ready->dst, ready->src});
+    copies.erase(ready);
+  }
+  return code;
+}
+} // namespace
+
+SSABuilder::SSABuilder(IMCProgram &program)
+    : m_Program(program), m_Owners(program.owners()) {}
+
+bool SSABuilder::renamable(std::size_t function, OperandId operand) const {
+  switch (IMCOperand::kind(operand)) {
+  case IMCOperand::Kind::Temp:
+    return true;
+  case IMCOperand::Kind::Variable:
+    return this->m_Owners[IMCOperand::index(operand)] == function;
+  default:
+    return false;
+  }
+}
+
+void SSABuilder::construct(CFG &cfg, std::size_t index) {
+  IMCFunction &function = this->m_Program.functions[index];
+  std::vector<BasicBlock> &blocks = cfg.blocks();
+
+  // renamed operands are numbered densely: variables first, then the
+  // temporaries that existed before renaming started
+  std::size_t variables = this->m_Program.variables.size();
+  std::size_t slots = variables + function.temps.size();
+  auto slot = [&](OperandId operand) -> std::size_t {
+    if (operand == IMCOperand::NONE || !this->renamable(index, operand)) {
+      return slots;
+    }
+    std::size_t offset = IMCOperand::kind(operand) == IMCOperand::Kind::Temp
+                             ? variables
+                             : 0;
+    std::size_t number = offset + IMCOperand::index(operand);
+    return number < slots ? number : slots;
+  };
+  auto operand_of = [&](std::size_t number) {
+    return number < variables
+               ? IMCOperand::variable(static_cast<uint32_t>(number))
+               : IMCOperand::temp(static_cast<uint32_t>(number - variables));
+  };
+
+  // blocks defining each operand
+  std::vector<std::vector<uint32_t>> definitions(slots);
+  for (uint32_t block : cfg.reverse_postorder()) {
+    for (const IMCInstruction &instruction : blocks[block].code) {
+      if (!writes_dst(instruction.opcode)) {
+        continue;
+      }
+      std::size_t number = slot(instruction.dst);
+      if (number < slots && (definitions[number].empty() ||
+                             definitions[number].back() != block)) {
+        definitions[number].push_back(block);
+      }
+    }
+  }
+
+  // a phi goes wherever two definitions may meet, which is itself a new
+  // definition
+  std::vector<std::vector<uint32_t>> frontiers = cfg.dominance_frontiers();
+  std::vector<std::size_t> has_phi(blocks.size(), slots);
+  std::vector<std::size_t> queued(blocks.size(), slots);
+  for (std::size_t number = 0; number < slots; number++) {
+    std::vector<uint32_t> work = definitions[number];
+    for (uint32_t block : work) {
+      queued[block] = number;
+    }
+    while (!work.empty()) {
+      uint32_t block = work.back();
+      work.pop_back();
+      for (uint32_t join : frontiers[block]) {
+        if (has_phi[join] == number) {
+          continue;
+        }
+        has_phi[join] = number;
+        OperandId variable = operand_of(number);
+        blocks[join].phis.push_back(Phi{
+            IMCOperand::NONE, variable,
+            std::vector<OperandId>(blocks[join].predecessors.size(),
+                                   variable)});
+        if (queued[join] != number) {
+          queued[join] = number;
+          work.push_back(join);
+        }
+      }
+    }
+  }
+
+  // rename along the dominator tree with an explicit stack; each block
+  // logs which operands it pushed a version for, to pop them on the way
+  // back up
+  std::vector<std::vector<OperandId>> versions(slots);
+  auto current = [&](OperandId operand) {
+    std::size_t number = slot(operand);
+    return number == slots || versions[number].empty()
+               ? operand
+               : versions[number].back();
+  };
+
+  std::vector<std::vector<uint32_t>> children = cfg.dominator_tree();
+  std::vector<std::vector<std::size_t>> pushed(blocks.size());
+  std::vector<std::pair<uint32_t, bool>> stack = {{0, false}};
+  while (!stack.empty()) {
+    auto [block, done] = stack.back();
+    stack.pop_back();
+    if (done) {
+      for (std::size_t number : pushed[block]) {
+        versions[number].pop_back();
+      }
+      continue;
+    }
+
+    auto define = [&](OperandId operand) {
+      std::size_t number = slot(operand);
+      if (number == slots) {
+        return operand;
+      }
+      OperandId version = function.new_temp(
+          this->m_Program.type_of(function, operand_of(number)));
+      versions[number].push_back(version);
+      pushed[block].push_back(number);
+      return version;
+    };
+
+    BasicBlock &current_block = blocks[block];
+    for (Phi &phi : current_block.phis) {
+      phi.dst = define(phi.variable);
+    }
+    for (IMCInstruction &instruction : current_block.code) {
+      int sources = source_count(instruction.opcode);
+      if (sources > 0 && instruction.src1 != IMCOperand::NONE) {
+        instruction.src1 = current(instruction.src1);
+      }
+      if (sources > 1) {
+        instruction.src2 = current(instruction.src2);
+      }
+      if (writes_dst(instruction.opcode) &&
+          instruction.dst != IMCOperand::NONE) {
+        instruction.dst = define(instruction.dst);
+      }
+    }
+    for (uint32_t successor : current_block.successors) {
+      BasicBlock &next = blocks[successor];
+      for (std::size_t j = 0; j < next.predecessors.size(); j++) {
+        if (next.predecessors[j] != block) {
+          continue;
+        }
+        for (Phi &phi : next.phis) {
+          phi.args[j] = current(phi.variable);
+        }
+      }
+    }
+
+    stack.emplace_back(block, true);
+    for (uint32_t child : children[block]) {
+      stack.emplace_back(child, false);
+    }
+  }
+}
+
+void SSABuilder::destruct(CFG &cfg, std::size_t index) {
+  IMCFunction &function = this->m_Program.functions[index];
+  std::vector<BasicBlock> &blocks = cfg.blocks();
+
+  std::size_t count = blocks.size();
+  for (uint32_t block = 0; block < count; block++) {
+    if (blocks[block].phis.empty()) {
+      continue;
+    }
+
+    std::vector<uint32_t> predecessors = blocks[block].predecessors;
+    for (std::size_t j = 0; j < predecessors.size(); j++) {
+      uint32_t predecessor = predecessors[j];
+      if (!cfg.reachable(predecessor)) {
+        continue;
+      }
+
+      std::vector<Copy> copies;
+      for (const Phi &phi : blocks[block].phis) {
+        copies.push_back(Copy{phi.dst, phi.args[j]});
+      }
+      std::vector<IMCInstruction> code =
+          sequentialize(std::move(copies), this->m_Program, function);
+
+      // a predecessor that can also go elsewhere gets the copies on a
+      // block of their own
+      if (blocks[predecessor].successors.size() > 1) {
+        predecessor = cfg.split_edge(function, predecessor, block);
+      }
+      std::vector<IMCInstruction> &target = blocks[predecessor].code;
+      auto at = !target.empty() && is_jump(target.back().opcode)
+                    ? target.end() - 1
+                    : target.end();
+      target.insert(at, code.begin(), code.end());
+    }
+    blocks[block].phis.clear();
+  }
+}
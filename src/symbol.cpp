@@ -1,85 +1,187 @@
 #include <stdexcept>
 #include <symbol.h>
 
-Symbol::Symbol(const std::string &identifier, std::string type)
-    : m_Ident(identifier), m_Type(type), returnType("void") {}
+std::string_view typeName(TypeId type)
+{
+  switch (type)
+  {
+  case TypeId::Num:
+    return "num";
+  case TypeId::Text:
+    return "text";
+  case TypeId::Void:
+    return "void";
+  case TypeId::Function:
+    return "function";
+  case TypeId::Error:
+    return "error";
+  }
+  return "unknown";
+}
+
+Symbol::Symbol(SymbolId identifier, TypeId type)
+    : m_Ident(identifier), m_Place(identifier), m_Type(type), returnType(TypeId::Void) {}
 
-std::string Symbol::type() const { return this->m_Type; }
-const std::string &Symbol::name() const { return this->m_Ident; }
+Symbol::Symbol(std::string_view identifier, TypeId type)
+    : Symbol(Interner::global().intern(identifier), type) {}
+
+Symbol Symbol::function(SymbolId identifier, TypeId returnType, std::vector<TypeId> paramTypes)
+{
+  Symbol symbol(identifier, TypeId::Function);
+  symbol.returnType = returnType;
+  symbol.paramTypes = std::move(paramTypes);
+  return symbol;
+}
+
+SymbolId Symbol::id() const { return this->m_Ident; }
+std::string_view Symbol::name() const { return Interner::global().view(this->m_Ident); }
+TypeId Symbol::type() const { return this->m_Type; }
+TypeId Symbol::getReturnType() const { return this->returnType; }
+uint32_t Symbol::place() const { return this->m_Place; }
+void Symbol::setPlace(uint32_t place) { this->m_Place = place; }
 
 bool Symbol::operator==(const Symbol &other) const
 {
   return this->m_Type == other.m_Type && this->m_Ident == other.m_Ident;
 }
 
-std::vector<std::string> Symbol::getParamTypes() const
+const std::vector<TypeId> &Symbol::getParamTypes() const
 {
   return this->paramTypes;
 }
 
-void Symbol::setParamTypes(std::vector<std::string> paramTypes)
+SymbolTable::SymbolTable() : m_Slots(16, Slot{Interner::INVALID, NONE}), m_SlotBits(4), m_UsedSlots(0) {}
+
+std::shared_ptr<SymbolTable> SymbolTable::empty()
 {
-  this->paramTypes = paramTypes;
+  return std::shared_ptr<SymbolTable>(new SymbolTable());
 }
 
-SymbolTable::SymbolTable() : m_Parent(nullptr) {}
-
-SymbolTable::SymbolTable(const SymbolTable &other)
+std::size_t SymbolTable::slotIndex(Interner::Id name) const
 {
-  this->m_Symbols = other.m_Symbols;
-  if (other.m_Parent.get())
+  // Fibonacci hashing spreads the dense interner ids over the table by
+  // taking the top bits of the product; the probe stops at the name's slot
+  // or at the empty slot it would take
+  std::size_t mask = this->m_Slots.size() - 1;
+  std::size_t index = static_cast<uint32_t>(name * 0x9E3779B9u) >> (32 - this->m_SlotBits);
+  while (this->m_Slots[index].name != Interner::INVALID && this->m_Slots[index].name != name)
   {
-    this->m_Parent = std::make_shared<SymbolTable>(*other.m_Parent);
+    index = (index + 1) & mask;
   }
+  return index;
+}
+
+const SymbolTable::Slot *SymbolTable::findSlot(Interner::Id name) const
+{
+  const Slot &slot = this->m_Slots[this->slotIndex(name)];
+  return slot.name == name ? &slot : nullptr;
 }
 
-SymbolTable &SymbolTable::operator=(const SymbolTable &other)
+SymbolTable::Slot &SymbolTable::insertSlot(Interner::Id name)
 {
-  this->m_Symbols = other.m_Symbols;
-  if (other.m_Parent.get())
+  std::size_t index = this->slotIndex(name);
+  if (this->m_Slots[index].name == name)
   {
-    this->m_Parent = std::make_shared<SymbolTable>(*other.m_Parent);
+    return this->m_Slots[index];
   }
 
-  return *this;
+  if ((this->m_UsedSlots + 1) * 2 > this->m_Slots.size())
+  {
+    this->grow();
+    index = this->slotIndex(name);
+  }
+
+  this->m_UsedSlots++;
+  this->m_Slots[index] = Slot{name, NONE};
+  return this->m_Slots[index];
 }
 
-std::shared_ptr<SymbolTable> SymbolTable::empty()
+void SymbolTable::grow()
 {
-  return std::make_shared<SymbolTable>(SymbolTable());
+  std::vector<Slot> old(this->m_Slots.size() * 2, Slot{Interner::INVALID, NONE});
+  std::swap(old, this->m_Slots);
+  this->m_SlotBits++;
+  this->m_UsedSlots = 0;
+
+  for (const Slot &slot : old)
+  {
+    if (slot.name != Interner::INVALID)
+    {
+      this->insertSlot(slot.name).entry = slot.entry;
+    }
+  }
 }
 
 void SymbolTable::bind(const Symbol &information)
 {
-  this->m_Symbols.emplace(std::make_pair(information.name(), information));
+  Slot &slot = this->insertSlot(information.id());
+
+  this->m_Entries.push_back(Entry{information, slot.entry});
+  slot.entry = static_cast<uint32_t>(this->m_Entries.size() - 1);
 }
 
-std::optional<Symbol> SymbolTable::lookup(const std::string &identifier) const
+uint32_t SymbolTable::findEntry(SymbolId identifier) const
 {
-  try
-  {
-    return this->m_Symbols.at(identifier);
-  }
-  catch (const std::out_of_range &e)
+  if (identifier == Interner::INVALID)
   {
-    return {};
+    return NONE;
   }
+
+  const Slot *slot = this->findSlot(identifier);
+  return slot ? slot->entry : NONE;
+}
+
+const Symbol *SymbolTable::lookup(SymbolId identifier) const
+{
+  uint32_t entry = this->findEntry(identifier);
+  return entry == NONE ? nullptr : &this->m_Entries[entry].symbol;
+}
+
+const Symbol *SymbolTable::lookup(std::string_view identifier) const
+{
+  // names that were never interned cannot have been bound
+  return this->lookup(Interner::global().find(identifier));
+}
+
+const Symbol *SymbolTable::lookup_local(SymbolId identifier) const
+{
+  // the innermost binding belongs to the current scope iff it was made
+  // after the scope's mark
+  uint32_t entry = this->findEntry(identifier);
+  uint32_t mark = this->m_ScopeMarks.empty() ? 0 : this->m_ScopeMarks.back();
+  return entry == NONE || entry < mark ? nullptr : &this->m_Entries[entry].symbol;
+}
+
+const Symbol *SymbolTable::lookup_local(std::string_view identifier) const
+{
+  return this->lookup_local(Interner::global().find(identifier));
 }
 
 void SymbolTable::enter()
 {
-  this->m_Parent = std::make_shared<SymbolTable>(*this);
-  // this->m_Symbols = {};
+  this->m_ScopeMarks.push_back(static_cast<uint32_t>(this->m_Entries.size()));
 }
 
 void SymbolTable::exit()
 {
-  if (!this->m_Parent.get())
+  if (this->m_ScopeMarks.empty())
   {
     throw std::runtime_error(
         "Attempted to exit a symbol table with no surrounding scope.");
   }
 
-  this->m_Symbols = this->m_Parent->m_Symbols;
-  this->m_Parent = this->m_Parent->m_Parent;
+  // undo the scope's bindings innermost first, restoring what they shadowed
+  uint32_t mark = this->m_ScopeMarks.back();
+  this->m_ScopeMarks.pop_back();
+  while (this->m_Entries.size() > mark)
+  {
+    const Entry &entry = this->m_Entries.back();
+    this->insertSlot(entry.symbol.id()).entry = entry.shadowed;
+    this->m_Entries.pop_back();
+  }
+}
+
+std::size_t SymbolTable::depth() const
+{
+  return this->m_ScopeMarks.size();
 }
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <iostream>
+#include <parse_table.h>
+#include <syntax_tree.h>
+#include <utility>
+#include <vector>
+
+std::string_view SyntaxTreeNode::symbolName() const
+{
+  return ParseTable::standard().symbol_name(static_cast<int>(this->symbol));
+}
+
+void SyntaxTreeNode::printTree(int depth) const
+{
+  // walk with an explicit stack, pushing children in reverse so they are
+  // printed in order; the tail of a right-recursive list is printed at its
+  // parent's depth, so a long list stays flat instead of indenting once
+  // per element
+  std::vector<std::pair<const SyntaxTreeNode *, int>> pending = {{this, depth}};
+  while (!pending.empty())
+  {
+    auto [node, level] = pending.back();
+    pending.pop_back();
+
+    std::cout << std::string(2 * static_cast<std::size_t>(level), ' ') << node->getSymbolOrValue() << '\n';
+
+    SyntaxTreeChildren children = node->getChildren();
+    for (std::size_t i = children.size(); i-- > 0;)
+    {
+      const SyntaxTreeNode *child = children[i];
+      bool listTail = i + 1 == children.size() && child->symbol == node->symbol;
+      pending.emplace_back(child, listTail ? level : level + 1);
+    }
+  }
+  std::cout.flush();
+}
+
+SyntaxTreeNode *SyntaxTree::makeLeaf(GrammarSymbol symbol, Interner::Id value, const SourceSpan &span)
+{
+  return this->arena.create<SyntaxTreeNode>(this->nodeCount++, symbol, value, span, nullptr, 0u);
+}
+
+SyntaxTreeNode *SyntaxTree::makeNode(GrammarSymbol symbol, SyntaxTreeNode *const *first, uint32_t count, const SourceSpan &span)
+{
+  SyntaxTreeNode **children = this->arena.allocate_array<SyntaxTreeNode *>(count);
+  std::copy(first, first + count, children);
+  return this->arena.create<SyntaxTreeNode>(this->nodeCount++, symbol, Interner::INVALID, span, children, count);
+}
@@ -1,38 +1,39 @@
+#include <interner.h>
 #include <sstream>
 #include <token.h>
 
-Token Token::identifier(const std::string &ident)
+Token Token::identifier(std::string_view ident)
 {
   Token res;
   res.m_Type = TokenType::Variable;
-  res.m_Identifier = ident;
+  res.m_Lexeme = Interner::global().intern(ident);
 
   return res;
 }
 
-Token Token::function_name(const std::string &ident)
+Token Token::function_name(std::string_view ident)
 {
   Token res;
   res.m_Type = TokenType::FunctionName;
-  res.m_Identifier = ident;
+  res.m_Lexeme = Interner::global().intern(ident);
 
   return res;
 }
 
-Token Token::string_lit(const std::string &literal)
+Token Token::string_lit(std::string_view literal)
 {
   Token res;
   res.m_Type = TokenType::StringLiteral;
-  res.m_StringLiteral = literal;
+  res.m_Lexeme = Interner::global().intern(literal);
 
   return res;
 }
 
-Token Token::num_lit(const std::string &literal)
+Token Token::num_lit(std::string_view literal)
 {
   Token res;
   res.m_Type = TokenType::NumLiteral;
-  res.m_NumLiteral = literal;
+  res.m_Lexeme = Interner::global().intern(literal);
 
   return res;
 }
@@ -41,7 +42,7 @@ Token Token::keyword(enum Keyword keyword)
 {
   Token res;
   res.m_Type = TokenType::Keyword;
-  res.m_Keyword = keyword;
+  res.m_Small = keyword;
 
   return res;
 }
@@ -50,15 +51,41 @@ Token Token::punct(char punct)
 {
   Token res;
   res.m_Type = TokenType::Punctuation;
-  std::stringstream stream;
-  stream << punct;
-  res.m_Punct = std::string(stream.str());
+  res.m_Small = static_cast<uint8_t>(punct);
 
   return res;
 }
 
 TokenType Token::type() const { return this->m_Type; }
 
+std::string_view Token::text() const
+{
+  static constexpr std::string_view PUNCTUATION = ";,()={}";
+
+  switch (this->m_Type)
+  {
+  case TokenType::Keyword:
+    return keyword_view(this->get_keyword());
+  case TokenType::Punctuation:
+  {
+    auto index = PUNCTUATION.find(static_cast<char>(this->m_Small));
+    if (index == std::string_view::npos)
+    {
+      throw TokenException("Invalid punctuation token");
+    }
+    return PUNCTUATION.substr(index, 1);
+  }
+  default:
+    return Interner::global().view(this->m_Lexeme);
+  }
+}
+
+uint32_t Token::lexeme() const { return this->m_Lexeme; }
+
+enum Keyword Token::get_keyword() const { return static_cast<enum Keyword>(this->m_Small); }
+
+char Token::get_punct() const { return static_cast<char>(this->m_Small); }
+
 std::string Token::to_string() const
 {
   std::stringstream stream;
@@ -66,22 +93,22 @@ std::string Token::to_string() const
   switch (this->m_Type)
   {
   case TokenType::Variable:
-    stream << "Var(" << this->m_Identifier << ")";
+    stream << "Var(" << this->text() << ")";
     break;
   case TokenType::StringLiteral:
-    stream << "String(" << this->m_StringLiteral << ")";
+    stream << "String(" << this->text() << ")";
     break;
   case TokenType::NumLiteral:
-    stream << "Num(" << this->m_NumLiteral << ")";
+    stream << "Num(" << this->text() << ")";
     break;
   case TokenType::FunctionName:
-    stream << "Func(" << this->m_Identifier << ")";
+    stream << "Func(" << this->text() << ")";
     break;
   case TokenType::Keyword:
-    stream << this->m_Keyword;
+    stream << static_cast<int>(this->m_Small);
     break;
   case TokenType::Punctuation:
-    stream << this->m_Punct;
+    stream << this->text();
     break;
   }
   return stream.str();
@@ -103,29 +130,24 @@ std::string Token::to_xml() const
   {
   case TokenType::FunctionName:
     token_class = "F";
-    word = this->m_Identifier;
     break;
   case TokenType::NumLiteral:
     token_class = "N";
-    word = this->m_NumLiteral;
     break;
   case TokenType::StringLiteral:
     token_class = "T";
-    word = this->m_StringLiteral;
     break;
   case TokenType::Keyword:
     token_class = "reserved_keyword";
-    word = keyword_to_string(this->m_Keyword);
     break;
   case TokenType::Variable:
     token_class = "V";
-    word = this->m_Identifier;
     break;
   case TokenType::Punctuation:
     token_class = "reserved_keyword";
-    word = this->m_Punct;
     break;
   }
+  word = this->text();
 
   std::stringstream stream;
   stream << "<TOK>" << std::endl;
@@ -139,7 +161,7 @@ std::string Token::to_xml() const
   return stream.str();
 }
 
-std::string keyword_to_string(enum Keyword keyword)
+std::string_view keyword_view(enum Keyword keyword)
 {
   switch (keyword)
   {
@@ -217,7 +239,12 @@ std::string keyword_to_string(enum Keyword keyword)
     break;
   }
 
-  return std::string();
+  return std::string_view();
+}
+
+std::string keyword_to_string(enum Keyword keyword)
+{
+  return std::string(keyword_view(keyword));
 }
 
 TokenException::TokenException(const std::string &msg) : message(msg) {}
@@ -228,27 +255,39 @@ const char *TokenException::what() const noexcept
 
 const std::string Token::get_str_data() const
 {
+  return std::string(this->text());
+}
+
+int Token::get_line_number() const { return this->m_Line; }
+
+void Token::set_line_number(const int &line_number) { this->m_Line = line_number; }
+
+SourceSpan Token::span() const
+{
+  SourceSpan span;
+  span.line = this->m_Line;
+  span.column = this->m_Column;
+  span.offset = this->m_Offset;
+
   switch (this->m_Type)
   {
-  case TokenType::Variable:
-    return this->m_Identifier;
-  case TokenType::Keyword:
-    // throw new TokenException(
-    //     "Invalid access. Can't access data on keyword token.");
-    return keyword_to_string(this->m_Keyword);
-  case TokenType::NumLiteral:
-    return this->m_NumLiteral;
-  case TokenType::FunctionName:
-    return this->m_Identifier;
-  case TokenType::StringLiteral:
-    return this->m_StringLiteral;
   case TokenType::Punctuation:
-    return this->m_Punct;
+    span.length = 1;
+    break;
+  case TokenType::StringLiteral:
+    span.length = this->text().size() + 2; // surrounding quotes
+    break;
   default:
-    throw TokenException("Invalid token type");
+    span.length = this->text().size();
+    break;
   }
-}
 
-int Token::get_line_number() const { return this->m_LineNumber; }
+  return span;
+}
 
-void Token::set_line_number(const int &line_number) { this->m_LineNumber = line_number; }
\ No newline at end of file
+void Token::set_span(const SourceSpan &span)
+{
+  this->m_Line = span.line;
+  this->m_Column = span.column > UINT16_MAX ? UINT16_MAX : span.column;
+  this->m_Offset = span.offset;
+}
\ No newline at end of file
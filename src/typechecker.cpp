@@ -1,737 +1,491 @@
 #include "typechecker.h"
-#include <iostream>
 
-TypeError::TypeError(const std::string &msg, std::string filename, const int &line)
+namespace
 {
-    if (filename.empty())
+    std::string quoted(std::string_view text)
     {
-        this->msg = "\033[31mType Error\033[0m: " + msg;
+        return "'" + std::string(text) + "'";
     }
-    else
+
+    // type named by a VTYP or FTYP keyword
+    TypeId typeOf(const SyntaxTreeNode *keyword)
     {
-        this->msg = filename + ":" + std::to_string(line) + ": \033[31mType Error\033[0m: " + msg;
+        switch (keyword->getSymbolId())
+        {
+        case GrammarSymbol::Num:
+            return TypeId::Num;
+        case GrammarSymbol::Text:
+            return TypeId::Text;
+        case GrammarSymbol::Void:
+            return TypeId::Void;
+        default:
+            return TypeId::Error;
+        }
     }
-}
-
-TypeError::TypeError(const std::string &msg) : msg("\033[31mType Error\033[0m: " + msg) {}
 
-const char *TypeError::what() const noexcept { return this->msg.c_str(); }
+    // TypeId::Error stands for an expression that was already reported;
+    // checks against it are skipped so that one mistake is reported once
+    bool known(TypeId type)
+    {
+        return type != TypeId::Error;
+    }
 
-TypeChecker::TypeChecker(SyntaxTreeNode *root) : root(root), symbolTable(SymbolTable::empty()) {}
+    bool isArithmetic(GrammarSymbol op)
+    {
+        return op == GrammarSymbol::Add || op == GrammarSymbol::Sub || op == GrammarSymbol::Mul || op == GrammarSymbol::Div;
+    }
 
-void TypeChecker::check()
-{
-    try
+    bool isLogical(GrammarSymbol op)
     {
-        checkProgram(root);
+        return op == GrammarSymbol::Or || op == GrammarSymbol::And;
     }
-    catch (const TypeError &e)
+
+    bool isComparison(GrammarSymbol op)
     {
-        std::cerr << "\n"
-                  << e.what() << std::endl;
+        return op == GrammarSymbol::Eq || op == GrammarSymbol::Grt;
     }
 }
 
-void TypeChecker::setFilename(const std::string &filename)
+TypeChecker::TypeChecker(SyntaxTreeNode *root, std::size_t errorLimit)
+    : root(root), symbolTable(SymbolTable::empty()), diagnostics(errorLimit) {}
+
+DiagnosticReport TypeChecker::check()
+{
+    visit(root);
+    return diagnostics.take();
+}
+
+void TypeChecker::error(const SyntaxTreeNode *node, std::string message)
 {
-    this->filename = filename;
+    diagnostics.error(node->getSpan(), std::move(message));
 }
 
-void TypeChecker::checkProgram(SyntaxTreeNode *node)
+TypeId TypeChecker::visitProg(SyntaxTreeNode *node)
 {
     // PROG -> main GLOBVARS ALGO FUNCTIONS
 
     // start by checking global variables
-    if (node->getChildren()[1]->getSymbol() == "GLOBVARS")
-    {
-        checkGlobVars(node->getChildren()[1]);
-    }
+    visit(node->child(1));
 
     // next, check function declarations
-    if (node->getChildren()[3]->getSymbol() == "FUNCTIONS")
-    {
-        checkFunctions(node->getChildren()[3]);
-    }
+    visit(node->child(3));
 
     // finally, check the main algorithm block
-    if (node->getChildren()[2]->getSymbol() == "ALGO")
-    {
-        checkAlgo(node->getChildren()[2]);
-    }
+    visit(node->child(2));
+
+    return TypeId::Void;
 }
 
-void TypeChecker::checkGlobVars(SyntaxTreeNode *globVarsNode)
+TypeId TypeChecker::visitGlobVars(SyntaxTreeNode *globVarsNode)
 {
     // GLOBVARS -> '' | VTYP VNAME , GLOBVARS
-
-    // base case: if the node is epsilon (empty), stop processing
-    if (globVarsNode->getChildren().empty())
+    for (SyntaxTreeNode *link : SyntaxTreeList(globVarsNode))
     {
-        return;
-    }
-
-    // extract VTYP and VNAME
-    SyntaxTreeNode *vtypNode = globVarsNode->getChildren()[0];  // VTYP node
-    SyntaxTreeNode *vnameNode = globVarsNode->getChildren()[1]; // VNAME node
-
-    std::string type = vtypNode->getChildren()[0]->getSymbol();          // the type of the variable (num, text)
-    std::string varname = vnameNode->getChildren()[0]->getActualValue(); // the actual variable name
+        // extract VTYP and VNAME
+        SyntaxTreeNode *vtypNode = link->child(0);            // VTYP node
+        SyntaxTreeNode *vnameNode = link->child(1)->child(0); // variable name
 
-    // check if variable is already declared in the symbol table
-    if (symbolTable->lookup(varname) != std::nullopt)
-    {
-        throw TypeError("Variable '" + varname + "' was already declared", filename, vnameNode->getChildren()[0]->getLineNumber());
-    }
+        TypeId type = typeOf(vtypNode->child(0));   // the type of the variable (num, text)
+        SymbolId varname = vnameNode->getValueId(); // the interned variable name
 
-    // add the variable and its type to the symbol table
-    Symbol symbol(varname, type);
-    symbolTable->bind(symbol);
+        // a redeclaration is reported and the first declaration kept
+        if (symbolTable->lookup_local(varname) != nullptr)
+        {
+            error(vnameNode, "variable " + quoted(vnameNode->value()) + " was already declared");
+            continue;
+        }
 
-    // handle the rest of the global variables recursively (if any)
-    if (globVarsNode->getChildren().size() > 2)
-    {
-        SyntaxTreeNode *nextGlobvarsNode = globVarsNode->getChildren()[3]; // GLOBVARS (recursive part)
-        checkGlobVars(nextGlobvarsNode);
+        // add the variable and its type to the symbol table
+        symbolTable->bind(Symbol(varname, type));
     }
+    return TypeId::Void;
 }
 
-void TypeChecker::checkAlgo(SyntaxTreeNode *algoNode)
+TypeId TypeChecker::visitAlgo(SyntaxTreeNode *algoNode)
 {
     // ALGO -> begin INSTRUC end
 
     // enter the new scope for the ALGO block
     symbolTable->enter();
 
-    for (auto child : algoNode->getChildren())
-    {
-        if (child->getSymbol() == "INSTRUC")
-        {
-            checkInstruc(child);
-        }
-    }
+    visit(algoNode->child(1));
 
     // exit the scope after processing the ALGO block
     symbolTable->exit();
+    return TypeId::Void;
 }
 
-void TypeChecker::checkInstruc(SyntaxTreeNode *instrucNode)
+TypeId TypeChecker::visitInstruc(SyntaxTreeNode *instrucNode)
 {
     // INSTRUC -> '' | COMMAND ; INSTRUC
-
-    // base case: if the node is epsilon (empty), stop processing
-    if (instrucNode->getChildren().empty())
-    {
-        return;
-    }
-
-    for (auto child : instrucNode->getChildren())
+    for (SyntaxTreeNode *link : SyntaxTreeList(instrucNode))
     {
-        if (child->getSymbol() == "COMMAND")
-        {
-            checkCommand(child);
-        }
-        else if (child->getSymbol() == "INSTRUC")
-        {
-            // handle the rest of the instructions recursively (if any)
-            checkInstruc(child);
-        }
+        visit(link->child(0));
     }
+    return TypeId::Void;
 }
 
-void TypeChecker::checkCommand(SyntaxTreeNode *node)
+TypeId TypeChecker::visitCommand(SyntaxTreeNode *node)
 {
     // COMMAND -> skip | halt | print ATOMIC | ASSIGN | CALL | BRANCH | return ATOMIC
-    std::string commandType = node->getChildren()[0]->getSymbol();
-
-    if (commandType == "skip")
-    {
-        return; // nothing to check for skip command
-    }
-    else if (commandType == "halt")
-    {
-        return; // nothing to check for halt command
-    }
-    else if (commandType == "print")
-    {
-        checkAtomic(node->getChildren()[1]);
-    }
-    else if (commandType == "ASSIGN")
-    {
-        checkAssign(node->getChildren()[0]);
-    }
-    else if (commandType == "CALL")
-    {
-        checkCall(node->getChildren()[0]);
-    }
-    else if (commandType == "BRANCH")
-    {
-        checkBranch(node->getChildren()[0]);
-    }
-    else if (commandType == "return")
-    {
-        checkAtomic(node->getChildren()[1]);
-    }
+    switch (node->child(0)->getSymbolId())
+    {
+    case GrammarSymbol::Skip:
+    case GrammarSymbol::Halt:
+        break; // nothing to check for skip and halt commands
+    case GrammarSymbol::Print:
+    case GrammarSymbol::Return:
+        visit(node->child(1));
+        break;
+    default:
+        visit(node->child(0)); // ASSIGN, CALL or BRANCH
+        break;
+    }
+    return TypeId::Void;
 }
 
-std::string TypeChecker::checkAtomic(SyntaxTreeNode *node)
+TypeId TypeChecker::visitAtomic(SyntaxTreeNode *node)
 {
     // ATOMIC -> VNAME | CONST
-    std::string atomicType = node->getChildren()[0]->getSymbol();
+    SyntaxTreeNode *valueNode = node->child(0)->child(0);
 
-    if (atomicType == "VNAME")
+    switch (valueNode->getSymbolId())
     {
-        // check if the variable name exists in the symbol table
-        std::string varName = node->getChildren()[0]->getChildren()[0]->getActualValue();
-        if (symbolTable->lookup(varName) == std::nullopt)
-        {
-            throw TypeError("Undefined variable " + varName);
-        }
-
-        return symbolTable->lookup(varName).value().type(); // return the type of the variable
-    }
-    else if (atomicType == "CONST")
+    case GrammarSymbol::Varname:
     {
-        // check if it's a valid constant (either numliteral or textliteral)
-        std::string constType = node->getChildren()[0]->getChildren()[0]->getSymbol();
-        if (constType == "numliteral")
-        {
-            return "num";
-        }
-        else if (constType == "textliteral")
-        {
-            return "text";
-        }
-        else
+        // check if the variable name exists in the symbol table
+        const Symbol *varSymbol = symbolTable->lookup(valueNode->getValueId());
+        if (varSymbol == nullptr)
         {
-            throw TypeError("Invalid constant type " + constType);
+            error(valueNode, "undefined variable " + quoted(valueNode->value()));
+            return TypeId::Error;
         }
+        return varSymbol->type(); // return the type of the variable
     }
-    else
-    {
-        // if it's not VNAME or CONST, it's an invalid atomic expression
-        throw TypeError("Invalid atomic expression " + atomicType);
+    case GrammarSymbol::Numliteral:
+        return TypeId::Num;
+    case GrammarSymbol::Textliteral:
+        return TypeId::Text;
+    default:
+        error(valueNode, "invalid atomic expression " + quoted(valueNode->symbolName()));
+        return TypeId::Error;
     }
 }
 
-void TypeChecker::checkAssign(SyntaxTreeNode *node)
+TypeId TypeChecker::visitAssign(SyntaxTreeNode *node)
 {
     // ASSIGN -> VNAME <input | VNAME = TERM
-    std::string varname = node->getChildren()[0]->getChildren()[0]->getActualValue(); // get actual variable name
+    SyntaxTreeNode *varNode = node->child(0)->child(0); // the variable name
 
-    // ensure the variable is declared in the symbol table
-    auto varSymbol = symbolTable->lookup(varname);
-    if (varSymbol == std::nullopt)
+    // an undeclared target is reported, and its value is still checked
+    const Symbol *varSymbol = symbolTable->lookup(varNode->getValueId());
+    TypeId varType = varSymbol ? varSymbol->type() : TypeId::Error;
+    if (varSymbol == nullptr)
     {
-        if (node->getChildren()[1]->getSymbol() == "<input")
-        {
-            throw TypeError("Undeclared variable '" + varname + "' assigned a value", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
-        else
-        {
-            throw TypeError("Undeclared variable '" + varname + "' assigned a value", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
+        error(varNode, "undeclared variable " + quoted(varNode->value()) + " assigned a value");
     }
 
-    std::string assignOperator = node->getChildren()[1]->getSymbol();
-
     // case 1: handle input from user at runtime (numeric)
-    if (assignOperator == "<input")
+    if (node->child(1)->getSymbolId() == GrammarSymbol::Input)
     {
-        // check if the variable is of numeric type
-        if (varSymbol.value().type() != "num")
+        if (known(varType) && varType != TypeId::Num)
         {
-            throw TypeError("'" + varname + "' must be of numeric type to accept input", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
+            error(varNode, quoted(varNode->value()) + " must be of numeric type to accept input");
         }
+        return TypeId::Void;
     }
+
     // case 2: handle standard assignment (VNAME = TERM)
-    else if (assignOperator == "=")
+    TypeId termType = visit(node->child(2));
+    if (known(varType) && known(termType) && varType != termType)
     {
-        // retrieve the term being assigned
-        SyntaxTreeNode *termNode = node->getChildren()[2];
-
-        // perform type checking on the term and get its type
-        std::string termType = checkTerm(termNode);
-
-        // compare the type of the variable and the term
-        if (varSymbol->type() != termType)
-        {
-            throw TypeError("Cannot assign value of type '" + termType + "' to variable '" + varname + "' of type '" + varSymbol->type() + "'", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
+        error(varNode, "cannot assign value of type " + quoted(typeName(termType)) + " to variable " + quoted(varNode->value()) + " of type " + quoted(typeName(varType)));
     }
+    return TypeId::Void;
 }
 
-std::optional<std::string> TypeChecker::checkCall(SyntaxTreeNode *node)
+TypeId TypeChecker::visitCall(SyntaxTreeNode *node)
 {
     // CALL -> FNAME ( ATOMIC , ATOMIC , ATOMIC )
-    std::string functionName = node->getChildren()[0]->getChildren()[0]->getActualValue(); // get the function name
+    SyntaxTreeNode *functionNode = node->child(0)->child(0); // the function name
 
-    // check if the function exists in the symbol table
-    auto functionSymbol = symbolTable->lookup(functionName);
-    if (!functionSymbol)
-    {
-        throw TypeError("Undeclared function '" + functionName + "' called", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-    }
+    // check and store the types of the arguments; the grammar fixes them at three
+    CallArgTypes argTypes = {visit(node->child(2)), visit(node->child(4)), visit(node->child(6))};
 
-    // // verify that the symbol is indeed a function
-    // if (functionSymbol.value().type() != "fname")
-    // {
-    //     throw TypeError("'" + functionName + "' is not a function", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-    // }
-
-    std::vector<std::string> argTypes; // store the types of the arguments
-    for (auto child : node->getChildren())
+    // check if the function exists in the symbol table
+    const Symbol *functionSymbol = symbolTable->lookup(functionNode->getValueId());
+    if (functionSymbol == nullptr)
     {
-        if (child->getSymbol() == "ATOMIC")
-        {
-            std::string atomicType = checkAtomic(child); // check and get the type of the argument
-            argTypes.push_back(atomicType);
-        }
+        error(functionNode, "undeclared function " + quoted(functionNode->value()) + " called");
+        return TypeId::Error;
     }
 
     // check the number and types of arguments
-    checkFunctionArguments(functionSymbol.value(), argTypes, node->getChildren()[0]->getChildren()[0]->getLineNumber());
+    checkFunctionArguments(*functionSymbol, argTypes, functionNode);
 
     // return the function type (if any)
-    return functionSymbol.value().type();
+    return functionSymbol->getReturnType();
 }
 
-void TypeChecker::checkFunctionArguments(const Symbol &functionSymbol, std::vector<std::string> argTypes, int lineNumber)
+void TypeChecker::checkFunctionArguments(const Symbol &functionSymbol, const CallArgTypes &argTypes, const SyntaxTreeNode *callNode)
 {
-    std::vector<std::string> expectedParamTypes = functionSymbol.getParamTypes();
+    const std::vector<TypeId> &expectedParamTypes = functionSymbol.getParamTypes();
 
     if (argTypes.size() != expectedParamTypes.size())
     {
-        throw TypeError("Incorrect number of arguments in function call to '" + functionSymbol.name() + "'. Expected " + std::to_string(expectedParamTypes.size()) + " but got " + std::to_string(argTypes.size()), filename, lineNumber);
+        error(callNode, "incorrect number of arguments in call to " + quoted(functionSymbol.name()) + ": expected " + std::to_string(expectedParamTypes.size()) + " but got " + std::to_string(argTypes.size()));
+        return;
     }
 
-    // check if argument types match expected types
-    for (size_t i = 0; i < argTypes.size(); ++i)
+    // every mismatched argument is reported
+    for (std::size_t i = 0; i < argTypes.size(); ++i)
     {
-        if (argTypes[i] != expectedParamTypes[i])
+        if (known(argTypes[i]) && known(expectedParamTypes[i]) && argTypes[i] != expectedParamTypes[i])
         {
-            throw TypeError("Incorrect type for argument " + std::to_string(i + 1) + " in call to '" + functionSymbol.name() + "'. Expected " + expectedParamTypes[i] + " but got " + argTypes[i], filename, lineNumber);
+            error(callNode, "incorrect type for argument " + std::to_string(i + 1) + " in call to " + quoted(functionSymbol.name()) + ": expected " + std::string(typeName(expectedParamTypes[i])) + " but got " + std::string(typeName(argTypes[i])));
         }
     }
 }
 
-void TypeChecker::checkBranch(SyntaxTreeNode *node)
+TypeId TypeChecker::visitBranch(SyntaxTreeNode *node)
 {
     // BRANCH -> if COND then ALGO else ALGO
-    SyntaxTreeNode *condNode = node->getChildren()[1];     // COND (condition)
-    SyntaxTreeNode *thenAlgoNode = node->getChildren()[3]; // 1st ALGO (then block)
-    SyntaxTreeNode *elseAlgoNode = node->getChildren()[5]; // 2nd ALGO (else block)
 
-    if (condNode->getSymbol() == "COND")
-    {
-        // check the condition
-        checkCond(condNode);
-    }
-    else
-    {
-        throw TypeError("Invalid condition type '" + condNode->getSymbol() + "'.", filename, condNode->getLineNumber());
-    }
+    // check the condition
+    visit(node->child(1));
 
-    if (thenAlgoNode->getSymbol() == "ALGO")
+    // check the "then" and "else" blocks, each in its own scope
+    for (SyntaxTreeNode *algoNode : {node->child(3), node->child(5)})
     {
-        // enter the "then" scope
         symbolTable->enter();
-        checkAlgo(thenAlgoNode);
+        visit(algoNode);
         symbolTable->exit();
     }
-    else
-    {
-        throw TypeError("Invalid 'then' block type '" + thenAlgoNode->getSymbol() + "'.", filename, thenAlgoNode->getLineNumber());
-    }
-
-    if (elseAlgoNode->getSymbol() == "ALGO")
-    {
-        // enter the "else" scope
-        symbolTable->enter();
-        checkAlgo(elseAlgoNode);
-        symbolTable->exit();
-    }
-    else
-    {
-        throw TypeError("Invalid 'else' block type '" + elseAlgoNode->getSymbol() + "'.", filename, elseAlgoNode->getLineNumber());
-    }
+    return TypeId::Void;
 }
 
-std::string TypeChecker::checkTerm(SyntaxTreeNode *node)
+TypeId TypeChecker::visitTerm(SyntaxTreeNode *node)
 {
-    // NOTE: function must return the type of the term
-
     // TERM -> ATOMIC | CALL | OP
-    std::string termType = node->getChildren()[0]->getSymbol();
-
-    if (termType == "ATOMIC")
-    {
-        return checkAtomic(node->getChildren()[0]);
-    }
-    else if (termType == "CALL")
-    {
-        std::optional<std::string> callReturnType = checkCall(node->getChildren()[0]);
-        if (callReturnType.has_value())
-        {
-            return callReturnType.value();
-        }
-        else
-        {
-            throw TypeError("Invalid return type for function call.", filename, node->getChildren()[0]->getLineNumber());
-        }
-    }
-    else if (termType == "OP")
-    {
-        return checkOp(node->getChildren()[0]);
-    }
-    else
-    {
-        throw TypeError("Invalid term type '" + termType + "'.");
-    }
+    return visit(node->child(0));
 }
 
-std::string TypeChecker::checkOp(SyntaxTreeNode *node)
+TypeId TypeChecker::visitOp(SyntaxTreeNode *node)
 {
     // OP -> UNOP ( ARG ) | BINOP ( ARG , ARG )
-    SyntaxTreeNode *opTypeNode = node->getChildren()[0];
+    SyntaxTreeNode *opTypeNode = node->child(0);
 
-    if (opTypeNode->getSymbol() == "UNOP")
+    if (opTypeNode->getSymbolId() == GrammarSymbol::UNOP)
     {
         // unary operation
-        return checkUnop(opTypeNode, node->getChildren()[2]);
-    }
-    else if (opTypeNode->getSymbol() == "BINOP")
-    {
-        // binary operation
-        return checkBinop(opTypeNode, node->getChildren()[2], node->getChildren()[4]);
-    }
-    else
-    {
-        throw TypeError("Invalid operation type.");
+        return checkUnop(opTypeNode, node->child(2));
     }
+
+    // binary operation
+    return checkBinop(opTypeNode, node->child(2), node->child(4));
 }
 
-std::string TypeChecker::checkCond(SyntaxTreeNode *node)
+TypeId TypeChecker::visitCond(SyntaxTreeNode *node)
 {
     // COND -> SIMPLE | COMPOSIT
-    if (node->getChildren()[0]->getSymbol() == "SIMPLE")
-    {
-        return checkSimple(node->getChildren()[0]); // check simple condition
-    }
-    else if (node->getChildren()[0]->getSymbol() == "COMPOSIT")
-    {
-        return checkComposit(node->getChildren()[0]); // check composite condition
-    }
-    else
-    {
-        throw TypeError("Invalid condition type.");
-    }
+    return visit(node->child(0));
 }
 
-std::string TypeChecker::checkSimple(SyntaxTreeNode *node)
+TypeId TypeChecker::visitSimple(SyntaxTreeNode *node)
 {
     // SIMPLE -> BINOP ( ATOMIC , ATOMIC )
-    std::string binOp = node->getChildren()[0]->getChildren()[0]->getSymbol(); // BINOP
-    SyntaxTreeNode *leftAtomicNode = node->getChildren()[2];                   // 1st ATOMIC
-    SyntaxTreeNode *rightAtomicNode = node->getChildren()[4];                  // 2nd ATOMIC
+    SyntaxTreeNode *opNode = node->child(0)->child(0); // BINOP
+    GrammarSymbol binOp = opNode->getSymbolId();
 
     // check the types of both atomic expressions
-    std::string leftType = checkAtomic(leftAtomicNode);
-    std::string rightType = checkAtomic(rightAtomicNode);
-
-    // for binary operations, both ATOMIC values must be of the same type
-    if (leftType != rightType)
+    TypeId leftType = visit(node->child(2));
+    TypeId rightType = visit(node->child(4));
+    if (!known(leftType) || !known(rightType))
     {
-        throw TypeError("Incompatible types for binary operator '" + binOp + "'.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
+        return TypeId::Num;
     }
 
-    // ensure the BINOP is valid for the types (in this case, assume both are numeric or comparable)
-    if (binOp == "add" || binOp == "sub" || binOp == "mul" || binOp == "div")
-    {
-        if (leftType != "num" || rightType != "num")
-        {
-            throw TypeError("Arithmetic operator '" + binOp + "' requires numeric operands.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
-    }
-    else if (binOp == "eq" || binOp == "grt")
-    {
-        // comparison operators 'eq' (equality) and 'grt' (greater than) should work with the same types
-        if (leftType != rightType)
-        {
-            throw TypeError("Comparison operator '" + binOp + "' requires operands of the same type.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
-    }
-    else if (binOp == "or" || binOp == "and")
+    // for binary operations, both ATOMIC values must be of the same type
+    if (leftType != rightType)
     {
-        if (leftType != "num" || rightType != "num")
-        {
-            throw TypeError("Logical operator '" + binOp + "' requires numeric (boolean-like) operands.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
+        error(opNode, "incompatible types for binary operator " + quoted(opNode->symbolName()));
     }
-    else
+    else if ((isArithmetic(binOp) || isLogical(binOp)) && leftType != TypeId::Num)
     {
-        throw TypeError("Unknown binary operator type '" + binOp + "'.");
+        error(opNode, "operator " + quoted(opNode->symbolName()) + " requires numeric operands");
     }
 
-    return "num"; // conditions ultimately return a numeric type (1 for true, 0 for false)
+    return TypeId::Num; // conditions ultimately return a numeric type (1 for true, 0 for false)
 }
 
-std::string TypeChecker::checkComposit(SyntaxTreeNode *node)
+TypeId TypeChecker::visitComposit(SyntaxTreeNode *node)
 {
     // COMPOSIT -> BINOP ( SIMPLE , SIMPLE ) | UNOP ( SIMPLE )
-    if (node->getChildren()[0]->getSymbol() == "BINOP")
-    {
-        std::string binOp = node->getChildren()[0]->getChildren()[0]->getSymbol(); // BINOP
-        SyntaxTreeNode *leftSimpleNode = node->getChildren()[2];                   // 1st SIMPLE
-        SyntaxTreeNode *rightSimpleNode = node->getChildren()[4];                  // 2nd SIMPLE
-
-        // recursively check both simple conditions
-        std::string leftSimpleType = checkSimple(leftSimpleNode);
-        std::string rightSimpleType = checkSimple(rightSimpleNode);
+    SyntaxTreeNode *opNode = node->child(0)->child(0);
 
-        // both simple conditions should return "num" (boolean-like numeric)
-        if (leftSimpleType != "num" || rightSimpleType != "num")
-        {
-            throw TypeError("Binary operator '" + binOp + "' requires numeric (boolean) conditions.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
+    // simple conditions are always numeric (boolean-like), so only the
+    // operator itself can be wrong
+    if (node->child(0)->getSymbolId() == GrammarSymbol::BINOP)
+    {
+        visit(node->child(2));
+        visit(node->child(4));
 
         // only logical operators (and/or) are valid between two conditions
-        if (binOp != "or" && binOp != "and")
+        if (!isLogical(opNode->getSymbolId()))
         {
-            throw TypeError("Binary operator '" + binOp + "' is not valid between conditions.", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
+            error(opNode, "binary operator " + quoted(opNode->symbolName()) + " is not valid between conditions");
         }
-
-        return "num"; // conditions result in a numeric (boolean-like) value
     }
-    else if (node->getChildren()[0]->getSymbol() == "UNOP")
+    else
     {
-        std::string unOp = node->getChildren()[0]->getChildren()[0]->getSymbol(); // UNOP
-        SyntaxTreeNode *simpleNode = node->getChildren()[2];                      // SIMPLE
-
-        std::string simpleNodeType = checkSimple(simpleNode); // recursively check the simple condition
-
-        // the result of a simple condition should be numeric (boolean-like)
-        if (simpleNodeType != "num")
-        {
-            throw TypeError("Unary operator '" + unOp + "' requires a numeric (boolean-like) condition", filename, node->getChildren()[0]->getChildren()[0]->getLineNumber());
-        }
+        visit(node->child(2));
 
         // only 'not' is a valid unary operator for conditions
-        if (unOp != "not")
+        if (opNode->getSymbolId() != GrammarSymbol::Not)
         {
-            throw TypeError("Unknown unary operator type '" + unOp + "' for condition");
+            error(opNode, "unary operator " + quoted(opNode->symbolName()) + " is not valid on a condition");
         }
-
-        return "num"; // result of a unary operation on a condition is also numeric (boolean-like)
-    }
-    else
-    {
-        throw TypeError("Invalid composite condition type");
     }
+
+    return TypeId::Num; // conditions result in a numeric (boolean-like) value
 }
 
-std::string TypeChecker::checkUnop(SyntaxTreeNode *node, SyntaxTreeNode *argNode)
+TypeId TypeChecker::checkUnop(SyntaxTreeNode *node, SyntaxTreeNode *argNode)
 {
     // UNOP -> not | sqrt
-    std::string operatorValue = node->getChildren()[0]->getSymbol(); // UNOP (the operator value e.g 'not', 'sqrt')
-
-    std::string argType = checkArg(argNode); // check the type of the argument
+    SyntaxTreeNode *opNode = node->child(0); // the operator, 'not' or 'sqrt'
 
-    if (operatorValue == "not")
-    {
-        if (argType != "num")
-        {
-            throw TypeError("'not' operation requires a numeric argument.", filename, node->getChildren()[0]->getLineNumber());
-        }
-        return "num"; // the result of 'not' is numeric (e.g., 1 for true, 0 for false)
-    }
-    else if (operatorValue == "sqrt")
-    {
-        if (argType != "num")
-        {
-            throw TypeError("'sqrt' operation requires a numeric argument.", filename, node->getChildren()[0]->getLineNumber());
-        }
-        return "num"; // the result of 'sqrt' is also numeric
-    }
-    else
+    TypeId argType = visit(argNode); // check the type of the argument
+    if (known(argType) && argType != TypeId::Num)
     {
-        throw TypeError("Unknown unary operator type '" + operatorValue + "'.");
+        error(opNode, quoted(opNode->symbolName()) + " requires a numeric argument");
     }
+
+    return TypeId::Num; // the result of both 'not' and 'sqrt' is numeric
 }
 
-std::string TypeChecker::checkBinop(SyntaxTreeNode *node, SyntaxTreeNode *leftArgNode, SyntaxTreeNode *rightArgNode)
+TypeId TypeChecker::checkBinop(SyntaxTreeNode *node, SyntaxTreeNode *leftArgNode, SyntaxTreeNode *rightArgNode)
 {
     // BINOP -> or | and | eq | grt | add | sub | mul | div
-    std::string operatorValue = node->getChildren()[0]->getSymbol(); // (the operator value e.g 'or', 'and', etc)
+    SyntaxTreeNode *opNode = node->child(0); // the operator, e.g. 'or', 'and'
+    GrammarSymbol binOp = opNode->getSymbolId();
 
-    std::string leftArgType = checkArg(leftArgNode);   // type of the first argument
-    std::string rightArgType = checkArg(rightArgNode); // type of the second argument
+    TypeId leftArgType = visit(leftArgNode);   // type of the first argument
+    TypeId rightArgType = visit(rightArgNode); // type of the second argument
+    if (!known(leftArgType) || !known(rightArgType))
+    {
+        return TypeId::Num;
+    }
 
-    // ensure both arguments are numeric for arithmetic operators
-    if (operatorValue == "add" || operatorValue == "sub" || operatorValue == "mul" || operatorValue == "div")
+    // arithmetic and logical operators need numeric arguments; comparison
+    // operators need arguments of the same type
+    if (isArithmetic(binOp) && (leftArgType != TypeId::Num || rightArgType != TypeId::Num))
     {
-        if (leftArgType != "num" || rightArgType != "num")
-        {
-            throw TypeError("Arithmetic operator '" + operatorValue + "' require both arguments to be numeric.", filename, node->getChildren()[0]->getLineNumber());
-        }
-        return "num"; // arithmetic operations result in a numeric type
+        error(opNode, "arithmetic operator " + quoted(opNode->symbolName()) + " requires both arguments to be numeric");
     }
-    // ensure both arguments are the same type for logical and comparison operators
-    else if (operatorValue == "or" || operatorValue == "and" || operatorValue == "eq" || operatorValue == "grt")
+    else if ((isLogical(binOp) || isComparison(binOp)) && leftArgType != rightArgType)
     {
-        if (leftArgType != rightArgType)
-        {
-            throw TypeError("Binary operator '" + operatorValue + "' requires both arguments to be of the same type.", filename, node->getChildren()[0]->getLineNumber());
-        }
-
-        // 'or' and 'and' return numeric types, comparisons return boolean-like numeric types (1 or 0)
-        if (operatorValue == "or" || operatorValue == "and")
-        {
-            return "num";
-        }
-        else
-        {
-            return "num"; // comparisons also return numeric values
-        }
+        error(opNode, "binary operator " + quoted(opNode->symbolName()) + " requires both arguments to be of the same type");
     }
-    else
+    else if (isLogical(binOp) && leftArgType != TypeId::Num)
     {
-        throw TypeError("Unknown binary operator type '" + operatorValue + "'.");
+        error(opNode, "logical operator " + quoted(opNode->symbolName()) + " requires both arguments to be numeric");
     }
+
+    return TypeId::Num; // arithmetic, logical and comparison results are all numeric
 }
 
-std::string TypeChecker::checkArg(SyntaxTreeNode *node)
+TypeId TypeChecker::visitArg(SyntaxTreeNode *node)
 {
     // ARG -> ATOMIC | OP
-    SyntaxTreeNode *argTypeNode = node->getChildren()[0];
-
-    if (argTypeNode->getSymbol() == "ATOMIC")
-    {
-        return checkAtomic(node->getChildren()[0]); // check the type of the atomic value
-    }
-    else if (argTypeNode->getSymbol() == "OP")
-    {
-        return checkOp(node->getChildren()[1]); // check the type of the operation
-    }
-    else
-    {
-        throw TypeError("Invalid argument type.");
-    }
+    return visit(node->child(0));
 }
 
-void TypeChecker::checkFunctions(SyntaxTreeNode *node)
+TypeId TypeChecker::visitFunctions(SyntaxTreeNode *node)
 {
     // FUNCTIONS -> '' | DECL FUNCTIONS
-    for (auto child : node->getChildren())
+    for (SyntaxTreeNode *link : SyntaxTreeList(node))
     {
-        if (child->getSymbol() == "DECL")
-        {
-            checkDecl(child);
-        }
-        else if (child->getSymbol() == "FUNCTIONS")
-        {
-            checkFunctions(child); // recursively check the next function in the list
-        }
+        visit(link->child(0));
     }
+    return TypeId::Void;
 }
 
-void TypeChecker::checkDecl(SyntaxTreeNode *node)
+TypeId TypeChecker::visitDecl(SyntaxTreeNode *node)
 {
     // DECL -> HEADER BODY
-    for (auto child : node->getChildren())
-    {
-        if (child->getSymbol() == "HEADER")
-        {
-            checkHeader(child); // check the function header (return type, parameter types)
-        }
-        else if (child->getSymbol() == "BODY")
-        {
-            checkBody(child); // check the function body (variable declarations, return types)
-        }
-    }
+    visit(node->child(0)); // check the function header (return type, parameter types)
+    visit(node->child(1)); // check the function body (variable declarations, return types)
+    return TypeId::Void;
 }
 
-void TypeChecker::checkHeader(SyntaxTreeNode *node)
+TypeId TypeChecker::visitHeader(SyntaxTreeNode *node)
 {
     // HEADER -> FTYP FNAME ( VNAME , VNAME , VNAME )
-    std::string returnType = node->getChildren()[0]->getChildren()[0]->getSymbol();        // FTYP (function return type)
-    std::string functionName = node->getChildren()[1]->getChildren()[0]->getActualValue(); // FNAME (function name)
+    TypeId returnType = typeOf(node->child(0)->child(0));    // FTYP (function return type)
+    SyntaxTreeNode *functionNode = node->child(1)->child(0); // FNAME (function name)
 
-    // parameter types (assuming exactly 3 parameters as specified by the grammar)
-    std::vector<std::string> paramTypes;
-    std::vector<int> paramIndexes = {3, 5, 7}; // indexes of the parameter symbols
-    for (int m = 0; m < 3; m++)
+    // parameter types (exactly 3 parameters as specified by the grammar); an
+    // undeclared parameter is reported and gets the error type
+    std::vector<TypeId> paramTypes;
+    for (std::size_t index : {3, 5, 7})
     {
-        int index = paramIndexes[m];
-
-        std::string paramName = node->getChildren()[index]->getChildren()[0]->getActualValue(); // get the parameter name (variable name)
+        SyntaxTreeNode *paramNode = node->child(index)->child(0); // the parameter name (variable name)
 
-        // check if the parameter is already declared in the symbol table
-        if (symbolTable->lookup(paramName) == std::nullopt)
+        const Symbol *paramSymbol = symbolTable->lookup(paramNode->getValueId());
+        if (paramSymbol == nullptr)
         {
-            throw TypeError("Parameter variable '" + paramName + "' was not declared.", filename, node->getChildren()[index]->getChildren()[0]->getLineNumber());
+            error(paramNode, "parameter variable " + quoted(paramNode->value()) + " was not declared");
         }
-
-        std::string paramType = symbolTable->lookup(paramName).value().type(); // lookup type of each parameter
-        paramTypes.push_back(paramType);
+        paramTypes.push_back(paramSymbol ? paramSymbol->type() : TypeId::Error);
     }
 
-    // check if the function is already declared in the symbol table
-    if (symbolTable->lookup(functionName) != std::nullopt)
+    // a redeclared function is reported and the first declaration kept
+    if (symbolTable->lookup(functionNode->getValueId()) != nullptr)
     {
-        throw TypeError("Function '" + functionName + "' was already declared", filename, node->getChildren()[1]->getChildren()[0]->getLineNumber());
+        error(functionNode, "function " + quoted(functionNode->value()) + " was already declared");
+        return TypeId::Void;
     }
 
-    Symbol functionSymbol(functionName, returnType);
-    functionSymbol.setParamTypes(paramTypes); // store the parameter types in the function's symbol
-    symbolTable->bind(functionSymbol);        // bind the function name in the current scope
+    // store the parameter types in the function's symbol and bind it in the current scope
+    symbolTable->bind(Symbol::function(functionNode->getValueId(), returnType, std::move(paramTypes)));
+    return TypeId::Void;
 }
 
-void TypeChecker::checkBody(SyntaxTreeNode *node)
+TypeId TypeChecker::visitBody(SyntaxTreeNode *node)
 {
     // BODY -> PROLOG LOCVARS ALGO EPILOG SUBFUNCS end
     symbolTable->enter(); // enter a new scope for the function body
 
     // start by checking local variables variables first
-    if (node->getChildren()[1]->getSymbol() == "LOCVARS")
-    {
-        // check local variables
-        checkLocVars(node->getChildren()[1]);
-    }
+    visit(node->child(1));
 
     // next, check subfunction declarations, if any
-    if (node->getChildren()[4]->getSymbol() == "SUBFUNCS")
-    {
-        checkFunctions(node->getChildren()[4]->getChildren()[0]);
-    }
+    visit(node->child(4));
 
     // finally, check the function algorithm block
-    if (node->getChildren()[2]->getSymbol() == "ALGO")
-    {
-        // check the algorithm (instructions)
-        checkAlgo(node->getChildren()[2]);
-    }
+    visit(node->child(2));
 
     symbolTable->exit(); // exit the function's scope
+    return TypeId::Void;
 }
 
-void TypeChecker::checkLocVars(SyntaxTreeNode *node)
+TypeId TypeChecker::visitLocVars(SyntaxTreeNode *node)
 {
     // LOCVARS -> VTYP VNAME , VTYP VNAME , VTYP VNAME ,
-    for (size_t i = 0; i < node->getChildren().size(); i++)
+    for (std::size_t i = 0; i < node->getChildren().size(); i += 3)
     {
-        if (node->getChildren()[i]->getSymbol() == "VTYP")
-        {
-            std::string varType = node->getChildren()[i]->getChildren()[0]->getSymbol();
-            std::string varName = node->getChildren()[i + 1]->getChildren()[0]->getActualValue(); // (local variable name)
+        TypeId varType = typeOf(node->child(i)->child(0));
+        SyntaxTreeNode *varNode = node->child(i + 1)->child(0); // (local variable name)
 
-            // check if variable is already declared in the symbol table
-            if (symbolTable->lookup(varName) != std::nullopt)
-            {
-                throw TypeError("Variable '" + varName + "' was already declared", filename, node->getChildren()[i + 1]->getChildren()[0]->getLineNumber());
-            }
-
-            Symbol varSymbol(varName, varType); // create a symbol for the variable
-            symbolTable->bind(varSymbol);       // bind the local variable in the current scope
+        // a redeclaration is reported and the first declaration kept
+        if (symbolTable->lookup_local(varNode->getValueId()) != nullptr)
+        {
+            error(varNode, "variable " + quoted(varNode->value()) + " was already declared");
+            continue;
         }
+
+        symbolTable->bind(Symbol(varNode->getValueId(), varType)); // bind the local variable in the current scope
     }
+    return TypeId::Void;
 }
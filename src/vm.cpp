@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vm.h>
+
+// GCC and Clang jump from one instruction's handler straight to the next
+// through a table of label addresses; anything else, or a build defining
+// SPL_VM_SWITCH, uses a switch
+#if defined(__GNUC__) && !defined(SPL_VM_SWITCH)
+#define SPL_VM_THREADED 1
+#endif
+
+VM::VM(const Bytecode &bytecode, std::istream &in, std::ostream &out)
+    : m_Bytecode(bytecode), m_In(in), m_Out(out),
+      m_Statics(bytecode.statics) {}
+
+void VM::run() {
+  const BytecodeInstruction *code = this->m_Bytecode.code.data();
+  const BytecodeFunction &main = this->m_Bytecode.functions[0];
+  this->m_Calls.clear();
+  this->m_Stack.assign(main.frame_size + Bytecode::ARGUMENTS, {});
+  std::copy(main.initial.begin(), main.initial.end(), this->m_Stack.begin());
+
+  // a register operand picks its base by the STATIC bit
+  std::size_t frame = 0;
+  BytecodeValue *bases[2] = {this->m_Stack.data(), this->m_Statics.data()};
+#define R(operand) (bases[(operand) >> 31][(operand) & ~Bytecode::STATIC])
+#define N(operand) R(operand).number
+#define T(operand) R(operand).text
+
+  const BytecodeInstruction *pc = code + main.entry;
+  uint64_t executed = 0;
+
+#ifdef SPL_VM_THREADED
+  // in the order of BytecodeOpcode
+  static const void *const handlers[] = {
+      &&op_Move,       &&op_Add,           &&op_Sub,
+      &&op_Mul,        &&op_Div,           &&op_And,
+      &&op_Or,         &&op_Not,           &&op_Sqrt,
+      &&op_Eq,         &&op_EqText,        &&op_Grt,
+      &&op_GrtText,    &&op_Input,         &&op_Jump,
+      &&op_JumpIfEq,   &&op_JumpIfEqText,  &&op_JumpIfGrt,
+      &&op_JumpIfGrtText, &&op_Call,       &&op_TailCall,
+      &&op_Return,     &&op_Print,         &&op_PrintText,
+      &&op_Halt};
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    executed++;                                                                \
+    goto *handlers[static_cast<uint8_t>(pc->opcode)];                          \
+  } while (0)
+#define CASE(name) op_##name:
+#else
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    executed++;                                                                \
+    goto dispatch;                                                             \
+  } while (0)
+#define CASE(name) case BytecodeOpcode::name:
+#endif
+#define NEXT()                                                                 \
+  do {                                                                         \
+    pc++;                                                                      \
+    DISPATCH();                                                                \
+  } while (0)
+#define BINARY(name, expression)                                               \
+  CASE(name) {                                                                 \
+    double x = N(pc->b);                                                       \
+    double y = N(pc->c);                                                       \
+    N(pc->a) = (expression);                                                   \
+    NEXT();                                                                    \
+  }
+#define JUMP_IF(name, condition)                                               \
+  CASE(name) {                                                                 \
+    if (condition) {                                                           \
+      pc = code + pc->a;                                                       \
+      DISPATCH();                                                              \
+    }                                                                          \
+    NEXT();                                                                    \
+  }
+
+  auto text = [](Interner::Id id) { return Interner::global().view(id); };
+
+  DISPATCH();
+#ifndef SPL_VM_THREADED
+dispatch:
+  switch (pc->opcode) {
+#endif
+  CASE(Move) {
+    R(pc->a) = R(pc->b);
+    NEXT();
+  }
+  BINARY(Add, x + y)
+  BINARY(Sub, x - y)
+  BINARY(Mul, x * y)
+  BINARY(Div, x / y)
+  BINARY(And, x != 0 && y != 0 ? 1.0 : 0.0)
+  BINARY(Or, x != 0 || y != 0 ? 1.0 : 0.0)
+  BINARY(Eq, x == y ? 1.0 : 0.0)
+  BINARY(Grt, x > y ? 1.0 : 0.0)
+  CASE(Not) {
+    N(pc->a) = N(pc->b) == 0 ? 1.0 : 0.0;
+    NEXT();
+  }
+  CASE(Sqrt) {
+    N(pc->a) = std::sqrt(N(pc->b));
+    NEXT();
+  }
+  CASE(EqText) {
+    N(pc->a) = T(pc->b) == T(pc->c) ? 1.0 : 0.0;
+    NEXT();
+  }
+  CASE(GrtText) {
+    N(pc->a) = text(T(pc->b)) > text(T(pc->c)) ? 1.0 : 0.0;
+    NEXT();
+  }
+  CASE(Input) {
+    double value;
+    if (!(this->m_In >> value)) {
+      throw std::runtime_error("expected a number on the input");
+    }
+    N(pc->a) = value;
+    NEXT();
+  }
+  CASE(Jump) {
+    pc = code + pc->a;
+    DISPATCH();
+  }
+  JUMP_IF(JumpIfEq, N(pc->b) == N(pc->c))
+  JUMP_IF(JumpIfEqText, T(pc->b) == T(pc->c))
+  JUMP_IF(JumpIfGrt, N(pc->b) > N(pc->c))
+  JUMP_IF(JumpIfGrtText, text(T(pc->b)) > text(T(pc->c)))
+  CASE(Call) {
+    const BytecodeFunction &callee = this->m_Bytecode.functions[pc->b];
+    if (this->m_Calls.size() == MAX_DEPTH) {
+      throw std::runtime_error("call stack overflow in " + callee.name);
+    }
+    this->m_Calls.push_back(Return{pc + 1, frame, pc->a});
+
+    // the callee's frame starts where the caller put the arguments, and
+    // has room for the arguments of its own calls after it
+    frame += pc->c;
+    std::size_t needed = frame + callee.frame_size + Bytecode::ARGUMENTS;
+    if (needed > this->m_Stack.size()) {
+      this->m_Stack.resize(std::max(needed, 2 * this->m_Stack.size()));
+    }
+    bases[0] = this->m_Stack.data() + frame;
+    std::copy(callee.initial.begin(), callee.initial.end(),
+              bases[0] + callee.params);
+    pc = code + callee.entry;
+    DISPATCH();
+  }
+  CASE(TailCall) {
+    // the callee takes over the current frame and return address
+    const BytecodeFunction &callee = this->m_Bytecode.functions[pc->b];
+    BytecodeValue *arguments = bases[0] + pc->c;
+    std::copy(arguments, arguments + callee.params, bases[0]);
+    std::size_t needed = frame + callee.frame_size + Bytecode::ARGUMENTS;
+    if (needed > this->m_Stack.size()) {
+      this->m_Stack.resize(std::max(needed, 2 * this->m_Stack.size()));
+      bases[0] = this->m_Stack.data() + frame;
+    }
+    std::copy(callee.initial.begin(), callee.initial.end(),
+              bases[0] + callee.params);
+    pc = code + callee.entry;
+    DISPATCH();
+  }
+  CASE(Return) {
+    if (this->m_Calls.empty()) {
+      goto halt;
+    }
+    BytecodeValue result =
+        pc->a == Bytecode::NONE ? BytecodeValue{} : R(pc->a);
+    Return back = this->m_Calls.back();
+    this->m_Calls.pop_back();
+    frame = back.frame;
+    bases[0] = this->m_Stack.data() + frame;
+    if (back.dst != Bytecode::NONE) {
+      R(back.dst) = result;
+    }
+    pc = back.pc;
+    DISPATCH();
+  }
+  CASE(Print) {
+    this->m_Out << format_number(N(pc->b)) << '\n';
+    NEXT();
+  }
+  CASE(PrintText) {
+    this->m_Out << text(T(pc->b)) << '\n';
+    NEXT();
+  }
+  CASE(Halt) {
+    goto halt;
+  }
+#ifndef SPL_VM_THREADED
+  }
+#endif
+
+halt:
+  this->m_Executed += executed;
+  this->m_Out.flush();
+
+#undef R
+#undef N
+#undef T
+#undef DISPATCH
+#undef CASE
+#undef NEXT
+#undef BINARY
+#undef JUMP_IF
+}
@@ -0,0 +1,267 @@
+#include "corpus.h"
+#include <cfg.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <optimizer.h>
+#include <ssa.h>
+
+namespace {
+
+const char *BRANCHY =
+    "main num V_x, begin V_x <input; if grt(V_x, 1) then begin V_x = 1; end "
+    "else begin V_x = 2; end; print V_x; end";
+
+// every operand is assigned at most once, and every use of an operand
+// assigned in the function is dominated by the assignment
+void expect_ssa(const IMCProgram &program, const CFG &cfg) {
+  std::map<OperandId, std::pair<uint32_t, std::size_t>> definitions;
+  auto define = [&](OperandId operand, uint32_t block, std::size_t index) {
+    if (IMCOperand::kind(operand) != IMCOperand::Kind::Temp) {
+      return;
+    }
+    bool fresh = definitions.emplace(operand, std::pair(block, index)).second;
+    EXPECT_TRUE(fresh) << program.operand_string(operand)
+                       << " is assigned twice";
+  };
+
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+  for (uint32_t block : cfg.reverse_postorder()) {
+    for (const Phi &phi : blocks[block].phis) {
+      define(phi.dst, block, 0);
+    }
+    for (std::size_t i = 0; i < blocks[block].code.size(); i++) {
+      const IMCInstruction &instruction = blocks[block].code[i];
+      if (writes_dst(instruction.opcode)) {
+        define(instruction.dst, block, i + 1);
+      }
+    }
+  }
+
+  auto use = [&](OperandId operand, uint32_t block, std::size_t index) {
+    auto definition = definitions.find(operand);
+    if (definition == definitions.end()) {
+      return;
+    }
+    auto [defining, position] = definition->second;
+    EXPECT_TRUE(defining == block ? position <= index
+                                  : cfg.dominates(defining, block))
+        << program.operand_string(operand) << " is used before it is set";
+  };
+  for (uint32_t block : cfg.reverse_postorder()) {
+    for (std::size_t i = 0; i < blocks[block].code.size(); i++) {
+      const IMCInstruction &instruction = blocks[block].code[i];
+      int sources = source_count(instruction.opcode);
+      if (sources > 0) {
+        use(instruction.src1, block, i);
+      }
+      if (sources > 1) {
+        use(instruction.src2, block, i);
+      }
+    }
+    // a phi argument is used at the end of its predecessor
+    for (uint32_t successor : blocks[block].successors) {
+      const BasicBlock &next = blocks[successor];
+      for (std::size_t j = 0; j < next.predecessors.size(); j++) {
+        if (next.predecessors[j] == block) {
+          for (const Phi &phi : next.phis) {
+            use(phi.args[j], block, blocks[block].code.size());
+          }
+        }
+      }
+    }
+  }
+}
+
+// every jump goes to a label that is defined exactly once
+void expect_linear(const IMCFunction &function) {
+  std::map<uint32_t, int> labels;
+  for (const IMCInstruction &instruction : function.code) {
+    if (instruction.opcode == IMCOpcode::Label) {
+      labels[instruction.dst]++;
+    }
+  }
+  for (const IMCInstruction &instruction : function.code) {
+    if (is_jump(instruction.opcode)) {
+      EXPECT_EQ(labels[instruction.dst], 1)
+          << "L" << instruction.dst + 1 << " in " << function.name;
+    }
+  }
+}
+
+} // namespace
+
+TEST(CFGTest, SplitsAtLabelsAndJumps) {
+  IMCProgram program = generate(BRANCHY);
+  CFG cfg(program.functions[0]);
+
+  // B0 tests and jumps to B2 or falls through to B1, which only jumps on
+  // to the else arm B3; both arms meet in B4
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+  ASSERT_EQ(blocks.size(), 5u);
+  EXPECT_EQ(blocks[0].successors, (std::vector<uint32_t>{2, 1}));
+  EXPECT_EQ(blocks[1].successors, (std::vector<uint32_t>{3}));
+  EXPECT_EQ(blocks[2].successors, (std::vector<uint32_t>{4}));
+  EXPECT_EQ(blocks[3].successors, (std::vector<uint32_t>{4}));
+  EXPECT_TRUE(blocks[4].successors.empty());
+  EXPECT_EQ(blocks[4].predecessors, (std::vector<uint32_t>{2, 3}));
+  EXPECT_EQ(blocks[4].code.back().opcode, IMCOpcode::Halt);
+}
+
+TEST(CFGTest, ComputesDominatorsAndFrontiers) {
+  IMCProgram program = generate(BRANCHY);
+  CFG cfg(program.functions[0]);
+  cfg.compute_dominators();
+
+  EXPECT_EQ(cfg.idom(0), 0u);
+  EXPECT_EQ(cfg.idom(1), 0u);
+  EXPECT_EQ(cfg.idom(2), 0u);
+  EXPECT_EQ(cfg.idom(3), 1u);
+  EXPECT_EQ(cfg.idom(4), 0u);
+  EXPECT_TRUE(cfg.dominates(1, 3));
+  EXPECT_FALSE(cfg.dominates(2, 4));
+
+  std::vector<std::vector<uint32_t>> frontiers = cfg.dominance_frontiers();
+  EXPECT_TRUE(frontiers[0].empty());
+  EXPECT_EQ(frontiers[2], (std::vector<uint32_t>{4}));
+  EXPECT_EQ(frontiers[3], (std::vector<uint32_t>{4}));
+}
+
+TEST(CFGTest, LeavesUnreachableBlocksWithoutDominator) {
+  IMCProgram program =
+      generate("main num V_x, begin halt; V_x = 1; print V_x; end");
+  CFG cfg(program.functions[0]);
+  cfg.compute_dominators();
+
+  ASSERT_EQ(cfg.blocks().size(), 2u);
+  EXPECT_TRUE(cfg.reachable(0));
+  EXPECT_FALSE(cfg.reachable(1));
+  EXPECT_EQ(cfg.reverse_postorder(), (std::vector<uint32_t>{0}));
+}
+
+TEST(CFGTest, KeepsTheEntryOutOfLoops) {
+  // the loop F_f becomes jumps back to its first label, which must not
+  // name the entry block
+  IMCProgram program = generate(
+      "main num V_n, begin V_n = F_f(V_n, V_n, V_n); end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "    V_b = F_f(V_a, V_a, V_a); return V_b; end\n"
+      "  else begin return V_n; end; end } end\n");
+  CFG cfg(program.functions[1]);
+
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+  EXPECT_EQ(blocks[0].label, CFG::NONE);
+  EXPECT_TRUE(blocks[0].code.empty());
+  EXPECT_TRUE(blocks[0].predecessors.empty());
+  EXPECT_EQ(blocks[0].successors, (std::vector<uint32_t>{1}));
+  EXPECT_EQ(blocks[1].predecessors.size(), 2u);
+}
+
+TEST(SSATest, PlacesPhiWhereAssignmentsMeet) {
+  IMCProgram program = generate(BRANCHY);
+  CFG cfg(program.functions[0]);
+  cfg.compute_dominators();
+  SSABuilder ssa(program);
+  ASSERT_TRUE(ssa.renamable(0, program.globals[0]));
+  ssa.construct(cfg, 0);
+
+  const std::vector<BasicBlock> &blocks = cfg.blocks();
+  ASSERT_EQ(blocks[4].phis.size(), 1u);
+  const Phi &phi = blocks[4].phis[0];
+  EXPECT_EQ(phi.variable, program.globals[0]);
+  EXPECT_EQ(phi.args[0], blocks[2].code[0].dst);
+  EXPECT_EQ(phi.args[1], blocks[3].code[0].dst);
+  EXPECT_EQ(blocks[4].code[0].src1, phi.dst); // PRINT reads the merge
+  for (const BasicBlock &block : blocks) {
+    if (&block != &blocks[4]) {
+      EXPECT_TRUE(block.phis.empty());
+    }
+  }
+  expect_ssa(program, cfg);
+}
+
+TEST(SSATest, KeepsVariablesSharedWithCalls) {
+  IMCProgram program = generate(
+      "main num V_x, num V_y, begin V_x = 1; V_y = F_f(V_x, 1, 2); "
+      "V_x = 2; print V_y; end\n"
+      "num F_f(V_x, V_x, V_x) { num V_c, num V_d, num V_e, begin\n"
+      "  V_c = add(V_x, V_y); return V_c; end } end\n");
+  SSABuilder ssa(program);
+
+  // F_f reads the global V_y but has a V_x of its own
+  EXPECT_TRUE(ssa.renamable(0, program.globals[0]));
+  EXPECT_FALSE(ssa.renamable(0, program.globals[1]));
+  EXPECT_FALSE(ssa.renamable(1, program.globals[1]));
+  EXPECT_TRUE(ssa.renamable(1, program.functions[1].locals[0]));
+  EXPECT_FALSE(ssa.renamable(0, program.functions[1].locals[0]));
+}
+
+TEST(SSATest, KeepsGlobalsOnlyOneFunctionMentions) {
+  // the recursive call between F_f's write to V_g and its read sets V_g
+  // again, so each level returns the innermost one's 0
+  IMCProgram program = generate(
+      "main num V_n, num V_g, begin V_n = F_f(3, 3, 3); print V_n; end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = V_n; if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "  V_b = F_f(V_a, V_a, V_a); end else begin skip; end; return V_g; end }"
+      " end\n");
+  SSABuilder ssa(program);
+  EXPECT_FALSE(ssa.renamable(1, program.globals[1]));
+  EXPECT_EQ(run(program), "0\n");
+  optimize(program);
+  EXPECT_EQ(run(program), "0\n");
+}
+
+TEST(SSATest, RoundTripsTheSampleCorpus) {
+  std::size_t translated = 0;
+  for (const std::string &source : corpus_programs()) {
+    std::optional<IMCProgram> program = corpus_imc(source);
+    if (!program) {
+      continue;
+    }
+    translated++;
+
+    SSABuilder ssa(*program);
+    for (std::size_t i = 0; i < program->functions.size(); i++) {
+      CFG cfg(program->functions[i]);
+      cfg.compute_dominators();
+      for (uint32_t block : cfg.reverse_postorder()) {
+        EXPECT_TRUE(cfg.dominates(0, block));
+        EXPECT_TRUE(cfg.dominates(cfg.idom(block), block));
+      }
+
+      ssa.construct(cfg, i);
+      expect_ssa(*program, cfg);
+
+      ssa.destruct(cfg, i);
+      cfg.flatten(program->functions[i]);
+      expect_linear(program->functions[i]);
+      for (const BasicBlock &block : cfg.blocks()) {
+        EXPECT_TRUE(block.phis.empty());
+      }
+    }
+  }
+  EXPECT_GE(translated, CORPUS_WELL_TYPED);
+}
+
+TEST(SSATest, CopiesPhiArgumentsOnIncomingEdges) {
+  IMCProgram program = generate(BRANCHY);
+  IMCFunction &main = program.functions[0];
+  CFG cfg(main);
+  cfg.compute_dominators();
+  SSABuilder ssa(program);
+  ssa.construct(cfg, 0);
+  ssa.destruct(cfg, 0);
+  cfg.flatten(main);
+
+  std::vector<std::string> lines;
+  for (const IMCInstruction &instruction : main.code) {
+    lines.push_back(program.instruction_string(instruction));
+  }
+  EXPECT_EQ(lines, (std::vector<std::string>{
+                       "t1 := INPUT", "IF t1 > 1 GOTO L1", "GOTO L2",
+                       "LABEL L1", "t3 := 1", "t2 := t3", "GOTO L3",
+                       "LABEL L2", "t4 := 2", "t2 := t4", "LABEL L3",
+                       "PRINT t2", "STOP"}));
+  expect_linear(main);
+}
@@ -0,0 +1,219 @@
+#include "corpus.h"
+#include <bytecode.h>
+#include <codegen.h>
+#include <cstdlib>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <optimizer.h>
+#include <regalloc.h>
+#include <unistd.h>
+#include <vm.h>
+
+namespace {
+
+// a directory that is removed with everything in it when it goes out of
+// scope
+struct ScratchDirectory {
+  std::filesystem::path path;
+
+  explicit ScratchDirectory(std::filesystem::path path)
+      : path(std::move(path)) {
+    std::filesystem::create_directories(this->path);
+  }
+  ~ScratchDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(this->path, error);
+  }
+  ScratchDirectory(const ScratchDirectory &) = delete;
+  ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+};
+
+// builds the source with the C compiler, runs it and gives what it
+// prints; nothing if it does not build or exits with a failure
+std::optional<std::string> execute(const std::string &source,
+                                   const char *extension,
+                                   const std::string &input) {
+  static int count = 0;
+  ScratchDirectory dir(std::filesystem::temp_directory_path() /
+                       ("splc_codegen_" + std::to_string(getpid()) + "_" +
+                        std::to_string(count++)));
+  std::string stem = (dir.path / "p").string();
+  auto write = [](const std::string &path, const std::string &text) {
+    std::ofstream(path) << text;
+  };
+
+  // sibling calls, which tail calls in C rely on without musttail, need
+  // optimization
+  std::string command = std::string(SPL_CC) + " -O2 -o " + stem + " " +
+                        stem + extension;
+  write(stem + extension, source);
+  if (std::string(extension) == ".s") {
+    write(stem + "_runtime.c", emit_runtime());
+    command += " " + stem + "_runtime.c";
+  }
+  write(stem + ".in", input);
+  if (std::system((command + " -lm").c_str()) != 0) {
+    ADD_FAILURE() << "failed to build\n" << source;
+    return std::nullopt;
+  }
+  if (std::system((stem + " < " + stem + ".in > " + stem + ".out 2>&1")
+                      .c_str()) != 0) {
+    return std::nullopt;
+  }
+  std::ifstream file(stem + ".out");
+  std::stringstream output;
+  output << file.rdbuf();
+  return output.str();
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+const bool NATIVE_ASM = true;
+#else
+const bool NATIVE_ASM = false;
+#endif
+
+// the program prints the same under the VM and built by each backend,
+// with and without optimization; failures under the VM must fail natively
+void expect_same_output(const std::string &source, const std::string &input) {
+  for (bool optimized : {false, true}) {
+    std::optional<IMCProgram> program = corpus_imc(source);
+    ASSERT_TRUE(program) << source;
+    if (optimized) {
+      optimize(*program);
+    }
+
+    std::optional<std::string> expected;
+    try {
+      expected = run(*program, input);
+    } catch (const std::runtime_error &) {
+    }
+    EXPECT_EQ(execute(emit_c(*program), ".c", input), expected) << source;
+    if (NATIVE_ASM) {
+      EXPECT_EQ(execute(emit_asm(*program), ".s", input), expected) << source;
+    }
+  }
+}
+
+} // namespace
+
+TEST(RegisterAllocationTest, SharesRegistersBetweenDisjointTemporaries) {
+  std::optional<IMCProgram> program =
+      corpus_imc("main num V_x, begin V_x = add(mul(V_x, 2), mul(V_x, 3)); "
+                 "V_x = add(mul(V_x, 4), mul(V_x, 5)); print V_x; end");
+  ASSERT_TRUE(program);
+  const IMCFunction &main = program->functions[0];
+  RegisterAllocation allocation = allocate_registers(main, 8);
+
+  // at most two products are live at once, and the sums end where the
+  // products they read end
+  EXPECT_EQ(allocation.used, 2u);
+  EXPECT_EQ(allocation.spilled, 0u);
+  for (uint32_t reg : allocation.registers) {
+    EXPECT_LT(reg, 2u);
+  }
+}
+
+TEST(RegisterAllocationTest, SpillsWhenRegistersRunOut) {
+  std::optional<IMCProgram> program =
+      corpus_imc("main num V_x, begin V_x = add(mul(V_x, 2), mul(V_x, 3)); "
+                 "print V_x; end");
+  ASSERT_TRUE(program);
+  const IMCFunction &main = program->functions[0];
+
+  RegisterAllocation one = allocate_registers(main, 1);
+  EXPECT_EQ(one.used, 1u);
+  EXPECT_EQ(one.spilled, 1u);
+
+  RegisterAllocation none = allocate_registers(main, 0);
+  EXPECT_EQ(none.used, 0u);
+  EXPECT_EQ(none.spilled, main.temps.size());
+  for (uint32_t reg : none.registers) {
+    EXPECT_EQ(reg, RegisterAllocation::SPILLED);
+  }
+}
+
+TEST(CodegenTest, RecursesLikeTheVM) {
+  expect_same_output(FIBONACCI, "15");
+}
+
+TEST(CodegenTest, ComputesLikeTheVM) {
+  expect_same_output(MIXED, "15");
+  expect_same_output(MIXED, "5");
+}
+
+TEST(CodegenTest, JumpsForTailCalls) {
+  std::optional<IMCProgram> program = corpus_imc(EVEN_ODD);
+  ASSERT_TRUE(program);
+  EXPECT_EQ(run(*program, "3000001"), "0\n");
+  expect_same_output(EVEN_ODD, "3000001");
+}
+
+TEST(CodegenTest, ReturnsZeroWithoutAReturnValue) {
+  expect_same_output(
+      "main num V_x, begin V_x = 5; V_x = F_f(1, 2, 3); print V_x; end\n"
+      "num F_f(V_x, V_x, V_x) { num V_a, num V_b, num V_c, begin "
+      "V_a = 3; print V_a; end } end\n",
+      "");
+}
+
+TEST(CodegenTest, RefusesLogicOnText) {
+  // the type checker never lets this through, so make V_x text afterwards
+  std::optional<IMCProgram> program = corpus_imc(
+      "main num V_x, num V_y, begin V_y = and(V_x, V_x); print V_y; end");
+  ASSERT_TRUE(program);
+  program->variables[0].type = TypeId::Text;
+  EXPECT_THROW(emit_c(*program), std::logic_error);
+  EXPECT_THROW(emit_asm(*program), std::logic_error);
+}
+
+TEST(CodegenTest, ReturnsFromMainAfterACall) {
+  // main returns nothing, so its last call is no tail call
+  const char *source =
+      "main num V_x, num V_y, begin V_x <input; V_y = F_f(V_x, V_x, V_x); "
+      "return V_y; end\n"
+      "num F_f(V_x, V_x, V_x) { num V_a, num V_b, num V_c, begin "
+      "V_a = add(V_x, 1); return V_a; end } end\n";
+  std::optional<IMCProgram> program = corpus_imc(source);
+  ASSERT_TRUE(program);
+  EXPECT_EQ(emit_c(*program).find("return spl_f"), std::string::npos);
+  expect_same_output(source, "4");
+}
+
+TEST(CodegenTest, KeepsGlobalsOnlyAFunctionMentions) {
+  // main never touches V_g, so it is static however few functions do
+  const char *twice =
+      "main num V_n, num V_g, begin V_n = F_f(V_n, V_n, V_n); "
+      "V_n = F_f(V_n, V_n, V_n); print V_n; end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, 1); return V_g; end } end\n";
+  const char *recursive =
+      "main num V_n, num V_g, begin V_n = F_r(3, 3, 3); print V_n; end\n"
+      "num F_r(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, 1); if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "  V_b = F_r(V_a, V_a, V_a); end else begin skip; end; return V_g; end }"
+      " end\n";
+  std::optional<IMCProgram> program = corpus_imc(twice);
+  ASSERT_TRUE(program);
+  EXPECT_EQ(run(*program), "2\n");
+  expect_same_output(twice, "");
+  program = corpus_imc(recursive);
+  ASSERT_TRUE(program);
+  EXPECT_EQ(run(*program), "4\n");
+  expect_same_output(recursive, "");
+}
+
+TEST(CodegenTest, RejectsInputThatIsNotANumber) {
+  expect_same_output("main num V_x, begin V_x <input; print V_x; end",
+                     "Hello");
+}
+
+TEST(CodegenTest, BuildsTheSampleCorpus) {
+  std::size_t translated = 0;
+  for (const std::string &source : corpus_programs()) {
+    if (corpus_imc(source)) {
+      translated++;
+      expect_same_output(source, "3 4 5 6 7 8");
+    }
+  }
+  EXPECT_GE(translated, CORPUS_WELL_TYPED);
+}
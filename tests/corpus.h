@@ -0,0 +1,102 @@
+#ifndef SPL_TESTS_CORPUS_H
+#define SPL_TESTS_CORPUS_H
+
+#include "samples.h"
+#include <bytecode.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <imc.h>
+#include <lexer.h>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <typechecker.h>
+#include <vector>
+#include <vm.h>
+
+// The sample programs in the source tree: prog.txt, and each program of
+// typecheck_programs.txt, which starts at a line beginning with `main` and
+// may be preceded by // comments; then the programs of samples.h.
+inline std::vector<std::string> corpus_programs() {
+  auto read = [](const std::string &name) {
+    std::ifstream file(std::string(SPL_SOURCE_DIR) + "/" + name);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+  };
+
+  std::vector<std::string> programs = {read("prog.txt")};
+  std::istringstream lines(read("typecheck_programs.txt"));
+  std::string line;
+  while (std::getline(lines, line)) {
+    line = line.substr(0, line.find("//"));
+    if (line.rfind("main", 0) == 0) {
+      programs.emplace_back();
+    }
+    if (programs.size() > 1) {
+      programs.back() += line + "\n";
+    }
+  }
+  programs.insert(programs.end(), {FIBONACCI, MIXED, EVEN_ODD, NESTED});
+  return programs;
+}
+
+// how many of corpus_programs() type-check: the second program of
+// typecheck_programs.txt and those of samples.h. Loops over the corpus
+// expect to translate at least this many, so a generator that fails on
+// them cannot pass by skipping them.
+constexpr std::size_t CORPUS_WELL_TYPED = 5;
+
+// Intermediate code for a program, or nothing if it does not parse or
+// type-check. A well-typed program the generator cannot translate is a
+// test failure.
+inline std::optional<IMCProgram> corpus_imc(const std::string &program) {
+  testing::internal::CaptureStderr();
+  Lexer lexer(program);
+  Parser parser(lexer);
+  parser.setPrintTree(false);
+  auto tree = parser.parse();
+  testing::internal::GetCapturedStderr();
+  if (!tree || !TypeChecker(tree->getRoot()).check().ok()) {
+    return std::nullopt;
+  }
+  try {
+    return IMCGenerator(tree->getRoot()).generate();
+  } catch (const std::logic_error &error) {
+    ADD_FAILURE() << "failed to translate " << program << ": "
+                  << error.what();
+    return std::nullopt;
+  }
+}
+
+// intermediate code for a program the test expects to be well typed
+inline IMCProgram generate(const char *program) {
+  std::optional<IMCProgram> imc = corpus_imc(program);
+  if (!imc) {
+    ADD_FAILURE() << "failed to translate " << program;
+    return {};
+  }
+  return std::move(*imc);
+}
+
+// the code of one function, as --emit=imc prints it
+inline std::vector<std::string> lines(const IMCProgram &program,
+                                      std::size_t fn) {
+  std::vector<std::string> result;
+  for (const IMCInstruction &instruction : program.functions[fn].code) {
+    result.push_back(program.instruction_string(instruction));
+  }
+  return result;
+}
+
+// what a program prints on the VM, given its input
+inline std::string run(const IMCProgram &program,
+                       const std::string &input = "") {
+  Bytecode bytecode = compile_bytecode(program);
+  std::istringstream in(input);
+  std::ostringstream out;
+  VM(bytecode, in, out).run();
+  return out.str();
+}
+
+#endif
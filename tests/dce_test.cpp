@@ -0,0 +1,138 @@
+#include "corpus.h"
+#include <algorithm>
+#include <bytecode.h>
+#include <dce.h>
+#include <gtest/gtest.h>
+#include <optimizer.h>
+#include <vm.h>
+
+namespace {
+
+// F_f is recursive, so it stays a call; it computes V_e and, on one path,
+// V_d without ever reading them, and F_g is never called at all
+const char *UNUSED =
+    "main num V_x, num V_y, num V_z, begin V_x <input; V_y = add(V_x, 1); "
+    "V_z = F_f(V_x, V_x, V_x); print V_z; end\n"
+    "num F_f(V_x, V_y, V_z) { num V_d, num V_e, num V_f, begin\n"
+    "  V_d = mul(V_x, 2); V_e = sqrt(V_x);\n"
+    "  if grt(V_x, 5) then begin V_f = sub(V_x, 1); V_f = F_f(V_f, V_x, V_x);"
+    "  V_d = add(V_f, V_d); end else begin V_d = V_x; end; return V_d; end }\n"
+    "end\n"
+    "num F_g(V_x, V_y, V_z) { num V_d, num V_e, num V_f, begin\n"
+    "  return V_x; end } end\n";
+
+} // namespace
+
+TEST(DeadCodeTest, RemovesStoresNothingReads) {
+  IMCProgram program = generate(UNUSED);
+  std::string expected = run(program, "7");
+  OptimizationReport report = optimize(program);
+
+  // V_y in main and V_e in F_f
+  EXPECT_EQ(report.dead.stores, 2u);
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"t1 := INPUT", "ARG t1", "ARG t1",
+                                      "ARG t1", "t2 := CALL F_f", "PRINT t2",
+                                      "STOP"}));
+  std::vector<std::string> code = lines(program, 1);
+  auto root = [](const std::string &line) {
+    return line.find("SQRT") != std::string::npos;
+  };
+  EXPECT_TRUE(std::none_of(code.begin(), code.end(), root));
+  EXPECT_EQ(run(program, "7"), expected);
+  EXPECT_EQ(expected, "31\n");
+}
+
+TEST(DeadCodeTest, DropsFunctionsMainNeverCalls) {
+  IMCProgram program = generate(UNUSED);
+  OptimizationReport report = optimize(program);
+
+  EXPECT_EQ(report.dead.functions, 1u);
+  ASSERT_EQ(program.functions.size(), 2u);
+  EXPECT_EQ(program.functions[1].name, "F_f");
+  EXPECT_EQ(run(program, "3"), "3\n");
+}
+
+TEST(DeadCodeTest, ShrinksFrames) {
+  IMCProgram program = generate(UNUSED);
+  Bytecode before = compile_bytecode(program);
+  OptimizationReport report = optimize(program);
+  Bytecode after = compile_bytecode(program);
+
+  // main's three globals and F_f's three locals all became temporaries
+  // or went away, so the frames hold the parameters and the temporaries
+  // still in use and nothing else
+  EXPECT_EQ(report.dead.variables, 6u);
+  EXPECT_TRUE(program.globals.empty());
+  EXPECT_TRUE(program.functions[1].locals.empty());
+  EXPECT_GT(report.dead.temps, 0u);
+  EXPECT_LT(after.functions[0].frame_size, before.functions[0].frame_size);
+  EXPECT_EQ(after.functions[0].frame_size, 2u);
+  EXPECT_EQ(after.functions[1].frame_size,
+            3u + program.functions[1].temps.size());
+}
+
+TEST(DeadCodeTest, RemovesCodeAfterHalt) {
+  IMCProgram program = generate(
+      "main num V_x, begin V_x <input; halt; V_x = add(V_x, 1); print V_x; "
+      "end");
+  optimize(program);
+
+  // the input is still consumed, though nothing reads it
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"t1 := INPUT", "STOP"}));
+}
+
+TEST(DeadCodeTest, KeepsStoresToSharedVariables) {
+  // F_f's store to V_y is read by main after the call
+  IMCProgram program = generate(
+      "main num V_y, num V_z, begin V_z = F_f(V_z, V_z, V_z); print V_y; "
+      "end\n"
+      "num F_f(V_z, V_z, V_z) { num V_c, num V_d, num V_e, begin\n"
+      "  V_y = 3; if grt(V_z, 0) then begin V_z = sub(V_z, 1);\n"
+      "  V_c = F_f(V_z, V_z, V_z); end else begin skip; end; return V_z; "
+      "end } end\n");
+  optimize(program);
+
+  std::vector<std::string> code = lines(program, 1);
+  EXPECT_NE(std::find(code.begin(), code.end(), "v1 := 3"), code.end());
+  EXPECT_EQ(run(program, ""), "3\n");
+}
+
+TEST(DeadCodeTest, KeepsStoresToGlobalsOnlyOneFunctionMentions) {
+  // F_f's next call reads the V_g it increments, though main never does
+  const char *source =
+      "main num V_n, num V_g, begin V_n = F_f(V_n, V_n, V_n); "
+      "V_n = F_f(V_n, V_n, V_n); V_n = F_f(V_n, V_n, V_n); end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin "
+      "print V_g; V_g = add(V_g, 1); return 0; end } end\n";
+  IMCProgram program = generate(source);
+  CFG cfg(program.functions[1]);
+  EXPECT_EQ(remove_dead_stores(program, program.owners(), cfg, 1), 0u);
+
+  program = generate(source);
+  optimize(program);
+  EXPECT_EQ(run(program, ""), "0\n1\n2\n");
+}
+
+TEST(DeadCodeTest, RenumbersCallsInTheCorpus) {
+  std::size_t translated = 0;
+  for (const std::string &source : corpus_programs()) {
+    std::optional<IMCProgram> program = corpus_imc(source);
+    if (!program) {
+      continue;
+    }
+    translated++;
+    std::size_t before = program->functions.size();
+    DeadCodeReport report = optimize(*program).dead;
+    EXPECT_EQ(program->functions.size() + report.functions, before);
+    for (const IMCFunction &function : program->functions) {
+      for (const IMCInstruction &instruction : function.code) {
+        if (instruction.opcode == IMCOpcode::Call) {
+          EXPECT_LT(instruction.src1, program->functions.size());
+        }
+      }
+    }
+  }
+  EXPECT_GE(translated, CORPUS_WELL_TYPED);
+}
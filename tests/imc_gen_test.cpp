@@ -1,49 +1,162 @@
-#include "imc.h"
+#include "corpus.h"
+#include <algorithm>
 #include <gtest/gtest.h>
+#include <imc.h>
 
-TEST(IMCVariable, TestText) {
-  IMCVariable var = IMCVariable::make_variable("v1", "Hello World!");
+TEST(IMCConstantPool, InternsEachValueOnce) {
+  IMCConstantPool pool;
+  uint32_t number = pool.intern_number(42);
+  uint32_t text = pool.intern_text("Hello");
 
-  const char *t = var.get_text();
-  IMCVariable::VariableType ty = var.get_type();
-  ASSERT_STREQ(t, "Hello World!");
-  ASSERT_EQ(ty, IMCVariable::VariableType::Text);
-  ASSERT_ANY_THROW([[maybe_unused]] int64_t _ = var.get_number());
+  EXPECT_EQ(pool.intern_number(42.0), number);
+  EXPECT_EQ(pool.intern_text("Hello"), text);
+  EXPECT_NE(pool.intern_number(0.5), number);
+  ASSERT_EQ(pool.size(), 3u);
+
+  EXPECT_EQ(pool.get(number).type, TypeId::Num);
+  EXPECT_EQ(pool.get(number).number, 42);
+  EXPECT_EQ(pool.get(text).type, TypeId::Text);
+  EXPECT_EQ(pool.get(text).text, Interner::global().intern("Hello"));
+}
+
+TEST(IMCInstruction, IsFlat) {
+  static_assert(sizeof(IMCInstruction) == 16);
+  static_assert(std::is_trivially_copyable_v<IMCInstruction>);
+  static_assert(!std::is_copy_constructible_v<IMCFunction>);
+  static_assert(std::is_nothrow_move_constructible_v<IMCFunction>);
+
+  OperandId temp = IMCOperand::temp(7);
+  EXPECT_EQ(IMCOperand::kind(temp), IMCOperand::Kind::Temp);
+  EXPECT_EQ(IMCOperand::index(temp), 7u);
+  EXPECT_EQ(IMCOperand::kind(IMCOperand::constant(3)),
+            IMCOperand::Kind::Constant);
+  EXPECT_EQ(IMCOperand::kind(IMCOperand::variable(3)),
+            IMCOperand::Kind::Variable);
+  EXPECT_EQ(IMCOperand::kind(IMCOperand::NONE), IMCOperand::Kind::None);
+}
+
+TEST(IMCGenerator, TranslatesAssignmentsAndOperations) {
+  IMCProgram program =
+      generate("main num V_x, text V_t, begin V_x = add(mul(V_x, 2), 0.5); "
+               "V_t = \"Hi\"; V_x <input; print V_t; halt; end");
+
+  ASSERT_EQ(program.globals, (std::vector<OperandId>{0, 1}));
+  EXPECT_EQ(program.variables[1].type, TypeId::Text);
+  ASSERT_EQ(program.functions.size(), 1u);
+  EXPECT_EQ(program.functions[0].name, "main");
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"t1 := v1 * 2", "v1 := t1 + 0.5",
+                                      "v2 := \"Hi\"", "v1 := INPUT",
+                                      "PRINT v2", "STOP", "STOP"}));
+}
+
+TEST(IMCGenerator, ShortCircuitsCompositeConditions) {
+  IMCProgram program =
+      generate("main num V_x, begin if or(grt(V_x, 1), eq(V_x, 0)) "
+               "then begin V_x = 1; end else begin V_x = 2; end; end");
+
+  // the second test is skipped once the first one holds
+  ASSERT_EQ(program.functions.size(), 1u);
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"IF v1 > 1 GOTO L1", "GOTO L4",
+                                      "LABEL L4", "IF v1 = 0 GOTO L1",
+                                      "GOTO L2", "LABEL L1", "v1 := 1",
+                                      "GOTO L3", "LABEL L2", "v1 := 2",
+                                      "LABEL L3", "STOP"}));
 }
 
-TEST(IMCVariable, TestNumber) {
-  IMCVariable var = IMCVariable::make_variable("v1", 42);
+TEST(IMCGenerator, TranslatesFunctionsWithFreshPlaces) {
+  IMCProgram program = generate(
+      "main num V_a, num V_b, begin V_a = F_f(V_a, 1, 2); F_g(1, 2, 3); end\n"
+      "num F_f(V_a, V_b, V_b) { num V_c, num V_d, num V_e, begin\n"
+      "  V_c = add(V_a, V_b); return V_c; end } end\n"
+      "void F_g(V_a, V_b, V_b) { num V_c, num V_d, num V_e, begin\n"
+      "  print V_a; end } end\n");
+
+  ASSERT_EQ(program.functions.size(), 3u);
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"ARG v1", "ARG 1", "ARG 2",
+                                      "v1 := CALL F_f", "ARG 1", "ARG 2",
+                                      "ARG 3", "CALL F_g", "STOP"}));
+
+  const IMCFunction &f = program.functions[1];
+  EXPECT_EQ(f.name, "F_f");
+  EXPECT_EQ(f.params, (std::vector<OperandId>{2, 3, 4}));
+  EXPECT_EQ(f.locals, (std::vector<OperandId>{5, 6, 7}));
+  EXPECT_EQ(f.return_type, TypeId::Num);
+  // the parameter declared last is the one a name refers to
+  EXPECT_EQ(lines(program, 1),
+            (std::vector<std::string>{"v6 := v3 + v5", "RETURN v6"}));
 
-  int64_t n = var.get_number();
-  IMCVariable::VariableType ty = var.get_type();
-  ASSERT_EQ(n, 42);
-  ASSERT_EQ(ty, IMCVariable::VariableType::Number);
-  ASSERT_ANY_THROW([[maybe_unused]] const char *_ = var.get_text());
+  // a function that runs off its end returns
+  EXPECT_EQ(lines(program, 2),
+            (std::vector<std::string>{"PRINT v9", "RETURN"}));
 }
 
-TEST(IMCStatement, TestNumber) {
-  IMCStatement stat = IMCStatement::create_value(42);
-  ASSERT_EQ(stat.get_type(), IMCStatement::StatementType::NumberValue);
-  ASSERT_EQ(stat.get_number(), 42);
-  ASSERT_ANY_THROW(stat.get_text());
-  ASSERT_ANY_THROW(stat.get_lhs_id());
-  ASSERT_ANY_THROW(stat.get_rhs());
+TEST(IMCGenerator, NegatesConditionsBySwappingTargets) {
+  IMCProgram program = generate("main num V_x, begin if not(grt(V_x, 1)) "
+                                "then begin skip; end else begin halt; end; "
+                                "end");
+
+  ASSERT_EQ(program.functions.size(), 1u);
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"IF v1 > 1 GOTO L2", "GOTO L1",
+                                      "LABEL L1", "GOTO L3", "LABEL L2",
+                                      "STOP", "LABEL L3", "STOP"}));
 }
 
-TEST(IMCStatement, TestText) {
-  IMCStatement stat = IMCStatement::create_value("Hello World!");
-  ASSERT_EQ(stat.get_type(), IMCStatement::StatementType::TextValue);
-  ASSERT_EQ(stat.get_text(), "Hello World!");
-  ASSERT_ANY_THROW(stat.get_number());
-  ASSERT_ANY_THROW(stat.get_lhs_id());
-  ASSERT_ANY_THROW(stat.get_rhs());
+TEST(IMCGenerator, TurnsSelfTailCallsIntoJumps) {
+  IMCProgram program = generate(
+      "main num V_n, num V_r, begin V_r = F_f(V_n, V_n, V_n); end\n"
+      "num F_f(V_n, V_r, V_r) { num V_a, num V_b, num V_c, begin\n"
+      "  if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "    V_b = F_f(V_a, V_r, V_r); return V_b; end\n"
+      "  else begin return V_r; end; end } end\n");
+
+  // the arguments are read, the parameters rebound and the locals reset
+  // before jumping back to the start; the return after it is left behind
+  ASSERT_EQ(program.functions.size(), 2u);
+  EXPECT_EQ(lines(program, 1),
+            (std::vector<std::string>{
+                "LABEL L4", "IF v3 > 0 GOTO L1", "GOTO L2", "LABEL L1",
+                "v6 := v3 - 1", "t1 := v6", "t2 := v5", "t3 := v5",
+                "v3 := t1", "v4 := t2", "v5 := t3", "v6 := 0", "v7 := 0",
+                "v8 := 0", "GOTO L4", "RETURN v7", "GOTO L3", "LABEL L2",
+                "RETURN v5", "LABEL L3", "RETURN"}));
 }
 
-TEST(IMCStatement, TestAssignment) {
-  IMCStatement val = IMCStatement::create_value(42);
-  IMCStatement stat = IMCStatement::create_assignment("v1", val);
-  ASSERT_EQ(stat.get_type(), IMCStatement::StatementType::Assignment);
-  ASSERT_EQ(stat.get_lhs_id(), "v1");
-  ASSERT_EQ(stat.get_rhs(), val);
-  ASSERT_NE(stat, val);
+TEST(IMCGenerator, KeepsGlobalsAcrossSelfTailCalls) {
+  // only F_f mentions V_g, which the jump back must not reset
+  IMCProgram program = generate(
+      "main num V_n, num V_g, begin V_n <input; V_n = F_f(V_n, V_n, V_n); "
+      "end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, V_n); if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "    V_b = F_f(V_a, V_a, V_a); return V_b; end\n"
+      "  else begin print V_g; return V_n; end; end } end\n");
+
+  const std::vector<IMCInstruction> &code = program.functions[1].code;
+  EXPECT_TRUE(std::none_of(code.begin(), code.end(),
+                           [](const IMCInstruction &instruction) {
+                             return instruction.opcode == IMCOpcode::Call;
+                           }));
+  EXPECT_EQ(run(program, "4"), "10\n");
+}
+
+TEST(IMCGenerator, KeepsCallsWhoseResultOutlivesTheReturn) {
+  // V_r is the global main prints, so the call must still store into it
+  IMCProgram program = generate(
+      "main num V_n, num V_r, begin V_r = F_f(V_n, V_n, V_n); print V_r; "
+      "end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "    V_r = F_f(V_a, V_a, V_a); return V_r; end\n"
+      "  else begin return V_n; end; end } end\n");
+
+  const std::vector<IMCInstruction> &code = program.functions[1].code;
+  EXPECT_EQ(std::count_if(code.begin(), code.end(),
+                          [](const IMCInstruction &instruction) {
+                            return instruction.opcode == IMCOpcode::Call;
+                          }),
+            1);
 }
@@ -0,0 +1,118 @@
+#include "corpus.h"
+#include <algorithm>
+#include <bytecode.h>
+#include <gtest/gtest.h>
+#include <inliner.h>
+#include <optimizer.h>
+#include <vm.h>
+
+namespace {
+
+std::size_t calls(const IMCProgram &program, std::size_t fn) {
+  const std::vector<IMCInstruction> &code = program.functions[fn].code;
+  return std::count_if(code.begin(), code.end(), [](const IMCInstruction &i) {
+    return i.opcode == IMCOpcode::Call;
+  });
+}
+
+} // namespace
+
+TEST(InlinerTest, InlinesSmallFunctionsAndTheirSubfunctions) {
+  IMCProgram program = generate(NESTED);
+  std::string expected = run(program, "3");
+  OptimizationReport report = optimize(program);
+
+  // F_inc into F_sq first, then F_sq with it into both calls of main,
+  // after which neither is called any more
+  EXPECT_EQ(report.inlined.calls, 3u);
+  EXPECT_EQ(report.inlined.functions, 2u);
+  EXPECT_EQ(calls(program, 0), 0u);
+  EXPECT_EQ(report.dead.functions, 2u);
+  EXPECT_EQ(program.functions.size(), 1u);
+  EXPECT_EQ(run(program, "3"), expected);
+  EXPECT_EQ(expected, "12\n156\n");
+}
+
+TEST(InlinerTest, KeepsSharedVariablesInMemory) {
+  IMCProgram program = generate(NESTED);
+  optimize(program);
+
+  // F_inc reads F_sq's V_x, so the inlined bodies store into it rather
+  // than into a copy, and copy propagation leaves those reads alone
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{
+                "t1 := INPUT", "v4 := t1", "t2 := v4 * v4", "t3 := t2 + v4",
+                "PRINT t3", "v4 := t3", "t4 := v4 * v4", "t5 := t4 + v4",
+                "PRINT t5", "STOP"}));
+}
+
+TEST(InlinerTest, LeavesRecursiveFunctionsAlone) {
+  IMCProgram program = generate(FIBONACCI);
+  OptimizationReport report = optimize(program);
+
+  EXPECT_EQ(report.inlined.calls, 0u);
+  EXPECT_EQ(calls(program, 0), 1u);
+  EXPECT_EQ(run(program, "15"), "610\n");
+}
+
+TEST(InlinerTest, RespectsTheSizeLimit) {
+  // a body longer than the limit stays a call
+  std::string body;
+  for (std::size_t i = 0; i <= Inliner::INLINE_LIMIT + 5; i++) {
+    body += "V_a = add(V_a, 1); ";
+  }
+  std::string source =
+      "main num V_a, begin V_a = F_f(V_a, V_a, V_a); print V_a; end\n"
+      "num F_f(V_a, V_a, V_a) { num V_b, num V_c, num V_d, begin " +
+      body + "return V_a; end } end\n";
+  IMCProgram program = generate(source.c_str());
+  std::string expected = run(program, "");
+  InlineReport report = Inliner(program).run();
+
+  EXPECT_EQ(report.calls, 0u);
+  EXPECT_EQ(run(program, ""), expected);
+}
+
+TEST(InlinerTest, PropagatesCopiesOfParameters) {
+  IMCProgram program = generate(
+      "main num V_x, num V_y, begin V_x <input; V_y = F_f(V_x, V_x, V_x); "
+      "print V_y; end\n"
+      "num F_f(V_x, V_y, V_y) { num V_a, num V_b, num V_c, begin "
+      "V_a = add(V_x, V_y); return V_a; end } end\n");
+  OptimizationReport report = optimize(program);
+
+  // the argument and parameter moves are gone, and so are the resets of
+  // the callee's locals
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"t1 := INPUT", "t2 := t1 + t1",
+                                      "PRINT t2", "STOP"}));
+  EXPECT_GT(report.copies, 0u);
+}
+
+TEST(InlinerTest, GivesZeroForFunctionsThatReturnNothing) {
+  // F_f falls off its end, which a call answers with zero
+  IMCProgram program = generate(
+      "main num V_x, begin V_x = 5; V_x = F_f(1, 2, 3); print V_x; end\n"
+      "num F_f(V_x, V_x, V_x) { num V_a, num V_b, num V_c, begin "
+      "V_a = 1; end } end\n");
+  std::string expected = run(program, "");
+  OptimizationReport report = optimize(program);
+
+  EXPECT_EQ(report.inlined.calls, 1u);
+  EXPECT_EQ(run(program, ""), expected);
+  EXPECT_EQ(expected, "0\n");
+}
+
+TEST(InlinerTest, KeepsGlobalsOnlyTheCalleeUpdates) {
+  // main never mentions V_g, but the inlined bodies must not reset it
+  IMCProgram program = generate(
+      "main num V_n, num V_g, begin V_n = F_f(V_n, V_n, V_n); "
+      "V_n = F_f(V_n, V_n, V_n); print V_n; end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin "
+      "V_g = add(V_g, 1); return V_g; end } end\n");
+  OptimizationReport report = optimize(program);
+
+  EXPECT_EQ(report.inlined.calls, 2u);
+  EXPECT_EQ(calls(program, 0), 0u);
+  EXPECT_EQ(run(program, ""), "2\n");
+}
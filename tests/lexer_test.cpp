@@ -1,5 +1,8 @@
+#include <fstream>
 #include <gtest/gtest.h>
 #include <lexer.h>
+#include <source_buffer.h>
+#include <sstream>
 
 TEST(LexerTest, EmptyTest) {
   auto *lexer = new Lexer("");
@@ -149,3 +152,215 @@ TEST(LexerTest, Punctuation) {
 
   delete lexer;
 }
+
+static const std::string DIFF_PROGRAM = R"(main
+num V_x, text V_msg, num V_y, num V_res,
+begin
+    V_x = 4;
+    V_y = -20.076;
+    V_msg = "Byecoco";
+    V_res = F_compute(5, V_x, V_y);
+    V_res <input;
+    if and(grt(V_x, 40.1), eq(V_x, V_y)) then
+        begin
+            print V_msg;
+            skip;
+            halt;
+        end
+    else
+        begin
+            V_x = sqrt(49);
+            V_y=add(2,20.1);
+        end;
+end
+num F_compute(V_a, V_b, V_c) {
+	num V_temp1, text V_temp2, num V_temp3,
+	begin
+		V_temp1 = div(V_a, V_b);
+		return V_temp1;
+	end
+}
+end
+)";
+
+static std::vector<Token> lex_with(const std::string &source,
+                                   LexerEngine engine) {
+  Lexer lexer(source, engine);
+  std::vector<Token> tokens;
+  std::optional<Token> token;
+  while ((token = lexer.next_token()).has_value()) {
+    tokens.push_back(token.value());
+  }
+  return tokens;
+}
+
+TEST(LexerTest, EnginesAgree) {
+  auto expected = lex_with(DIFF_PROGRAM, LexerEngine::Regex);
+  auto actual = lex_with(DIFF_PROGRAM, LexerEngine::Table);
+
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i].type(), actual[i].type()) << "token " << i;
+    EXPECT_EQ(expected[i].to_string(), actual[i].to_string()) << "token " << i;
+    EXPECT_EQ(expected[i].get_str_data(), actual[i].get_str_data())
+        << "token " << i;
+  }
+}
+
+TEST(LexerTest, EnginesAgreeOnLexAll) {
+  auto expected = Lexer(DIFF_PROGRAM, LexerEngine::Regex).lex_all().getTokens();
+  auto actual = Lexer(DIFF_PROGRAM, LexerEngine::Table).lex_all().getTokens();
+
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i].to_string(), actual[i].to_string()) << "token " << i;
+  }
+}
+
+TEST(LexerTest, TokenSpans) {
+  Lexer lexer("main\nnum V_a,\n  V_a = add(V_ab, \"Hi\");\n");
+  auto tokens = lexer.lex_all().getTokens();
+
+  ASSERT_EQ(tokens.size(), 13u);
+
+  // V_a on line 3 must not be attributed to the earlier declaration line
+  EXPECT_EQ(tokens[4].get_str_data(), "V_a");
+  EXPECT_EQ(tokens[4].span().line, 3u);
+  EXPECT_EQ(tokens[4].span().column, 3u);
+  EXPECT_EQ(tokens[4].span().offset, 16u);
+  EXPECT_EQ(tokens[4].span().length, 3u);
+
+  EXPECT_EQ(tokens[8].get_str_data(), "V_ab");
+  EXPECT_EQ(tokens[8].span().line, 3u);
+  EXPECT_EQ(tokens[8].span().column, 13u);
+
+  EXPECT_EQ(tokens[10].get_str_data(), "Hi");
+  EXPECT_EQ(tokens[10].span().column, 19u);
+  EXPECT_EQ(tokens[10].span().length, 4u);
+
+  EXPECT_EQ(tokens[12].get_str_data(), ";");
+  EXPECT_EQ(tokens[12].get_line_number(), 3);
+}
+
+TEST(LexerTest, LocateOffset) {
+  Lexer lexer("main\nbegin\n\nend");
+
+  EXPECT_EQ(lexer.line_starts().size(), 4u);
+  EXPECT_EQ(lexer.locate(0).line, 1u);
+  EXPECT_EQ(lexer.locate(5).line, 2u);
+  EXPECT_EQ(lexer.locate(7).column, 3u);
+  EXPECT_EQ(lexer.locate(12).line, 4u);
+  EXPECT_EQ(lexer.locate(12).column, 1u);
+}
+
+TEST(LexerTest, EnginesAgreeOnErrors) {
+  for (const char *source :
+       {"V_", "V_A", "F_1", "\"abc\"", "\"Abcdefghi\"", "1.00", "--1", "00",
+        "100", "<inp", "V_a#", "main V_x = 1.;"}) {
+    EXPECT_THROW(lex_with(source, LexerEngine::Regex), LexerException)
+        << source;
+    EXPECT_THROW(lex_with(source, LexerEngine::Table), LexerException)
+        << source;
+  }
+}
+
+TEST(LexerTest, TokenOffsets) {
+  Lexer lexer("  V_abc(F_x )");
+
+  lexer.next_token();
+  EXPECT_EQ(lexer.token_offsets().first, 2u);
+  EXPECT_EQ(lexer.token_offsets().second, 7u);
+  lexer.next_token();
+  EXPECT_EQ(lexer.token_offsets().first, 7u);
+  EXPECT_EQ(lexer.token_offsets().second, 8u);
+  lexer.next_token();
+  EXPECT_EQ(lexer.token_offsets().first, 8u);
+  EXPECT_EQ(lexer.token_offsets().second, 11u);
+  lexer.next_token();
+  EXPECT_EQ(lexer.token_offsets().first, 12u);
+  EXPECT_EQ(lexer.token_offsets().second, 13u);
+  EXPECT_FALSE(lexer.next_token().has_value());
+}
+
+TEST(TokenTest, CompactInternedLexemes) {
+  Lexer lexer("V_abc F_abc V_abc \"Abc\" 1.5 ; num");
+  auto tokens = lexer.lex_all().getTokens();
+
+  ASSERT_EQ(tokens.size(), 7u);
+  EXPECT_EQ(sizeof(Token), 16u);
+
+  // identical lexemes share one pool entry
+  EXPECT_EQ(tokens[0].lexeme(), tokens[2].lexeme());
+  EXPECT_NE(tokens[0].lexeme(), tokens[1].lexeme());
+  EXPECT_EQ(tokens[0].text(), "V_abc");
+  EXPECT_EQ(tokens[3].text(), "Abc");
+  EXPECT_EQ(tokens[4].text(), "1.5");
+
+  EXPECT_EQ(tokens[5].get_punct(), ';');
+  EXPECT_EQ(tokens[5].text(), ";");
+  EXPECT_EQ(tokens[6].get_keyword(), Keyword::Num);
+  EXPECT_EQ(tokens[6].text(), "num");
+}
+
+TEST(LexerTest, TokenSourcePeekAndNext) {
+  Lexer lexer("begin skip; end");
+  TokenSource &source = lexer;
+
+  ASSERT_TRUE(source.peek().has_value());
+  EXPECT_EQ(source.peek()->get_keyword(), Keyword::Begin);
+  EXPECT_EQ(source.next()->get_keyword(), Keyword::Begin);
+  EXPECT_EQ(source.next()->get_keyword(), Keyword::Skip);
+  EXPECT_EQ(source.peek()->get_punct(), ';');
+  EXPECT_EQ(source.next()->get_punct(), ';');
+  EXPECT_EQ(source.next()->get_keyword(), Keyword::End);
+  EXPECT_FALSE(source.peek().has_value());
+  EXPECT_FALSE(source.next().has_value());
+}
+
+TEST(LexerTest, TokenStreamReadsInOrder) {
+  TokenStream stream = Lexer("begin skip; end").lex_all();
+
+  EXPECT_EQ(stream.peek()->get_keyword(), Keyword::Begin);
+  EXPECT_EQ(stream.next()->get_keyword(), Keyword::Begin);
+  EXPECT_EQ(stream.next()->get_keyword(), Keyword::Skip);
+  EXPECT_EQ(stream.next()->get_punct(), ';');
+  EXPECT_EQ(stream.next()->get_keyword(), Keyword::End);
+  EXPECT_FALSE(stream.next().has_value());
+  EXPECT_EQ(stream.getTokens().size(), 4u);
+}
+
+TEST(SourceBufferTest, MapsFileForLexer) {
+  std::string path = testing::TempDir() + "splc_source_buffer_test.txt";
+  {
+    std::ofstream file(path);
+    file << "main\nbegin skip; end";
+  }
+
+  SourceBuffer buffer = SourceBuffer::open(path);
+  EXPECT_TRUE(buffer.is_mapped());
+  EXPECT_EQ(buffer.text(), "main\nbegin skip; end");
+
+  // the lexer scans the mapping in place
+  SourceBuffer moved = std::move(buffer);
+  Lexer lexer(moved.text());
+  auto tokens = lexer.lex_all().getTokens();
+  ASSERT_EQ(tokens.size(), 5u);
+  EXPECT_EQ(tokens[1].get_keyword(), Keyword::Begin);
+  EXPECT_EQ(tokens[1].span().line, 2u);
+
+  std::remove(path.c_str());
+}
+
+TEST(SourceBufferTest, ReadsStreamsAndEmptyFiles) {
+  std::istringstream input("begin end");
+  SourceBuffer buffer = SourceBuffer::read(input);
+  EXPECT_FALSE(buffer.is_mapped());
+  EXPECT_EQ(buffer.text(), "begin end");
+
+  std::string path = testing::TempDir() + "splc_source_buffer_empty.txt";
+  std::ofstream(path).close();
+  EXPECT_EQ(SourceBuffer::open(path).text(), "");
+  std::remove(path.c_str());
+
+  EXPECT_THROW(SourceBuffer::open(path), std::runtime_error);
+}
@@ -0,0 +1,319 @@
+#include <ast_visitor.h>
+#include <gtest/gtest.h>
+#include <parse_table_data.h>
+#include <parser.h>
+#include <typechecker.h>
+
+namespace {
+
+const char *DIFF_PROGRAMS[] = {
+    "main num V_x, begin V_x = add(V_x, 1); print V_x; end",
+    "main num V_x, text V_msg, begin V_x <input; V_msg = \"Hi\"; "
+    "if and(grt(V_x, 1), eq(V_x, 2)) then begin print V_msg; halt; end "
+    "else begin if not(eq(V_x, 3)) then begin skip; end else begin end; end; "
+    "V_x = F_f(V_x, 2, 3); end "
+    "num F_f(V_a, V_b, V_c) { num V_d, num V_e, text V_g, "
+    "begin V_d = sqrt(V_a); return V_d; end } "
+    "void F_g(V_a, V_b, V_c) { num V_d, num V_e, num V_h, "
+    "begin skip; end } end end",
+    "main begin end",
+};
+
+std::string dump_tree(const SyntaxTreeNode *node) {
+  std::string result = node->getSymbolOrValue();
+  if (!node->getChildren().empty()) {
+    result += "(";
+    for (const SyntaxTreeNode *child : node->getChildren()) {
+      result += dump_tree(child) + " ";
+    }
+    result += ")";
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(ParseTableTest, MatchesReferenceTable) {
+  ParserFileHandler reference;
+  ParseTable table = ParseTable::from_file_handler(reference);
+
+  auto cells = reference.getParseTable();
+  ASSERT_EQ(static_cast<std::size_t>(table.state_count()), cells.size());
+
+  for (const auto &row : cells) {
+    int state = std::stoi(row.first);
+    for (const auto &cell : row.second) {
+      int symbol = table.symbol_id(cell.first);
+      ASSERT_GE(symbol, 0) << cell.first;
+
+      const std::string &expected = cell.second;
+      if (!table.is_terminal(symbol)) {
+        int target = table.go_to(state, symbol);
+        EXPECT_EQ(target, expected.empty() ? -1 : std::stoi(expected))
+            << "GOTO[" << state << ", " << cell.first << "]";
+        continue;
+      }
+
+      ParseTable::Action action = table.action(state, symbol);
+      if (expected.empty()) {
+        // error cells may be folded into the default reduction
+        EXPECT_EQ(action, table.default_action(state));
+      } else if (expected == "acc") {
+        EXPECT_EQ(action, ParseTable::ACCEPT);
+      } else if (expected[0] == 's') {
+        ASSERT_TRUE(ParseTable::is_shift(action)) << expected;
+        EXPECT_EQ(ParseTable::shift_state(action),
+                  std::stoi(expected.substr(1)));
+      } else {
+        ASSERT_TRUE(ParseTable::is_reduce(action)) << expected;
+        EXPECT_EQ(ParseTable::reduce_rule(action),
+                  std::stoi(expected.substr(1)));
+      }
+    }
+  }
+}
+
+TEST(ParseTableTest, RulesMatchReferenceGrammar) {
+  ParserFileHandler reference;
+  const ParseTable &table = ParseTable::standard();
+
+  auto rules = reference.getGrammarRules();
+  ASSERT_EQ(static_cast<std::size_t>(table.rule_count()), rules.size());
+  for (std::size_t i = 0; i < rules.size(); i++) {
+    EXPECT_EQ(table.symbol_name(table.rule(i).lhs), rules[i].first);
+    EXPECT_EQ(table.rule(i).length, rules[i].second.size());
+  }
+
+  EXPECT_EQ(table.symbol_id("main"), static_cast<int>(GrammarSymbol::Main));
+  EXPECT_EQ(table.symbol_id("$"), static_cast<int>(GrammarSymbol::EndOfInput));
+  EXPECT_EQ(table.symbol_id("PROG"), static_cast<int>(GrammarSymbol::PROG));
+}
+
+TEST(ParseTableTest, GeneratedTableIsConflictFree) {
+  Grammar grammar = Grammar::parse(GRAMMAR_RULES_INPUT);
+  LalrTable table = LalrTable::build(grammar);
+
+  EXPECT_TRUE(table.conflicts().empty());
+  EXPECT_EQ(table.state_count(), ParseTable::standard().state_count());
+  EXPECT_EQ(grammar.symbol_name(grammar.end_marker()), "$");
+}
+
+TEST(ParseTableTest, ReportsConflicts) {
+  // the classic dangling else
+  Grammar grammar = Grammar::parse("S -> E\n"
+                                   "E -> if E then E\n"
+                                   "E -> if E then E else E\n"
+                                   "E -> x\n");
+  LalrTable table = LalrTable::build(grammar);
+
+  ASSERT_EQ(table.conflicts().size(), 1u);
+  EXPECT_NE(table.describe(grammar, table.conflicts().front())
+                .find("shift/reduce conflict"),
+            std::string::npos);
+}
+
+TEST(ParseTableTest, CompressionPreservesCells) {
+  Grammar grammar = Grammar::parse(GRAMMAR_RULES_INPUT);
+  LalrTable dense = LalrTable::build(grammar);
+  const ParseTable &table = ParseTable::standard();
+
+  int terminals = grammar.terminal_count();
+  int nonterminals = grammar.nonterminal_count();
+  for (int state = 0; state < dense.state_count(); state++) {
+    for (int t = 0; t < terminals; t++) {
+      ParseTable::Action expected = dense.actions()[state * terminals + t];
+      ParseTable::Action action = table.action(state, t);
+      if (expected == ParseTable::ERROR) {
+        EXPECT_EQ(action, table.default_action(state));
+      } else {
+        EXPECT_EQ(action, expected);
+      }
+    }
+    for (int n = 0; n < nonterminals; n++) {
+      EXPECT_EQ(table.go_to(state, terminals + n),
+                dense.gotos()[state * nonterminals + n]);
+    }
+  }
+}
+
+TEST(ParserTest, GeneratedTableMatchesReferenceParse) {
+  ParseTable reference = ParseTable::from_file_handler(ParserFileHandler());
+
+  for (const char *program : DIFF_PROGRAMS) {
+    auto expected = Parser(Lexer(program).lex_all(), reference).parse();
+    auto actual = Parser(Lexer(program).lex_all()).parse();
+
+    ASSERT_NE(expected, nullptr) << program;
+    ASSERT_NE(actual, nullptr) << program;
+    EXPECT_EQ(dump_tree(actual->getRoot()), dump_tree(expected->getRoot()))
+        << program;
+  }
+}
+
+TEST(ParserTest, ParsesProgram) {
+  Lexer lexer("main num V_x, begin V_x = add(V_x, 1); print V_x; end");
+  Parser parser(lexer.lex_all());
+
+  auto tree = parser.parse();
+  ASSERT_NE(tree, nullptr);
+
+  const SyntaxTreeNode *root = tree->getRoot();
+  EXPECT_EQ(root->getSymbol(), "PROG");
+  ASSERT_EQ(root->getChildren().size(), 4u);
+  EXPECT_EQ(root->getChildren()[0]->getSymbol(), "main");
+  EXPECT_EQ(root->getChildren()[2]->getSymbol(), "ALGO");
+}
+
+TEST(ParserTest, RejectsInvalidProgram) {
+  Lexer lexer("main num V_x, begin V_x = ; end");
+  Parser parser(lexer.lex_all());
+
+  EXPECT_EQ(parser.parse(), nullptr);
+}
+
+TEST(ParserTest, TreeNodesLiveInArena) {
+  Lexer lexer("main num V_x, begin V_x = add(V_x, 1); end");
+  auto tree = Parser(lexer.lex_all()).parse();
+  ASSERT_NE(tree, nullptr);
+
+  // count nodes and check ids are dense and symbols are grammar ids
+  std::vector<const SyntaxTreeNode *> pending = {tree->getRoot()};
+  std::vector<bool> seen(tree->size(), false);
+  while (!pending.empty()) {
+    const SyntaxTreeNode *node = pending.back();
+    pending.pop_back();
+
+    ASSERT_LT(node->id, tree->size());
+    EXPECT_FALSE(seen[node->id]);
+    seen[node->id] = true;
+    EXPECT_EQ(node->getSymbol(), ParseTable::standard().symbol_name(
+                                     static_cast<int>(node->getSymbolId())));
+    for (const SyntaxTreeNode *child : node->getChildren()) {
+      pending.push_back(child);
+    }
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true),
+            static_cast<long>(tree->size()));
+
+  const SyntaxTreeNode *varname = tree->getRoot()
+                                      ->getChildren()[1]  // GLOBVARS
+                                      ->getChildren()[1]  // VNAME
+                                      ->getChildren()[0]; // varname
+  EXPECT_EQ(varname->getSymbolId(), GrammarSymbol::Varname);
+  EXPECT_EQ(varname->value(), "V_x");
+  EXPECT_EQ(varname->getSymbolOrValue(), "V_x");
+}
+
+TEST(ArenaTest, AllocatesAlignedAndOversized) {
+  Arena arena;
+  auto *small = arena.create<SourceSpan>(SourceSpan{1, 2, 3, 4});
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(small) % alignof(SourceSpan), 0u);
+  EXPECT_EQ(small->column, 2u);
+  EXPECT_EQ(arena.block_count(), 1u);
+
+  // a large request gets its own block and does not disturb the current one
+  uint64_t *large = arena.allocate_array<uint64_t>(100000);
+  large[99999] = 7;
+  auto *next = arena.create<SourceSpan>(SourceSpan{5, 6, 7, 8});
+  EXPECT_EQ(arena.block_count(), 2u);
+  EXPECT_EQ(reinterpret_cast<char *>(next) - reinterpret_cast<char *>(small),
+            static_cast<std::ptrdiff_t>(sizeof(SourceSpan)));
+}
+
+TEST(ParserTest, ConsumesTokensWithoutCopying) {
+  std::string program = "main begin ";
+  for (int i = 0; i < 2000; i++) {
+    program += "skip; ";
+  }
+  program += "end";
+
+  TokenStream tokens = Lexer(program).lex_all();
+  Parser parser(std::move(tokens));
+  EXPECT_TRUE(tokens.getTokens().empty());
+
+  auto tree = parser.parse();
+  ASSERT_NE(tree, nullptr);
+  EXPECT_EQ(tree->getRoot()->getSymbolId(), GrammarSymbol::PROG);
+}
+
+TEST(ParserTest, PullsTokensFromLexer) {
+  for (const char *program : DIFF_PROGRAMS) {
+    Lexer streaming(program);
+    auto pulled = Parser(streaming).parse();
+    auto materialised = Parser(Lexer(program).lex_all()).parse();
+
+    ASSERT_NE(pulled, nullptr) << program;
+    ASSERT_NE(materialised, nullptr) << program;
+    EXPECT_EQ(dump_tree(pulled->getRoot()), dump_tree(materialised->getRoot()));
+    EXPECT_FALSE(streaming.peek().has_value());
+  }
+}
+
+TEST(ParserTest, ReportsLexerErrorsWhileStreaming) {
+  Lexer lexer("main begin V_x = 1; V_bad! end");
+  EXPECT_EQ(Parser(lexer).parse(), nullptr);
+}
+
+namespace {
+
+// counts assignments and the operators nested anywhere below them
+class AssignCounter : public AstVisitor<AssignCounter, int> {
+public:
+  int visitAssign(SyntaxTreeNode *node) {
+    this->assignments++;
+    return this->visitChildren(node);
+  }
+
+  int visitOp(SyntaxTreeNode *node) {
+    this->ops++;
+    return this->visitChildren(node);
+  }
+
+  int assignments = 0;
+  int ops = 0;
+};
+
+} // namespace
+
+TEST(AstVisitorTest, DispatchesOnNodeKind) {
+  Lexer lexer("main num V_x, begin V_x = add(mul(V_x, 2), sqrt(4)); "
+              "V_x <input; print V_x; end");
+  auto tree = Parser(lexer.lex_all()).parse();
+  ASSERT_NE(tree, nullptr);
+
+  AssignCounter counter;
+  counter.visit(tree->getRoot());
+  EXPECT_EQ(counter.assignments, 2);
+  EXPECT_EQ(counter.ops, 3);
+}
+
+TEST(ParserTest, WalksLongListsInBoundedStack) {
+  // deep enough that one stack frame per statement would overflow
+  constexpr int STATEMENTS = 200000;
+  std::string program = "main num V_x, begin ";
+  for (int i = 0; i < STATEMENTS; i++) {
+    program += "V_x = add(V_x, 1); ";
+  }
+  program += "end";
+
+  testing::internal::CaptureStdout();
+  Lexer lexer(program);
+  auto tree = Parser(lexer).parse();
+  std::string printed = testing::internal::GetCapturedStdout();
+  ASSERT_NE(tree, nullptr);
+  EXPECT_FALSE(printed.empty());
+
+  SyntaxTreeNode *instructions = tree->getRoot()->child(2)->child(1);
+  std::size_t count = 0;
+  for (SyntaxTreeNode *link : SyntaxTreeList(instructions)) {
+    EXPECT_EQ(link->child(0)->getSymbolId(), GrammarSymbol::COMMAND);
+    count++;
+  }
+  EXPECT_EQ(count, static_cast<std::size_t>(STATEMENTS));
+
+  AssignCounter counter;
+  counter.visit(tree->getRoot());
+  EXPECT_EQ(counter.assignments, STATEMENTS);
+
+  EXPECT_TRUE(TypeChecker(tree->getRoot()).check().ok());
+}
@@ -0,0 +1,58 @@
+#ifndef SPL_TESTS_SAMPLES_H
+#define SPL_TESTS_SAMPLES_H
+
+// Well-typed SPL programs several tests share, which they also run as
+// part of the sample corpus.
+
+// naive Fibonacci: two calls per step, little work in between
+inline const char *const FIBONACCI =
+    "main num V_n, num V_r, begin V_n <input; V_r = F_fib(V_n, V_n, V_n); "
+    "print V_r; end\n"
+    "num F_fib(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+    "  if grt(2, V_n) then begin return V_n; end else begin\n"
+    "    V_a = sub(V_n, 1); V_b = F_fib(V_a, V_a, V_a);\n"
+    "    V_a = sub(V_n, 2); V_c = F_fib(V_a, V_a, V_a);\n"
+    "    V_a = add(V_b, V_c); end; return V_a; end } end\n";
+
+// every operation, texts, and a global the function shares with main
+inline const char *const MIXED =
+    "main num V_x, num V_g, num V_y, text V_t, text V_u, begin V_x <input;\n"
+    "  V_g = 1; V_t = \"Big\"; print V_u; V_y = div(1, 0); print V_y;\n"
+    "  V_y = sqrt(2); print V_y;\n"
+    "  if and(grt(V_x, 10), grt(20, V_x)) then begin print V_t; end\n"
+    "  else begin print \"Small\"; end;\n"
+    "  if or(eq(V_t, \"Big\"), grt(V_t, V_u)) then begin print 1; end\n"
+    "  else begin print 0; end;\n"
+    "  if not(grt(V_x, 10)) then begin print V_u; end else begin halt; end;\n"
+    "  V_x = F_f(V_x, V_x, V_x); print V_x; print V_g; V_y = sub(V_x, 0.5);\n"
+    "  V_x = div(V_g, 3); V_y = mul(V_y, V_x); print V_y; halt; print 2; end\n"
+    "num F_f(V_x, V_x, V_x) { num V_a, num V_b, num V_c, begin\n"
+    "  V_g = add(V_g, V_x); V_a = add(V_x, 1); return V_a; end } end\n";
+
+// mutual recursion in tail position, deeper than the native stack allows
+// for real calls
+inline const char *const EVEN_ODD =
+    "main num V_n, num V_r, num V_s, begin V_n <input;\n"
+    "  V_r = F_even(V_n, V_n, V_n); print V_r; end\n"
+    "num F_even(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+    "  if eq(V_n, 0) then begin return 1; end else begin\n"
+    "  V_a = sub(V_n, 1); V_b = F_odd(V_a, V_a, V_a); return V_b; end;\n"
+    "  end }\n"
+    "  num F_odd(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+    "    if eq(V_n, 0) then begin return 0; end else begin\n"
+    "    V_a = sub(V_n, 1); V_b = F_even(V_a, V_a, V_a); return V_b; end;\n"
+    "    end } end\n"
+    "end\n";
+
+// F_sq squares through its nested F_inc, which reads F_sq's parameter
+inline const char *const NESTED =
+    "main num V_x, num V_y, num V_z, begin V_x <input; "
+    "V_y = F_sq(V_x, V_x, V_x); print V_y; V_y = F_sq(V_y, V_x, V_x); "
+    "print V_y; end\n"
+    "num F_sq(V_x, V_y, V_z) { num V_p, num V_q, num V_r, begin\n"
+    "  V_p = mul(V_x, V_x); V_q = F_inc(V_p, V_p, V_p); return V_q; end }\n"
+    "  num F_inc(V_p, V_q, V_r) { num V_s, num V_t, num V_u, begin\n"
+    "    V_s = add(V_p, V_x); return V_s; end } end\n"
+    "end\n";
+
+#endif
@@ -0,0 +1,79 @@
+#include "corpus.h"
+#include <gtest/gtest.h>
+#include <optimizer.h>
+
+TEST(SCCPTest, FoldsArithmeticOnConstants) {
+  IMCProgram program =
+      generate("main num V_x, num V_y, begin V_x = add(2, 20.5); "
+               "V_y = sqrt(49); V_x = mul(V_x, V_y); print V_x; end");
+  SCCPReport report = optimize(program).constants;
+
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"PRINT 157.5", "STOP"}));
+  EXPECT_EQ(report.folded, 3u);
+  EXPECT_EQ(report.branches, 0u);
+}
+
+TEST(SCCPTest, PrunesBranchesOnConstants) {
+  IMCProgram program = generate(
+      "main num V_x, text V_t, begin V_x = 5; "
+      "if and(eq(V_x, 5), grt(V_x, 1)) then begin V_t = \"Yes\"; end "
+      "else begin V_t = \"No\"; end; print V_t; end");
+  SCCPReport report = optimize(program).constants;
+
+  // both tests and the else arm are gone, and the merge of V_t with them
+  EXPECT_EQ(lines(program, 0),
+            (std::vector<std::string>{"PRINT \"Yes\"", "STOP"}));
+  EXPECT_EQ(report.branches, 2u);
+  EXPECT_GE(report.blocks, 1u);
+  EXPECT_GE(report.instructions, 1u);
+}
+
+TEST(SCCPTest, KeepsValuesOnlyKnownAtRunTime) {
+  IMCProgram program = generate(
+      "main num V_x, num V_y, begin V_x <input; V_y = div(1, 0); "
+      "V_y = add(V_y, V_x); if grt(V_x, 1) then begin V_x = 1; end "
+      "else begin V_x = 1; end; print V_x; print V_y; end");
+  SCCPReport report = optimize(program).constants;
+
+  // the branch is undecided, but both of its arms agree on V_x
+  EXPECT_EQ(report.branches, 0u);
+  std::vector<std::string> code = lines(program, 0);
+  EXPECT_EQ(code[0], "t1 := INPUT");
+  EXPECT_EQ(code[1], "t2 := 1 / 0");
+  EXPECT_EQ(code[2], "t3 := t2 + t1");
+  EXPECT_NE(std::find(code.begin(), code.end(), "PRINT 1"), code.end());
+  EXPECT_NE(std::find(code.begin(), code.end(), "PRINT t3"), code.end());
+}
+
+TEST(SCCPTest, LeavesSharedVariablesInMemory) {
+  IMCProgram program = generate(
+      "main num V_y, num V_z, begin V_y = 2; V_z = F_f(V_z, V_z, V_z); "
+      "print V_y; end\n"
+      "num F_f(V_z, V_z, V_z) { num V_c, num V_d, num V_e, begin\n"
+      "  V_y = 3; return V_y; end } end\n");
+  optimize(program);
+
+  // F_f changes V_y, so main reads it back after the call
+  std::vector<std::string> code = lines(program, 0);
+  EXPECT_EQ(code[0], "v1 := 2");
+  EXPECT_NE(std::find(code.begin(), code.end(), "PRINT v1"), code.end());
+}
+
+TEST(SCCPTest, OptimizesTheSampleCorpus) {
+  std::size_t translated = 0;
+  for (const std::string &source : corpus_programs()) {
+    std::optional<IMCProgram> program = corpus_imc(source);
+    if (!program) {
+      continue;
+    }
+    translated++;
+    optimize(*program);
+    for (const IMCFunction &function : program->functions) {
+      ASSERT_FALSE(function.code.empty()) << function.name;
+      EXPECT_TRUE(is_terminator(function.code.back().opcode))
+          << function.name;
+    }
+  }
+  EXPECT_GE(translated, CORPUS_WELL_TYPED);
+}
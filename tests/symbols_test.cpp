@@ -25,7 +25,7 @@ protected:
       stream << letters[letter_dist(gen)];
     }
 
-    Symbol new_symbol = Symbol(stream.str(), "textliteral");
+    Symbol new_symbol = Symbol(stream.str(), TypeId::Text);
     this->table().bind(new_symbol);
     return new_symbol;
   }
@@ -35,31 +35,111 @@ private:
 };
 
 TEST_F(SymbolTableFixture, EmptyTest) {
-  ASSERT_FALSE(table().lookup("x").has_value());
+  ASSERT_EQ(table().lookup("x"), nullptr);
 }
 
 TEST_F(SymbolTableFixture, SingleSymbol) {
-  table().bind(Symbol("x", "varname"));
+  table().bind(Symbol("x", TypeId::Num));
   Symbol s = bind_random();
-  std::optional<Symbol> x = table().lookup(s.name());
+  const Symbol *x = table().lookup(s.name());
 
-  ASSERT_TRUE(x.has_value());
-  ASSERT_FALSE(table().lookup("y").has_value());
-  ASSERT_EQ(x.value(), s);
+  ASSERT_NE(x, nullptr);
+  ASSERT_EQ(table().lookup("y"), nullptr);
+  ASSERT_EQ(*x, s);
 }
 
 TEST_F(SymbolTableFixture, SingleEnter) {
   Symbol s = bind_random();
   table().enter();
 
-  ASSERT_TRUE(table().lookup(s.name()).has_value());
+  ASSERT_TRUE(table().lookup(s.name()));
 }
 
 TEST_F(SymbolTableFixture, EnterExit) {
   Symbol s = bind_random();
   table().enter();
 
-  ASSERT_TRUE(table().lookup(s.name()).has_value());
+  ASSERT_TRUE(table().lookup(s.name()));
   table().exit();
-  ASSERT_TRUE(table().lookup(s.name()).has_value());
+  ASSERT_TRUE(table().lookup(s.name()));
+}
+
+TEST_F(SymbolTableFixture, ExitDropsInnerBindings) {
+  table().enter();
+  Symbol s = bind_random();
+  ASSERT_TRUE(table().lookup(s.name()));
+
+  table().exit();
+  ASSERT_FALSE(table().lookup(s.name()));
+}
+
+TEST_F(SymbolTableFixture, ShadowingIsUndoneOnExit) {
+  table().bind(Symbol("V_x", TypeId::Num));
+  table().enter();
+  table().bind(Symbol("V_x", TypeId::Text));
+  table().enter();
+
+  ASSERT_EQ(table().lookup("V_x")->type(), TypeId::Text);
+  table().exit();
+  ASSERT_EQ(table().lookup("V_x")->type(), TypeId::Text);
+  table().exit();
+  ASSERT_EQ(table().lookup("V_x")->type(), TypeId::Num);
+  ASSERT_EQ(table().depth(), 0u);
+}
+
+TEST_F(SymbolTableFixture, ManyScopesAndSymbols) {
+  for (int scope = 0; scope < 100; scope++) {
+    table().enter();
+    for (int i = 0; i < 50; i++) {
+      table().bind(Symbol("V_s" + std::to_string(scope) + "_" +
+                              std::to_string(i),
+                          TypeId::Num));
+    }
+  }
+
+  ASSERT_TRUE(table().lookup("V_s0_0"));
+  ASSERT_TRUE(table().lookup("V_s99_49"));
+
+  for (int scope = 99; scope >= 0; scope--) {
+    table().exit();
+    ASSERT_FALSE(table().lookup("V_s" + std::to_string(scope) + "_0"));
+    if (scope > 0) {
+      ASSERT_TRUE(table().lookup("V_s0_0"));
+    }
+  }
+  ASSERT_THROW(table().exit(), std::runtime_error);
+}
+
+TEST_F(SymbolTableFixture, LookupLocal) {
+  table().bind(Symbol("V_x", TypeId::Num));
+  ASSERT_NE(table().lookup_local("V_x"), nullptr);
+
+  table().enter();
+  ASSERT_NE(table().lookup("V_x"), nullptr);
+  ASSERT_EQ(table().lookup_local("V_x"), nullptr);
+
+  table().bind(Symbol("V_x", TypeId::Text));
+  ASSERT_NE(table().lookup_local("V_x"), nullptr);
+  ASSERT_EQ(table().lookup_local("V_x")->type(), TypeId::Text);
+
+  table().exit();
+  ASSERT_EQ(table().lookup_local("V_x")->type(), TypeId::Num);
+  ASSERT_EQ(table().lookup_local("V_never_bound"), nullptr);
+}
+
+TEST_F(SymbolTableFixture, LookupByInternedId) {
+  SymbolId name = Interner::global().intern("F_sig");
+  table().bind(Symbol::function(name, TypeId::Num,
+                                {TypeId::Num, TypeId::Text, TypeId::Num}));
+
+  const Symbol *function = table().lookup(name);
+  ASSERT_NE(function, nullptr);
+  ASSERT_EQ(function, table().lookup("F_sig"));
+  ASSERT_EQ(function->type(), TypeId::Function);
+  ASSERT_EQ(function->getReturnType(), TypeId::Num);
+  ASSERT_EQ(function->getParamTypes().size(), 3u);
+  ASSERT_EQ(function->getParamTypes()[1], TypeId::Text);
+  ASSERT_EQ(function->name(), "F_sig");
+  ASSERT_EQ(typeName(function->getParamTypes()[1]), "text");
+  ASSERT_EQ(table().lookup(Interner::INVALID), nullptr);
 }
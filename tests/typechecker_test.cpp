@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <lexer.h>
+#include <parser.h>
+#include <sstream>
+#include <typechecker.h>
+
+namespace {
+
+DiagnosticReport check(const char *program,
+                       std::size_t limit = DiagnosticEngine::DEFAULT_LIMIT) {
+  testing::internal::CaptureStdout();
+  Lexer lexer(program);
+  auto tree = Parser(lexer).parse();
+  testing::internal::GetCapturedStdout();
+  EXPECT_NE(tree, nullptr) << program;
+  return TypeChecker(tree->getRoot(), limit).check();
+}
+
+} // namespace
+
+TEST(TypeCheckerTest, AcceptsWellTypedProgram) {
+  DiagnosticReport report =
+      check("main num V_x, text V_t, begin V_x = add(mul(V_x, 2), 3); "
+            "V_t = \"Hi\"; V_x <input; print V_t; end");
+  EXPECT_TRUE(report.ok());
+  EXPECT_TRUE(report.diagnostics.empty());
+}
+
+TEST(TypeCheckerTest, ReportsEveryErrorInOnePass) {
+  DiagnosticReport report =
+      check("main num V_x, text V_t, num V_x,\n"
+            "begin\n"
+            "  V_t = 1;\n"
+            "  V_y = 2;\n"
+            "  V_t <input;\n"
+            "end");
+
+  ASSERT_EQ(report.errors, 4u);
+  ASSERT_EQ(report.diagnostics.size(), 4u);
+  EXPECT_EQ(report.diagnostics[0].message, "variable 'V_x' was already declared");
+  EXPECT_EQ(report.diagnostics[0].span.line, 1u);
+  EXPECT_EQ(report.diagnostics[1].span.line, 3u);
+  EXPECT_EQ(report.diagnostics[2].message,
+            "undeclared variable 'V_y' assigned a value");
+  EXPECT_EQ(report.diagnostics[2].span.line, 4u);
+  EXPECT_EQ(report.diagnostics[3].span.line, 5u);
+}
+
+TEST(TypeCheckerTest, ErrorTypeDoesNotCascade) {
+  // the undefined variable is the only error; the operators and the
+  // assignment it feeds are not reported again
+  DiagnosticReport report =
+      check("main num V_x, begin V_x = add(sqrt(V_nope), 1); end");
+
+  ASSERT_EQ(report.errors, 1u);
+  EXPECT_EQ(report.diagnostics[0].message, "undefined variable 'V_nope'");
+}
+
+TEST(TypeCheckerTest, RejectsLogicOnText) {
+  DiagnosticReport report =
+      check("main num V_x, text V_t, text V_u, begin V_x = and(V_t, V_u); "
+            "V_x = or(V_t, V_u); V_x = not(V_t); end");
+
+  ASSERT_EQ(report.errors, 3u);
+  EXPECT_EQ(report.diagnostics[0].message,
+            "logical operator 'and' requires both arguments to be numeric");
+  EXPECT_EQ(report.diagnostics[1].message,
+            "logical operator 'or' requires both arguments to be numeric");
+  EXPECT_EQ(report.diagnostics[2].message,
+            "'not' requires a numeric argument");
+}
+
+TEST(TypeCheckerTest, CapsKeptDiagnostics) {
+  std::string program = "main num V_x, begin ";
+  for (int i = 0; i < 20; i++) {
+    program += "V_x = \"Text\"; ";
+  }
+  program += "end";
+
+  DiagnosticReport report = check(program.c_str(), 5);
+  EXPECT_EQ(report.errors, 20u);
+  EXPECT_EQ(report.diagnostics.size(), 5u);
+  EXPECT_EQ(report.suppressed(), 15u);
+}
+
+TEST(TypeCheckerTest, PrintsPlainDiagnostics) {
+  DiagnosticReport report = check("main begin V_y = 2; end");
+
+  std::ostringstream out;
+  report.print(out, "prog.txt");
+  EXPECT_EQ(out.str(), "prog.txt:1:12: error: undeclared variable 'V_y' "
+                       "assigned a value\n1 error generated\n");
+}
@@ -0,0 +1,175 @@
+#include "corpus.h"
+#include <bytecode.h>
+#include <gtest/gtest.h>
+#include <optimizer.h>
+#include <vm.h>
+
+namespace {
+
+std::string run(const char *source, const std::string &input = "",
+                bool optimized = false) {
+  std::optional<IMCProgram> program = corpus_imc(source);
+  if (!program) {
+    ADD_FAILURE() << "failed to translate " << source;
+    return "";
+  }
+  if (optimized) {
+    optimize(*program);
+  }
+  return ::run(*program, input);
+}
+
+} // namespace
+
+TEST(VMTest, PrintsNumbersAndText) {
+  EXPECT_EQ(run("main num V_x, text V_t, begin V_x = div(sqrt(49), 2); "
+                "V_t = \"Hi\"; print V_x; print V_t; print 10; end"),
+            "3.5\nHi\n10\n");
+}
+
+TEST(VMTest, FollowsBranches) {
+  const char *program =
+      "main num V_x, text V_t, begin V_x <input; V_t = \"Big\"; "
+      "if and(grt(V_x, 10), grt(20, V_x)) then begin print V_t; end "
+      "else begin print \"Small\"; end; "
+      "if eq(V_t, \"Big\") then begin print 1; end else begin print 0; end; "
+      "end";
+  EXPECT_EQ(run(program, "15"), "Big\n1\n");
+  EXPECT_EQ(run(program, "20"), "Small\n1\n");
+  EXPECT_EQ(run(program, "5"), "Small\n1\n");
+}
+
+TEST(VMTest, StopsAtHalt) {
+  EXPECT_EQ(run("main num V_x, begin print 1; halt; print 2; end"), "1\n");
+}
+
+TEST(VMTest, RejectsInputThatIsNotANumber) {
+  std::optional<IMCProgram> program =
+      corpus_imc("main num V_x, begin V_x <input; print V_x; end");
+  ASSERT_TRUE(program);
+  EXPECT_EQ(run(*program, "-2.25"), "-2.25\n");
+  EXPECT_THROW(run(*program, "Hello"), std::runtime_error);
+}
+
+TEST(VMTest, RefusesLogicOnText) {
+  // the type checker never lets this through, so make V_x text afterwards
+  IMCProgram program = generate(
+      "main num V_x, num V_y, begin V_y = not(V_x); print V_y; end");
+  program.variables[0].type = TypeId::Text;
+  EXPECT_THROW(compile_bytecode(program), std::logic_error);
+}
+
+TEST(VMTest, RecursesThroughCalls) {
+  EXPECT_EQ(run(FIBONACCI, "15"), "610\n");
+  EXPECT_EQ(run(FIBONACCI, "20", true), "6765\n");
+}
+
+TEST(VMTest, GivesEachCallItsOwnFrame) {
+  // V_a of the outer call survives the inner one; the global V_g does not
+  EXPECT_EQ(
+      run("main num V_n, num V_g, begin V_g = 0; "
+          "V_n = F_f(V_n, V_n, V_n); print V_n; print V_g; end\n"
+          "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+          "  V_a = add(V_n, 1); V_g = add(V_g, 1);\n"
+          "  if grt(V_n, 2) then begin return V_a; end else begin\n"
+          "  V_b = F_f(V_a, V_a, V_a); end; V_c = add(V_a, V_b);\n"
+          "  return V_c; end } end\n"),
+      // 1 + (2 + (3 + 4)) with four calls
+      "10\n4\n");
+}
+
+TEST(VMTest, KeepsGlobalsOnlyAFunctionMentions) {
+  // main never touches V_g, yet F_f finds it as its last call left it
+  const char *twice =
+      "main num V_n, num V_g, begin V_n = F_f(V_n, V_n, V_n); "
+      "V_n = F_f(V_n, V_n, V_n); print V_n; end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, 1); return V_g; end } end\n";
+  EXPECT_EQ(run(twice), "2\n");
+  EXPECT_EQ(run(twice, "", true), "2\n");
+
+  // once per level of the recursion
+  const char *recursive =
+      "main num V_n, num V_g, begin V_n = F_r(3, 3, 3); print V_n; end\n"
+      "num F_r(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, 1); if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "  V_b = F_r(V_a, V_a, V_a); end else begin skip; end; return V_g; end }"
+      " end\n";
+  EXPECT_EQ(run(recursive), "4\n");
+  EXPECT_EQ(run(recursive, "", true), "4\n");
+}
+
+TEST(VMTest, StoresTailCallResultsInGlobals) {
+  // V_g is only F_f's, but a later call reads it, so storing the result of
+  // F_h into it is work left after the call and no tail call
+  const char *program =
+      "main num V_n, num V_g, num V_x, begin V_n = 4;\n"
+      "  V_x = F_f(V_n, V_n, V_n); V_x = F_f(V_n, V_n, V_n); end\n"
+      "num F_f(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+      "  V_g = add(V_g, V_n); if grt(V_n, 0) then begin V_a = sub(V_n, 1);\n"
+      "  V_g = F_h(V_a, V_a, V_a); return V_g; end\n"
+      "  else begin print V_g; return 0; end; end }\n"
+      "  num F_h(V_a, V_a, V_a) { num V_d, num V_e, num V_f, begin\n"
+      "    V_d = F_f(V_a, V_a, V_a); return V_d; end } end\n"
+      "end\n";
+  EXPECT_EQ(run(program), "10\n10\n");
+  EXPECT_EQ(run(program, "", true), "10\n10\n");
+}
+
+TEST(VMTest, IteratesThroughTailCalls) {
+  // deeper than MAX_DEPTH: F_even and F_odd call each other in tail
+  // position, and so do F_down and F_next, which return nothing
+  const char *program =
+      "main num V_n, num V_r, num V_s, begin V_n <input;\n"
+      "  V_r = F_even(V_n, V_n, V_n); print V_r; F_down(V_n, V_n, V_n); end\n"
+      "num F_even(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+      "  if eq(V_n, 0) then begin return 1; end else begin\n"
+      "  V_a = sub(V_n, 1); V_b = F_odd(V_a, V_a, V_a); return V_b; end;\n"
+      "  end }\n"
+      "  num F_odd(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+      "    if eq(V_n, 0) then begin return 0; end else begin\n"
+      "    V_a = sub(V_n, 1); V_b = F_even(V_a, V_a, V_a); return V_b; end;\n"
+      "    end } end\n"
+      "end\n"
+      "void F_down(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+      "  if grt(V_n, 0) then begin V_a = sub(V_n, 1); F_next(V_a, V_a, V_a);\n"
+      "  end else begin print \"Done\"; end; end }\n"
+      "  void F_next(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+      "    F_down(V_n, V_n, V_n); end } end\n"
+      "end\n";
+  std::string input = std::to_string(VM::MAX_DEPTH + 1);
+  EXPECT_EQ(run(program, input), "0\nDone\n");
+  EXPECT_EQ(run(program, input, true), "0\nDone\n");
+
+  const char *loop =
+      "main num V_n, num V_r, num V_s, begin V_n <input;\n"
+      "  V_r = F_loop(V_n, V_s, V_s); print V_r; end\n"
+      "num F_loop(V_n, V_r, V_s) { num V_a, num V_b, num V_c, begin\n"
+      "  if grt(V_n, 0) then begin V_a = sub(V_n, 1); V_b = add(V_r, 2);\n"
+      "  V_c = F_loop(V_a, V_b, V_b); return V_c; end\n"
+      "  else begin return V_r; end; end } end\n";
+  EXPECT_EQ(run(loop, input), std::to_string(2 * (VM::MAX_DEPTH + 1)) + "\n");
+}
+
+TEST(VMTest, OptimizedProgramsPrintTheSame) {
+  std::size_t translated = 0;
+  for (const std::string &source : corpus_programs()) {
+    std::optional<IMCProgram> plain = corpus_imc(source);
+    std::optional<IMCProgram> optimized = corpus_imc(source);
+    if (!plain) {
+      continue;
+    }
+    translated++;
+    optimize(*optimized);
+
+    std::string expected;
+    try {
+      expected = run(*plain, "3 4 5 6 7 8");
+    } catch (const std::runtime_error &) {
+      EXPECT_THROW(run(*optimized, "3 4 5 6 7 8"), std::runtime_error);
+      continue;
+    }
+    EXPECT_EQ(run(*optimized, "3 4 5 6 7 8"), expected);
+  }
+  EXPECT_GE(translated, CORPUS_WELL_TYPED);
+}
@@ -0,0 +1,105 @@
+// splc_bench: measures how many bytecode instructions per second the VM
+// runs on two bundled SPL programs, one dominated by calls and one by
+// arithmetic. The goal is 50 million per second on one core; build with
+// -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// Usage: splc_bench [<scale>]
+//
+// Exits with status 1 if the goal is missed.
+
+#include <bytecode.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <lexer.h>
+#include <optimizer.h>
+#include <parser.h>
+#include <sstream>
+#include <string>
+#include <vm.h>
+
+namespace {
+
+constexpr double GOAL = 50e6;
+
+// naive Fibonacci: two calls per step, little work in between
+const char *FIBONACCI =
+    "main num V_n, num V_r, begin V_n <input; V_r = F_fib(V_n, V_n, V_n);\n"
+    "  print V_r; end\n"
+    "num F_fib(V_n, V_n, V_n) { num V_a, num V_b, num V_c, begin\n"
+    "  if grt(2, V_n) then begin return V_n; end else begin\n"
+    "    V_a = sub(V_n, 1); V_b = F_fib(V_a, V_a, V_a);\n"
+    "    V_a = sub(V_n, 2); V_c = F_fib(V_a, V_a, V_a);\n"
+    "    V_a = add(V_b, V_c); end; return V_a; end } end\n";
+
+// a long chain of arithmetic, one call per step, run ten times over
+const char *ARITHMETIC =
+    "main num V_n, num V_r, begin V_n <input; V_r = 0;\n"
+    "  V_r = F_step(V_n, V_r, V_r); V_r = F_step(V_n, V_r, V_r);\n"
+    "  V_r = F_step(V_n, V_r, V_r); V_r = F_step(V_n, V_r, V_r);\n"
+    "  V_r = F_step(V_n, V_r, V_r); V_r = F_step(V_n, V_r, V_r);\n"
+    "  V_r = F_step(V_n, V_r, V_r); V_r = F_step(V_n, V_r, V_r);\n"
+    "  V_r = F_step(V_n, V_r, V_r); V_r = F_step(V_n, V_r, V_r);\n"
+    "  print V_r; end\n"
+    "num F_step(V_n, V_r, V_r) { num V_a, num V_b, num V_c, begin\n"
+    "  if grt(V_n, 0) then begin\n"
+    "    V_a = add(V_n, 1); V_b = mul(V_a, 3); V_c = sub(V_b, V_a);\n"
+    "    V_a = div(V_c, 2); V_b = sqrt(V_a); V_c = add(V_b, V_r);\n"
+    "    V_b = mul(V_c, 0.5); V_c = add(V_b, V_c); V_c = div(V_c, 3);\n"
+    "    V_a = sub(V_n, 1); V_c = F_step(V_a, V_c, V_c);\n"
+    "  end else begin V_c = V_r; end; return V_c; end } end\n";
+
+struct Result {
+  uint64_t executed;
+  double seconds;
+};
+
+Result measure(const char *source, const std::string &input) {
+  Lexer lexer(source);
+  Parser parser(lexer);
+  parser.setPrintTree(false);
+  std::unique_ptr<SyntaxTree> tree = parser.parse();
+  if (!tree) {
+    std::cerr << "benchmark program does not parse" << std::endl;
+    std::exit(2);
+  }
+  IMCProgram program = IMCGenerator(tree->getRoot()).generate();
+  optimize(program);
+  Bytecode bytecode = compile_bytecode(program);
+
+  std::istringstream in(input);
+  std::ostringstream out;
+  VM vm(bytecode, in, out);
+  auto start = std::chrono::steady_clock::now();
+  vm.run();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return Result{vm.executed(), elapsed.count()};
+}
+
+} // namespace
+
+int main(int argc, const char **argv) {
+  long scale = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 1;
+  if (scale < 1) {
+    std::cerr << "Usage: splc_bench [<scale>]" << std::endl;
+    return 2;
+  }
+
+  uint64_t executed = 0;
+  double seconds = 0;
+  auto report = [&](const char *name, Result result) {
+    std::cout << name << ": " << result.executed << " instructions in "
+              << result.seconds << " s, "
+              << result.executed / result.seconds / 1e6 << "M/s" << std::endl;
+    executed += result.executed;
+    seconds += result.seconds;
+  };
+  report("fibonacci", measure(FIBONACCI, std::to_string(26 + scale)));
+  report("arithmetic", measure(ARITHMETIC, std::to_string(100000 * scale)));
+
+  double rate = executed / seconds;
+  std::cout << "total: " << rate / 1e6 << "M instructions/s (goal "
+            << GOAL / 1e6 << "M)" << std::endl;
+  return rate >= GOAL ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// splc_tablegen: builds the LALR(1) parse table of the SPL grammar and
+// compiles it into a C++ header of constexpr arrays, so the parser needs no
+// start-up parsing. Optionally also writes the table as CSV in the layout of
+// parse_table.csv.
+//
+// Usage: splc_tablegen <grammar.txt> <output.h> [<output.csv>]
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <lalr.h>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+std::string read_file(const std::string &path) {
+  std::ifstream stream(path);
+  if (!stream.is_open()) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+
+  std::stringstream contents;
+  contents << stream.rdbuf();
+  return contents.str();
+}
+
+void write_file(const std::string &path, const std::string &contents) {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Failed to write " + path);
+  }
+  out << contents;
+}
+
+// C++ identifier for a grammar symbol, used in the generated enum
+std::string enum_name(const std::string &symbol) {
+  static const std::map<std::string, std::string> PUNCTUATION = {
+      {",", "Comma"},  {";", "Semicolon"}, {"(", "LParen"},
+      {")", "RParen"}, {"=", "Assign"},    {"{", "LBrace"},
+      {"}", "RBrace"}, {"$", "EndOfInput"}, {"<input", "Input"},
+  };
+
+  auto punct = PUNCTUATION.find(symbol);
+  if (punct != PUNCTUATION.end()) {
+    return punct->second;
+  }
+
+  std::string name = symbol;
+  name[0] = static_cast<char>(std::toupper(name[0]));
+  return name;
+}
+
+std::string quote(const std::string &text) {
+  std::string result = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result + "\"";
+}
+
+template <typename T>
+void write_array(std::ostream &out, const std::string &type,
+                 const std::string &name, const std::vector<T> &values,
+                 int per_line) {
+  out << "inline constexpr " << type << " " << name << "[] = {";
+  for (std::size_t i = 0; i < values.size(); i++) {
+    out << (i % per_line == 0 ? "\n    " : " ");
+    if constexpr (std::is_integral_v<T>) {
+      out << static_cast<int>(values[i]) << ",";
+    } else {
+      out << values[i] << ",";
+    }
+  }
+  out << "\n};\n\n";
+}
+
+std::string generate_header(const Grammar &grammar,
+                            const CompressedTable &table) {
+  std::vector<std::string> names;
+  for (int symbol = 0; symbol < grammar.symbol_count(); symbol++) {
+    names.push_back(quote(grammar.symbol_name(symbol)));
+  }
+
+  std::vector<uint16_t> rule_lhs, rule_length;
+  for (const auto &rule : grammar.rules()) {
+    rule_lhs.push_back(static_cast<uint16_t>(rule.lhs));
+    rule_length.push_back(static_cast<uint16_t>(rule.rhs.size()));
+  }
+
+  std::ostringstream out;
+  out << "// Generated by splc_tablegen from grammar.txt. Do not edit.\n\n"
+      << "#ifndef SPL_PARSE_TABLE_DATA_H\n"
+      << "#define SPL_PARSE_TABLE_DATA_H\n\n"
+      << "#include <cstdint>\n"
+      << "#include <string_view>\n\n"
+      << "enum class GrammarSymbol : uint16_t {\n";
+  for (int symbol = 0; symbol < grammar.symbol_count(); symbol++) {
+    out << "  " << enum_name(grammar.symbol_name(symbol)) << " = " << symbol
+        << ",\n";
+  }
+  out << "};\n\n"
+      << "namespace parse_table_data {\n\n"
+      << "inline constexpr int TERMINAL_COUNT = " << table.terminal_count
+      << ";\n"
+      << "inline constexpr int NONTERMINAL_COUNT = " << table.nonterminal_count
+      << ";\n"
+      << "inline constexpr int STATE_COUNT = " << table.state_count << ";\n"
+      << "inline constexpr int RULE_COUNT = " << grammar.rules().size()
+      << ";\n\n";
+
+  write_array(out, "std::string_view", "SYMBOLS", names, 8);
+  write_array(out, "int16_t", "ACTION_DEFAULT", table.action_default, 16);
+  write_array(out, "uint16_t", "ACTION_BASE", table.action_base, 16);
+  write_array(out, "int16_t", "ACTION_NEXT", table.action_next, 16);
+  write_array(out, "int16_t", "ACTION_CHECK", table.action_check, 16);
+  write_array(out, "uint16_t", "GOTO_BASE", table.goto_base, 16);
+  write_array(out, "int16_t", "GOTO_NEXT", table.goto_next, 16);
+  write_array(out, "int16_t", "GOTO_CHECK", table.goto_check, 16);
+  write_array(out, "uint16_t", "RULE_LHS", rule_lhs, 16);
+  write_array(out, "uint16_t", "RULE_LENGTH", rule_length, 16);
+
+  out << "} // namespace parse_table_data\n\n"
+      << "#endif\n";
+  return out.str();
+}
+
+} // namespace
+
+int main(int argc, const char **argv) {
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: splc_tablegen <grammar.txt> <output.h> [<output.csv>]"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    Grammar grammar = Grammar::parse(read_file(argv[1]));
+    LalrTable lalr = LalrTable::build(grammar);
+
+    if (!lalr.conflicts().empty()) {
+      for (const auto &conflict : lalr.conflicts()) {
+        std::cerr << argv[1] << ": " << lalr.describe(grammar, conflict)
+                  << std::endl;
+      }
+      std::cerr << "splc_tablegen: grammar is not LALR(1), "
+                << lalr.conflicts().size() << " conflict(s)" << std::endl;
+      return 1;
+    }
+
+    CompressedTable table = CompressedTable::compress(
+        lalr.actions(), lalr.gotos(), grammar.terminal_count(),
+        grammar.nonterminal_count(), lalr.state_count());
+
+    write_file(argv[2], generate_header(grammar, table));
+    if (argc == 4) {
+      write_file(argv[3], lalr.to_csv(grammar));
+    }
+
+    std::cout << "splc_tablegen: " << lalr.state_count() << " states, "
+              << lalr.actions().size() + lalr.gotos().size()
+              << " cells compressed to "
+              << table.action_next.size() + table.goto_next.size() << " entries"
+              << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << "splc_tablegen: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}